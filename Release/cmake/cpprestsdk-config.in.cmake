@@ -7,6 +7,10 @@ if(@CPPREST_USES_BROTLI@)
   find_dependency(unofficial-brotli)
 endif()
 
+if(@CPPREST_USES_ZSTD@)
+  find_dependency(zstd)
+endif()
+
 if(@CPPREST_USES_OPENSSL@)
   find_dependency(OpenSSL)
 endif()
@@ -188,6 +188,13 @@ extern "C"
     _ASYNCRTIMP utility::size64_t __cdecl _get_size(_In_ concurrency::streams::details::_file_info* info,
                                                     size_t char_size);
 
+    /// <summary>
+    /// Get the POSIX file descriptor of the underlying file, for transfers that bypass the stream buffer.
+    /// </summary>
+    /// <param name="info">The file info record of the file</param>
+    /// <returns>The file descriptor, or -1 if the file is closed or the platform has no file descriptors</returns>
+    _ASYNCRTIMP int __cdecl _get_native_fd(_In_ concurrency::streams::details::_file_info* info);
+
     /// <summary>
     /// Adjust the internal buffers and pointers when the application seeks to a new read location in the stream.
     /// </summary>
@@ -105,6 +105,13 @@ public:
         }
     }
 
+    /// <summary>
+    /// Gets the POSIX file descriptor of the underlying file, so that transfers such as <c>sendfile</c> can move its
+    /// bytes without going through the stream buffer. Such transfers must move the read position with <c>seekoff</c>.
+    /// </summary>
+    /// <returns>The file descriptor, or -1 if the file is closed or the platform has no file descriptors.</returns>
+    int _native_fd() const { return _get_native_fd(m_info); }
+
 protected:
     /// <summary>
     /// <c>can_seek</c> is used to determine whether a stream buffer supports seeking.
@@ -52,6 +52,7 @@ typedef void* native_handle;
 #include "cpprest/uri.h"
 #include "pplx/pplxtasks.h"
 #include <limits>
+#include <map>
 #include <memory>
 
 #if _WIN32_WINNT >= _WIN32_WINNT_VISTA
@@ -86,6 +87,698 @@ namespace client
 using web::credentials;
 using web::web_proxy;
 
+/// <summary>
+/// Retry and hedging settings for an http_client, used with <see cref="http_client_config::set_retry_policy" />.
+/// </summary>
+/// <remarks>
+/// Requests whose method is idempotent per RFC 7231 are retried after transport errors and after responses with one
+/// of the retryable status codes; other requests are only retried when no connection could be made. Each retry waits
+/// for an exponential backoff with full jitter, or longer if the server sent a Retry-After header. Retries and hedged
+/// attempts draw on a budget that is refilled by a fraction of a retry for every request, which keeps them a bounded
+/// share of the traffic during an outage. The request body is read once and replayed from memory for every attempt.
+/// </remarks>
+class retry_policy
+{
+public:
+    retry_policy()
+        : m_max_attempts(1)
+        , m_initial_backoff(100)
+        , m_max_backoff(10000)
+        , m_backoff_multiplier(2.0)
+        , m_retry_budget_ratio(0.2)
+        , m_retry_budget_reserve(10)
+        , m_retry_non_idempotent(false)
+        , m_retry_status_codes {status_codes::TooManyRequests,
+                                status_codes::BadGateway,
+                                status_codes::ServiceUnavailable,
+                                status_codes::GatewayTimeout}
+        , m_hedging(false)
+        , m_hedge_delay(50)
+    {
+    }
+
+    /// <summary>
+    /// Get the maximum number of attempts for a request, including the first.
+    /// </summary>
+    /// <returns>The maximum number of attempts; 1, the default, disables retries.</returns>
+    size_t max_attempts() const { return m_max_attempts; }
+
+    /// <summary>
+    /// Set the maximum number of attempts for a request, including the first.
+    /// </summary>
+    /// <param name="max_attempts">The maximum number of attempts; 1 disables retries.</param>
+    void set_max_attempts(size_t max_attempts) { m_max_attempts = max_attempts; }
+
+    /// <summary>
+    /// Get the upper bound of the backoff before the first retry.
+    /// </summary>
+    /// <returns>The initial backoff.</returns>
+    const std::chrono::milliseconds& initial_backoff() const { return m_initial_backoff; }
+
+    /// <summary>
+    /// Get the upper bound of the backoff before any retry; a Retry-After header asking for more ends the retries.
+    /// </summary>
+    /// <returns>The maximum backoff.</returns>
+    const std::chrono::milliseconds& max_backoff() const { return m_max_backoff; }
+
+    /// <summary>
+    /// Get the factor by which the backoff bound grows with each retry.
+    /// </summary>
+    /// <returns>The backoff multiplier.</returns>
+    double backoff_multiplier() const { return m_backoff_multiplier; }
+
+    /// <summary>
+    /// Set the exponential backoff parameters; the delay before retry n is uniformly distributed between zero and
+    /// min(max_backoff, initial_backoff * multiplier^(n-1)).
+    /// </summary>
+    /// <param name="initial_backoff">The upper bound of the backoff before the first retry.</param>
+    /// <param name="max_backoff">The upper bound of the backoff before any retry.</param>
+    /// <param name="multiplier">The factor by which the bound grows with each retry.</param>
+    void set_backoff(const std::chrono::milliseconds& initial_backoff,
+                     const std::chrono::milliseconds& max_backoff,
+                     double multiplier = 2.0)
+    {
+        m_initial_backoff = initial_backoff;
+        m_max_backoff = max_backoff;
+        m_backoff_multiplier = multiplier;
+    }
+
+    /// <summary>
+    /// Get the fraction of a retry that each request adds to the retry budget.
+    /// </summary>
+    /// <returns>The retry budget ratio.</returns>
+    double retry_budget_ratio() const { return m_retry_budget_ratio; }
+
+    /// <summary>
+    /// Get the maximum number of retries the budget can hold, which is also its initial balance.
+    /// </summary>
+    /// <returns>The retry budget reserve.</returns>
+    size_t retry_budget_reserve() const { return m_retry_budget_reserve; }
+
+    /// <summary>
+    /// Set the retry budget, shared by all requests sent through the client.
+    /// </summary>
+    /// <param name="ratio">The fraction of a retry that each request adds to the budget.</param>
+    /// <param name="reserve">The maximum number of retries the budget can hold, which is also its initial
+    /// balance.</param>
+    void set_retry_budget(double ratio, size_t reserve)
+    {
+        m_retry_budget_ratio = ratio;
+        m_retry_budget_reserve = reserve;
+    }
+
+    /// <summary>
+    /// Checks whether requests with non-idempotent methods, such as POST, are retried like idempotent ones.
+    /// </summary>
+    /// <returns>True if non-idempotent requests are retried after any error, false otherwise.</returns>
+    bool retry_non_idempotent() const { return m_retry_non_idempotent; }
+
+    /// <summary>
+    /// Sets whether requests with non-idempotent methods, such as POST, are retried like idempotent ones.
+    /// </summary>
+    /// <param name="retry_non_idempotent">True if the server tolerates the same request being processed more than
+    /// once, false otherwise.</param>
+    void set_retry_non_idempotent(bool retry_non_idempotent) { m_retry_non_idempotent = retry_non_idempotent; }
+
+    /// <summary>
+    /// Get the response status codes after which a request is retried.
+    /// </summary>
+    /// <returns>The retryable status codes.</returns>
+    const std::vector<status_code>& retry_status_codes() const { return m_retry_status_codes; }
+
+    /// <summary>
+    /// Set the response status codes after which a request is retried.
+    /// </summary>
+    /// <param name="codes">The retryable status codes.</param>
+    void set_retry_status_codes(std::vector<status_code> codes) { m_retry_status_codes = std::move(codes); }
+
+    /// <summary>
+    /// Checks whether idempotent requests are hedged.
+    /// </summary>
+    /// <returns>True if hedging is enabled, false otherwise.</returns>
+    bool hedging() const { return m_hedging; }
+
+    /// <summary>
+    /// Get the minimum delay before a hedged attempt is sent.
+    /// </summary>
+    /// <returns>The minimum hedge delay.</returns>
+    const std::chrono::milliseconds& hedge_delay() const { return m_hedge_delay; }
+
+    /// <summary>
+    /// Sets whether idempotent requests are hedged: if no response has arrived after the 95th percentile of recent
+    /// response times, a second attempt is sent, and whichever attempt responds second is canceled.
+    /// </summary>
+    /// <param name="hedging">True to enable hedging, false otherwise.</param>
+    /// <param name="min_delay">The minimum delay before the second attempt, which is also used until enough response
+    /// times have been observed.</param>
+    /// <remarks>Hedged attempts draw on the retry budget. Requests with a caller-supplied response stream are not
+    /// hedged.</remarks>
+    void set_hedging(bool hedging, const std::chrono::milliseconds& min_delay = std::chrono::milliseconds(50))
+    {
+        m_hedging = hedging;
+        m_hedge_delay = min_delay;
+    }
+
+    /// <summary>
+    /// Checks whether the policy can send more than one attempt for a request.
+    /// </summary>
+    /// <returns>True if retries or hedging are enabled, false otherwise.</returns>
+    bool enabled() const { return m_max_attempts > 1 || m_hedging; }
+
+private:
+    size_t m_max_attempts;
+    std::chrono::milliseconds m_initial_backoff;
+    std::chrono::milliseconds m_max_backoff;
+    double m_backoff_multiplier;
+    double m_retry_budget_ratio;
+    size_t m_retry_budget_reserve;
+    bool m_retry_non_idempotent;
+    std::vector<status_code> m_retry_status_codes;
+    bool m_hedging;
+    std::chrono::milliseconds m_hedge_delay;
+};
+
+/// <summary>
+/// Load balancing settings for an http_client whose requests are spread across several replicas of a service, used
+/// with <see cref="http_client_config::set_load_balancing" />.
+/// </summary>
+/// <remarks>
+/// The client's base URI names the service: it supplies the scheme, the Host header and the name that TLS
+/// certificates are verified against, while each request connects to the host and port of one of the endpoints.
+/// Connections are pooled per endpoint. An endpoint which fails to accept connections a number of times in a row is
+/// ejected for a while, and its pooled connections are dropped; when every endpoint is ejected, all of them are
+/// eligible again.
+/// </remarks>
+class load_balancing_policy
+{
+public:
+    /// <summary>
+    /// How an endpoint is picked for each request.
+    /// </summary>
+    enum class selection
+    {
+        /// <summary>Each endpoint in turn.</summary>
+        round_robin,
+        /// <summary>The endpoint with the fewest requests in flight.</summary>
+        least_outstanding,
+        /// <summary>The better of two random endpoints, weighing the requests in flight by an exponentially
+        /// weighted moving average of the endpoint's response time.</summary>
+        power_of_two_choices
+    };
+
+    load_balancing_policy()
+        : m_selection(selection::round_robin), m_ejection_threshold(3), m_ejection_duration(std::chrono::seconds(30))
+    {
+    }
+
+    /// <summary>
+    /// Get the endpoints which requests are spread across.
+    /// </summary>
+    /// <returns>The endpoints; empty if every request goes to the base URI.</returns>
+    const std::vector<uri>& endpoints() const { return m_endpoints; }
+
+    /// <summary>
+    /// Set the endpoints which requests are spread across.
+    /// </summary>
+    /// <param name="endpoints">URIs giving the host and port of each endpoint; their other components are
+    /// ignored.</param>
+    void set_endpoints(std::vector<uri> endpoints) { m_endpoints = std::move(endpoints); }
+
+    /// <summary>
+    /// Get how an endpoint is picked for each request.
+    /// </summary>
+    /// <returns>The selection strategy.</returns>
+    selection strategy() const { return m_selection; }
+
+    /// <summary>
+    /// Set how an endpoint is picked for each request.
+    /// </summary>
+    /// <param name="strategy">The selection strategy.</param>
+    void set_strategy(selection strategy) { m_selection = strategy; }
+
+    /// <summary>
+    /// Get the number of consecutive connection failures after which an endpoint is ejected.
+    /// </summary>
+    /// <returns>The ejection threshold.</returns>
+    size_t ejection_threshold() const { return m_ejection_threshold; }
+
+    /// <summary>
+    /// Get how long an ejected endpoint receives no requests.
+    /// </summary>
+    /// <returns>The ejection duration.</returns>
+    const std::chrono::milliseconds& ejection_duration() const { return m_ejection_duration; }
+
+    /// <summary>
+    /// Set when and for how long endpoints are ejected.
+    /// </summary>
+    /// <param name="threshold">The number of consecutive connection failures after which an endpoint is ejected;
+    /// zero never ejects endpoints.</param>
+    /// <param name="duration">How long an ejected endpoint receives no requests. Once it has passed, a single
+    /// further failure ejects the endpoint again, while a response resets its count.</param>
+    void set_ejection(size_t threshold, const std::chrono::milliseconds& duration)
+    {
+        m_ejection_threshold = threshold;
+        m_ejection_duration = duration;
+    }
+
+    /// <summary>
+    /// Checks whether requests are spread across endpoints.
+    /// </summary>
+    /// <returns>True if any endpoints are set, false otherwise.</returns>
+    bool enabled() const { return !m_endpoints.empty(); }
+
+private:
+    std::vector<uri> m_endpoints;
+    selection m_selection;
+    size_t m_ejection_threshold;
+    std::chrono::milliseconds m_ejection_duration;
+};
+
+/// <summary>
+/// Limits on the rate and the concurrency of requests, applied by a <see cref="rate_limiter" />.
+/// </summary>
+/// <remarks>
+/// The rate is limited by a token bucket holding up to a burst of tokens, which is refilled at the configured rate;
+/// every request takes one token. The concurrency is limited to a number of requests in flight, from sending the
+/// request until its response headers arrive. The limit is either fixed, or adapted to the responses by additive
+/// increase, multiplicative decrease (AIMD): each successful response raises it by one divided by the limit, while
+/// each response with status 429 or 503, and each timeout, lowers it to 90 percent. Requests over a limit wait in a
+/// queue; once the queue is full, further requests over a limit fail with an http_exception.
+/// </remarks>
+class rate_limit_policy
+{
+public:
+    rate_limit_policy()
+        : m_requests_per_second(0)
+        , m_burst(1)
+        , m_min_in_flight(0)
+        , m_max_in_flight(0)
+        , m_max_queue((std::numeric_limits<size_t>::max)())
+    {
+    }
+
+    /// <summary>
+    /// Get the rate at which the token bucket is refilled.
+    /// </summary>
+    /// <returns>The sustained number of requests per second; zero if the rate is not limited.</returns>
+    double requests_per_second() const { return m_requests_per_second; }
+
+    /// <summary>
+    /// Get the number of tokens the bucket holds, which may be spent in a burst.
+    /// </summary>
+    /// <returns>The bucket size.</returns>
+    size_t burst() const { return m_burst; }
+
+    /// <summary>
+    /// Set the token bucket limiting the rate of requests.
+    /// </summary>
+    /// <param name="requests_per_second">The sustained number of requests per second; zero does not limit the
+    /// rate.</param>
+    /// <param name="burst">The number of tokens the bucket holds, at least one.</param>
+    void set_rate(double requests_per_second, size_t burst = 1)
+    {
+        m_requests_per_second = requests_per_second;
+        m_burst = (std::max)(burst, static_cast<size_t>(1));
+    }
+
+    /// <summary>
+    /// Get the smallest limit of requests in flight that the adaptive limit is lowered to.
+    /// </summary>
+    /// <returns>The minimum limit; equal to the maximum if the limit is fixed.</returns>
+    size_t min_in_flight() const { return m_min_in_flight; }
+
+    /// <summary>
+    /// Get the limit of requests in flight, or the largest limit that the adaptive limit is raised to.
+    /// </summary>
+    /// <returns>The maximum limit; zero if the concurrency is not limited.</returns>
+    size_t max_in_flight() const { return m_max_in_flight; }
+
+    /// <summary>
+    /// Checks whether the limit of requests in flight adapts to the responses.
+    /// </summary>
+    /// <returns>True if the limit adapts, false if it is fixed.</returns>
+    bool adaptive_concurrency() const { return m_min_in_flight < m_max_in_flight; }
+
+    /// <summary>
+    /// Set a fixed limit of requests in flight.
+    /// </summary>
+    /// <param name="max_in_flight">The limit; zero does not limit the concurrency.</param>
+    void set_max_in_flight(size_t max_in_flight)
+    {
+        m_min_in_flight = max_in_flight;
+        m_max_in_flight = max_in_flight;
+    }
+
+    /// <summary>
+    /// Set a limit of requests in flight which starts at the maximum and adapts to the responses between the
+    /// minimum and the maximum.
+    /// </summary>
+    /// <param name="min_in_flight">The smallest limit, at least one.</param>
+    /// <param name="max_in_flight">The largest limit.</param>
+    void set_adaptive_concurrency(size_t min_in_flight, size_t max_in_flight)
+    {
+        m_min_in_flight = (std::max)(min_in_flight, static_cast<size_t>(1));
+        m_max_in_flight = (std::max)(max_in_flight, m_min_in_flight);
+    }
+
+    /// <summary>
+    /// Get the number of requests which may wait for a token or for a request in flight to complete.
+    /// </summary>
+    /// <returns>The queue length; unbounded by default.</returns>
+    size_t max_queue() const { return m_max_queue; }
+
+    /// <summary>
+    /// Set the number of requests which may wait for a token or for a request in flight to complete.
+    /// </summary>
+    /// <param name="max_queue">The queue length; zero fails every request over a limit at once.</param>
+    void set_max_queue(size_t max_queue) { m_max_queue = max_queue; }
+
+private:
+    double m_requests_per_second;
+    size_t m_burst;
+    size_t m_min_in_flight;
+    size_t m_max_in_flight;
+    size_t m_max_queue;
+};
+
+namespace details
+{
+class rate_limiter_impl;
+}
+
+/// <summary>
+/// Applies a <see cref="rate_limit_policy" /> to the requests of the clients it is set on with
+/// <see cref="http_client_config::set_rate_limiter" />.
+/// </summary>
+/// <remarks>A limiter set on one client limits that client; a limiter shared by the clients of a host limits the
+/// host. A request which finds a token and a free slot, with no other request waiting, passes without taking a
+/// lock.</remarks>
+class rate_limiter
+{
+public:
+    /// <summary>
+    /// Creates a limiter applying the policy.
+    /// </summary>
+    /// <param name="policy">The limits to apply.</param>
+    _ASYNCRTIMP rate_limiter(const rate_limit_policy& policy);
+
+    /// <summary>
+    /// Get the limits applied.
+    /// </summary>
+    /// <returns>The policy.</returns>
+    _ASYNCRTIMP const rate_limit_policy& policy() const;
+
+    /// <summary>
+    /// Get the number of requests waiting for a token or for a request in flight to complete.
+    /// </summary>
+    /// <returns>The queue depth.</returns>
+    _ASYNCRTIMP size_t queue_depth() const;
+
+    /// <summary>
+    /// Get the number of requests sent and awaiting their response headers.
+    /// </summary>
+    /// <returns>The requests in flight.</returns>
+    _ASYNCRTIMP size_t in_flight() const;
+
+    /// <summary>
+    /// Get the current limit of requests in flight.
+    /// </summary>
+    /// <returns>The limit, which changes over time if it is adaptive; zero if the concurrency is not
+    /// limited.</returns>
+    _ASYNCRTIMP size_t concurrency_limit() const;
+
+    /// <summary>
+    /// Get the number of requests failed because the queue was full.
+    /// </summary>
+    /// <returns>The rejected requests.</returns>
+    _ASYNCRTIMP size_t rejected() const;
+
+    /// <summary>
+    /// Gets the implementation, which the pipeline stage of each client uses.
+    /// </summary>
+    const std::shared_ptr<details::rate_limiter_impl>& _get_impl() const { return m_impl; }
+
+private:
+    std::shared_ptr<details::rate_limiter_impl> m_impl;
+};
+
+/// <summary>
+/// The state of the circuit of a <see cref="circuit_breaker" /> to one host.
+/// </summary>
+enum class circuit_state
+{
+    /// <summary>Requests are sent, and their outcomes recorded.</summary>
+    closed,
+    /// <summary>Requests fail at once, without being sent.</summary>
+    open,
+    /// <summary>A few trial requests are sent, to decide whether to close the circuit again.</summary>
+    half_open
+};
+
+/// <summary>
+/// When a <see cref="circuit_breaker" /> opens the circuit to a host, and when it tries the host again.
+/// </summary>
+/// <remarks>
+/// The outcomes of the most recent requests to each host are kept in a window. A request fails if it throws, if its
+/// response has a 5xx status code, or if its response headers take longer than the slow call duration to arrive;
+/// once the window holds the minimum number of requests and the rate of failures reaches the threshold, the circuit
+/// opens. After the open duration, the next requests are sent as trials: the circuit closes once they all succeed,
+/// and opens again as soon as one fails.
+/// </remarks>
+class circuit_breaker_policy
+{
+public:
+    circuit_breaker_policy()
+        : m_failure_rate_threshold(0.5)
+        , m_window_size(20)
+        , m_minimum_requests(10)
+        , m_slow_call_duration(0)
+        , m_open_duration(std::chrono::seconds(30))
+        , m_half_open_requests(1)
+    {
+    }
+
+    /// <summary>
+    /// Get the rate of failed requests in the window at which the circuit opens.
+    /// </summary>
+    /// <returns>The failure rate, between zero and one.</returns>
+    double failure_rate_threshold() const { return m_failure_rate_threshold; }
+
+    /// <summary>
+    /// Set the rate of failed requests in the window at which the circuit opens.
+    /// </summary>
+    /// <param name="threshold">The failure rate, between zero and one.</param>
+    void set_failure_rate_threshold(double threshold) { m_failure_rate_threshold = threshold; }
+
+    /// <summary>
+    /// Get the number of most recent requests to a host whose outcomes are kept.
+    /// </summary>
+    /// <returns>The window size.</returns>
+    size_t window_size() const { return m_window_size; }
+
+    /// <summary>
+    /// Set the number of most recent requests to a host whose outcomes are kept.
+    /// </summary>
+    /// <param name="size">The window size, at least one.</param>
+    void set_window_size(size_t size) { m_window_size = (std::max)(size, static_cast<size_t>(1)); }
+
+    /// <summary>
+    /// Get the number of requests the window has to hold before the failure rate may open the circuit.
+    /// </summary>
+    /// <returns>The minimum number of requests.</returns>
+    size_t minimum_requests() const { return m_minimum_requests; }
+
+    /// <summary>
+    /// Set the number of requests the window has to hold before the failure rate may open the circuit.
+    /// </summary>
+    /// <param name="count">The minimum number of requests, capped by the window size.</param>
+    void set_minimum_requests(size_t count) { m_minimum_requests = count; }
+
+    /// <summary>
+    /// Get the time after which a request still awaiting its response headers counts as failed.
+    /// </summary>
+    /// <returns>The slow call duration; zero if slow requests do not fail.</returns>
+    std::chrono::milliseconds slow_call_duration() const { return m_slow_call_duration; }
+
+    /// <summary>
+    /// Set the time after which a request still awaiting its response headers counts as failed.
+    /// </summary>
+    /// <param name="duration">The slow call duration; zero if slow requests do not fail.</param>
+    void set_slow_call_duration(std::chrono::milliseconds duration) { m_slow_call_duration = duration; }
+
+    /// <summary>
+    /// Get the time the circuit stays open before trial requests are sent.
+    /// </summary>
+    /// <returns>The open duration.</returns>
+    std::chrono::milliseconds open_duration() const { return m_open_duration; }
+
+    /// <summary>
+    /// Set the time the circuit stays open before trial requests are sent.
+    /// </summary>
+    /// <param name="duration">The open duration.</param>
+    void set_open_duration(std::chrono::milliseconds duration) { m_open_duration = duration; }
+
+    /// <summary>
+    /// Get the number of trial requests which have to succeed to close the circuit.
+    /// </summary>
+    /// <returns>The number of trial requests.</returns>
+    size_t half_open_requests() const { return m_half_open_requests; }
+
+    /// <summary>
+    /// Set the number of trial requests which have to succeed to close the circuit.
+    /// </summary>
+    /// <param name="count">The number of trial requests, at least one.</param>
+    void set_half_open_requests(size_t count) { m_half_open_requests = (std::max)(count, static_cast<size_t>(1)); }
+
+    /// <summary>
+    /// Get the callback told when the circuit to a host changes state.
+    /// </summary>
+    /// <returns>The callback, called with the host and the new state.</returns>
+    const std::function<void(const utility::string_t&, circuit_state)>& state_callback() const
+    {
+        return m_state_callback;
+    }
+
+    /// <summary>
+    /// Set the callback told when the circuit to a host changes state.
+    /// </summary>
+    /// <param name="callback">The callback, called with the host, as "host:port", and the new state.</param>
+    /// <remarks>The callback is called on the thread which completed the request causing the change, and must not
+    /// block.</remarks>
+    void set_state_callback(const std::function<void(const utility::string_t&, circuit_state)>& callback)
+    {
+        m_state_callback = callback;
+    }
+
+private:
+    double m_failure_rate_threshold;
+    size_t m_window_size;
+    size_t m_minimum_requests;
+    std::chrono::milliseconds m_slow_call_duration;
+    std::chrono::milliseconds m_open_duration;
+    size_t m_half_open_requests;
+    std::function<void(const utility::string_t&, circuit_state)> m_state_callback;
+};
+
+namespace details
+{
+class circuit_breaker_impl;
+}
+
+/// <summary>
+/// Applies a <see cref="circuit_breaker_policy" /> to the requests of the clients it is set on with
+/// <see cref="http_client_config::set_circuit_breaker" />, keeping a circuit for each host.
+/// </summary>
+/// <remarks>While the circuit to a host is open, requests to it fail at once with an http_exception, instead of
+/// waiting for the host to time out.</remarks>
+class circuit_breaker
+{
+public:
+    /// <summary>
+    /// Creates a circuit breaker applying the policy.
+    /// </summary>
+    /// <param name="policy">When to open and close the circuits.</param>
+    _ASYNCRTIMP circuit_breaker(const circuit_breaker_policy& policy);
+
+    /// <summary>
+    /// Get the policy applied.
+    /// </summary>
+    /// <returns>The policy.</returns>
+    _ASYNCRTIMP const circuit_breaker_policy& policy() const;
+
+    /// <summary>
+    /// Get the state of the circuit to a host.
+    /// </summary>
+    /// <param name="host">The host, as "host:port".</param>
+    /// <returns>The state; closed if no request was sent to the host.</returns>
+    _ASYNCRTIMP circuit_state state(const utility::string_t& host) const;
+
+    /// <summary>
+    /// Get the number of requests failed at once because the circuit to their host was open.
+    /// </summary>
+    /// <returns>The rejected requests.</returns>
+    _ASYNCRTIMP size_t rejected() const;
+
+    /// <summary>
+    /// Gets the implementation, which the pipeline stage of each client uses.
+    /// </summary>
+    const std::shared_ptr<details::circuit_breaker_impl>& _get_impl() const { return m_impl; }
+
+private:
+    std::shared_ptr<details::circuit_breaker_impl> m_impl;
+};
+
+/// <summary>
+/// Counts of the pooled connections of an http_client to one host, and of how requests obtained them.
+/// </summary>
+struct connection_pool_host_statistics
+{
+    connection_pool_host_statistics()
+        : idle(0)
+        , in_use(0)
+        , total(0)
+        , acquires(0)
+        , reuses(0)
+        , new_connections(0)
+        , stale_evictions(0)
+        , server_closes(0)
+        , wait_time(0)
+    {
+    }
+
+    /// <summary>
+    /// Connections waiting in the pool for a request.
+    /// </summary>
+    size_t idle;
+
+    /// <summary>
+    /// Connections carrying a request.
+    /// </summary>
+    size_t in_use;
+
+    /// <summary>
+    /// Open connections, idle or in use.
+    /// </summary>
+    size_t total;
+
+    /// <summary>
+    /// Requests which asked the pool for a connection.
+    /// </summary>
+    size_t acquires;
+
+    /// <summary>
+    /// Requests which were given an idle connection from the pool.
+    /// </summary>
+    size_t reuses;
+
+    /// <summary>
+    /// Connections opened because the pool had none idle, or to retry another address of the host.
+    /// </summary>
+    size_t new_connections;
+
+    /// <summary>
+    /// Idle connections closed because no request used them for a cleanup interval.
+    /// </summary>
+    size_t stale_evictions;
+
+    /// <summary>
+    /// Connections closed after a response because the server would not keep them alive, as with Connection: close.
+    /// </summary>
+    size_t server_closes;
+
+    /// <summary>
+    /// Total time requests waited from asking for a connection until it was connected.
+    /// </summary>
+    std::chrono::microseconds wait_time;
+};
+
+/// <summary>
+/// Statistics of an http_client's connection pool, keyed by the host:port connections go to, followed by a '/' and
+/// the host name TLS certificates are verified against. Connections through a proxy are keyed by the proxy and
+/// the target as proxy&gt;target, and connections over a Unix domain socket by unix:path.
+/// </summary>
+typedef std::map<utility::string_t, connection_pool_host_statistics> connection_pool_statistics;
+
 /// <summary>
 /// HTTP client configuration class, used to set the possible configuration options
 /// used to create an http_client instance.
@@ -97,6 +790,11 @@ public:
         : m_guarantee_order(false)
         , m_timeout(std::chrono::seconds(30))
         , m_chunksize(0)
+        , m_adaptive_chunksize(false)
+        , m_min_chunksize(4 * 1024)
+        , m_max_chunksize(1024 * 1024)
+        , m_expect_continue(false)
+        , m_expect_continue_timeout(std::chrono::seconds(1))
         , m_request_compressed(false)
 #if !defined(__cplusplus_winrt)
         , m_validate_certificates(true)
@@ -109,6 +807,19 @@ public:
 #endif
         , m_max_redirects(10)
         , m_https_to_http_redirects(false)
+        , m_retry_policy()
+        , m_load_balancing()
+        , m_unix_socket_path()
+        , m_pool_statistics_interval(std::chrono::seconds(10))
+        , m_rate_limiter()
+        , m_circuit_breaker()
+        , m_coalesce_requests(false)
+        , m_coalesce_headers {header_names::accept,
+                              header_names::accept_encoding,
+                              header_names::accept_language,
+                              header_names::authorization,
+                              _XPLATSTR("Cookie")}
+        , m_response_cache_size(0)
     {
     }
 
@@ -230,6 +941,83 @@ public:
     /// <returns>True if default, false if set by user.</returns>
     bool is_default_chunksize() const { return m_chunksize == 0; }
 
+    /// <summary>
+    /// Checks if the chunk size adapts to the transfers seen on each connection, the default is off.
+    /// </summary>
+    /// <returns>True if the chunk size is adaptive, false if chunksize() is always used.</returns>
+    bool adaptive_chunksize() const { return m_adaptive_chunksize; }
+
+    /// <summary>
+    /// Get the smallest chunk size an adaptive connection shrinks to.
+    /// </summary>
+    /// <returns>The lower bound of the adaptive chunk size.</returns>
+    size_t min_chunksize() const { return m_min_chunksize; }
+
+    /// <summary>
+    /// Get the largest chunk size an adaptive connection grows to.
+    /// </summary>
+    /// <returns>The upper bound of the adaptive chunk size.</returns>
+    size_t max_chunksize() const { return m_max_chunksize; }
+
+    /// <summary>
+    /// Sets whether the chunk size adapts to the transfers seen on each connection.
+    /// </summary>
+    /// <param name="adaptive">True to adapt the chunk size, false to always use chunksize().</param>
+    /// <param name="min_size">The smallest chunk size a connection shrinks to.</param>
+    /// <param name="max_size">The largest chunk size a connection grows to.</param>
+    /// <remarks>Each connection starts at chunksize(). The size doubles while reads and writes fill the buffer with as
+    /// much again ready on the socket or request stream, and halves after messages using less than a quarter of it.
+    /// The size is kept with the connection while it is pooled. This is a hint -- an implementation may disregard the
+    /// setting.</remarks>
+    void set_adaptive_chunksize(bool adaptive, size_t min_size = 4 * 1024, size_t max_size = 1024 * 1024)
+    {
+        m_adaptive_chunksize = adaptive;
+        m_min_chunksize = min_size;
+        m_max_chunksize = max_size;
+    }
+
+    /// <summary>
+    /// Get the TCP settings applied to each connection.
+    /// </summary>
+    /// <returns>The socket options.</returns>
+    const http::socket_options& socket_options() const { return m_socket_options; }
+
+    /// <summary>
+    /// Sets the TCP settings applied to each connection.
+    /// </summary>
+    /// <param name="options">The socket options.</param>
+    /// <remarks>The options are applied before each connection is established. This is only supported by the
+    /// asio-based client.</remarks>
+    void set_socket_options(const http::socket_options& options) { m_socket_options = options; }
+
+    /// <summary>
+    /// Checks if request bodies are held back until the server accepts the request, the default is off.
+    /// </summary>
+    /// <returns>True if requests with a body send Expect: 100-continue, false otherwise.</returns>
+    bool expect_continue() const { return m_expect_continue; }
+
+    /// <summary>
+    /// Get how long a request waits for the server's interim response before sending its body anyway.
+    /// </summary>
+    /// <returns>The interim response timeout.</returns>
+    const std::chrono::milliseconds& expect_continue_timeout() const { return m_expect_continue_timeout; }
+
+    /// <summary>
+    /// Sets whether requests with a body send Expect: 100-continue, and only send the body once the server accepts.
+    /// </summary>
+    /// <param name="expect_continue">True to wait for an interim 100 Continue response before sending bodies, false
+    /// to send bodies straight after the headers.</param>
+    /// <param name="timeout">How long to wait for the interim response before sending the body anyway.</param>
+    /// <remarks>A final response received instead, such as a 401, a 413 or a redirect, completes the request without
+    /// sending the body, and the connection is closed rather than pooled. Requests whose headers already include
+    /// Expect: 100-continue wait the same way. This is only supported by the asio-based client.</remarks>
+    void set_expect_continue(bool expect_continue,
+                             const std::chrono::milliseconds& timeout = std::chrono::seconds(1))
+    {
+        m_expect_continue = expect_continue;
+        m_expect_continue_timeout = timeout;
+    }
+
     /// <summary>
     /// Checks if requesting a compressed response using Content-Encoding is turned on, the default is off.
     /// </summary>
@@ -313,6 +1101,153 @@ public:
         m_https_to_http_redirects = https_to_http_redirects;
     }
 
+    /// <summary>
+    /// Get the retry and hedging policy.
+    /// </summary>
+    /// <returns>The retry policy; by default requests are sent once.</returns>
+    const http::client::retry_policy& retry_policy() const { return m_retry_policy; }
+
+    /// <summary>
+    /// Set the retry and hedging policy.
+    /// </summary>
+    /// <param name="policy">The retry policy.</param>
+    void set_retry_policy(const http::client::retry_policy& policy) { m_retry_policy = policy; }
+
+    /// <summary>
+    /// Get the load balancing settings.
+    /// </summary>
+    /// <returns>The load balancing policy.</returns>
+    const http::client::load_balancing_policy& load_balancing() const { return m_load_balancing; }
+
+    /// <summary>
+    /// Set the load balancing settings, which spread requests across several endpoints serving the base URI.
+    /// </summary>
+    /// <param name="policy">The load balancing policy.</param>
+    /// <remarks>This is only supported by the asio-based client, and endpoints are not used when a proxy is
+    /// configured.</remarks>
+    void set_load_balancing(const http::client::load_balancing_policy& policy) { m_load_balancing = policy; }
+
+    /// <summary>
+    /// Get the path of the Unix domain socket requests are sent over.
+    /// </summary>
+    /// <returns>The socket path, or an empty string if requests connect to the host of the base URI.</returns>
+    const utility::string_t& unix_socket_path() const { return m_unix_socket_path; }
+
+    /// <summary>
+    /// Set the path of a Unix domain socket to send requests over instead of connecting to the host of the base URI.
+    /// The base URI still supplies the Host header and the request path.
+    /// </summary>
+    /// <param name="path">The socket path, or an empty string to connect over TCP.</param>
+    /// <remarks>This is only supported by the asio-based client on platforms with Unix domain sockets. The proxy and
+    /// the load balancing endpoints are not used when a socket path is set.</remarks>
+    void set_unix_socket_path(const utility::string_t& path) { m_unix_socket_path = path; }
+
+    /// <summary>
+    /// Get the callback which the connection pool statistics are pushed to.
+    /// </summary>
+    /// <returns>The callback, empty if the statistics are only read through http_client::pool_statistics.</returns>
+    const std::function<void(const connection_pool_statistics&)>& pool_statistics_callback() const
+    {
+        return m_pool_statistics_callback;
+    }
+
+    /// <summary>
+    /// Get how often the connection pool statistics are pushed to the callback.
+    /// </summary>
+    /// <returns>The interval between two calls of the callback.</returns>
+    std::chrono::milliseconds pool_statistics_interval() const { return m_pool_statistics_interval; }
+
+    /// <summary>
+    /// Set a callback which is periodically passed the statistics of the client's connection pool.
+    /// </summary>
+    /// <param name="callback">The callback, or an empty function to not push the statistics.</param>
+    /// <param name="interval">How often the callback is called.</param>
+    /// <remarks>This is only supported by the asio-based client. The callback is called on a thread pool thread
+    /// for as long as the client exists, and should return quickly.</remarks>
+    void set_pool_statistics_callback(const std::function<void(const connection_pool_statistics&)>& callback,
+                                      std::chrono::milliseconds interval = std::chrono::seconds(10))
+    {
+        m_pool_statistics_callback = callback;
+        m_pool_statistics_interval = interval;
+    }
+
+    /// <summary>
+    /// Get the limiter which requests pass before they are sent.
+    /// </summary>
+    /// <returns>The rate limiter, or null if requests are not limited.</returns>
+    const std::shared_ptr<http::client::rate_limiter>& rate_limiter() const { return m_rate_limiter; }
+
+    /// <summary>
+    /// Set a limiter which requests pass before they are sent, and which may be shared with other clients.
+    /// </summary>
+    /// <param name="limiter">The rate limiter, or null to not limit requests.</param>
+    /// <remarks>Each retry of a request passes the limiter again.</remarks>
+    void set_rate_limiter(const std::shared_ptr<http::client::rate_limiter>& limiter) { m_rate_limiter = limiter; }
+
+    /// <summary>
+    /// Get the circuit breaker which fails requests to unhealthy hosts at once.
+    /// </summary>
+    /// <returns>The circuit breaker, or null if requests are always sent.</returns>
+    const std::shared_ptr<http::client::circuit_breaker>& circuit_breaker() const { return m_circuit_breaker; }
+
+    /// <summary>
+    /// Set a circuit breaker which fails requests to unhealthy hosts at once, and which may be shared with other
+    /// clients.
+    /// </summary>
+    /// <param name="breaker">The circuit breaker, or null to always send requests.</param>
+    /// <remarks>Each retry of a request passes the circuit breaker again, before it passes the rate limiter.</remarks>
+    void set_circuit_breaker(const std::shared_ptr<http::client::circuit_breaker>& breaker)
+    {
+        m_circuit_breaker = breaker;
+    }
+
+    /// <summary>
+    /// Checks whether identical in-flight requests are coalesced.
+    /// </summary>
+    /// <returns>True if identical requests share one response, false otherwise.</returns>
+    bool coalesce_requests() const { return m_coalesce_requests; }
+
+    /// <summary>
+    /// Get the request headers whose values, together with the method and URI, identify a request for coalescing.
+    /// </summary>
+    /// <returns>The names of the key headers.</returns>
+    const std::vector<utility::string_t>& coalesce_headers() const { return m_coalesce_headers; }
+
+    /// <summary>
+    /// Sets whether identical in-flight requests are coalesced: while a GET or HEAD request is outstanding, requests
+    /// with the same method, URI and key header values wait for its response instead of being sent, and each
+    /// receives its own copy of the response.
+    /// </summary>
+    /// <param name="coalesce">True to coalesce identical requests, false otherwise.</param>
+    /// <remarks>Requests with a body, a response stream or a progress handler are never coalesced. The upstream
+    /// request is only canceled by its timeout, since other requests may be waiting for it.</remarks>
+    void set_coalesce_requests(bool coalesce) { m_coalesce_requests = coalesce; }
+
+    /// <summary>
+    /// Set the request headers whose values, together with the method and URI, identify a request for coalescing.
+    /// </summary>
+    /// <param name="names">The names of the key headers; by default Accept, Accept-Encoding, Accept-Language,
+    /// Authorization and Cookie.</param>
+    void set_coalesce_headers(std::vector<utility::string_t> names) { m_coalesce_headers = std::move(names); }
+
+    /// <summary>
+    /// Get the maximum number of bytes held by the client's in-memory response cache.
+    /// </summary>
+    /// <returns>The response cache size; 0, the default, disables caching.</returns>
+    size_t response_cache_size() const { return m_response_cache_size; }
+
+    /// <summary>
+    /// Set the maximum number of bytes held by the client's in-memory response cache.
+    /// </summary>
+    /// <param name="max_bytes">The response cache size, counting bodies and headers; 0 disables caching.</param>
+    /// <remarks>
+    /// The cache is private to the client and follows RFC 7234: GET responses are stored according to their
+    /// Cache-Control, Expires and Vary headers, and stale responses are revalidated using ETag and Last-Modified.
+    /// Fresh responses are served from memory without sending a request, and share one copy of their body. Once the
+    /// cache is full, the least recently used responses are evicted.
+    /// </remarks>
+    void set_response_cache_size(size_t max_bytes) { m_response_cache_size = max_bytes; }
+
     /// <summary>
     /// Sets a callback to enable custom setting of platform specific options.
     /// </summary>
@@ -344,8 +1279,9 @@ public:
     ///     Windows Desktop, WinHTTP - HINTERNET
     ///     Windows Runtime, WinRT - IXMLHTTPRequest2 *
     ///     All other platforms, Boost.Asio:
-    ///         https - boost::asio::ssl::stream<boost::asio::ip::tcp::socket &> *
-    ///         http - boost::asio::ip::tcp::socket *
+    ///         https - boost::asio::ssl::stream<boost::asio::generic::stream_protocol::socket &> *
+    ///         http - boost::asio::generic::stream_protocol::socket *
+    /// The Boost.Asio socket is a generic stream socket, since it may be a TCP or a Unix domain socket.
     /// </remarks>
     /// <param name="callback">A user callback allowing for customization of the request</param>
     void set_nativehandle_options(const std::function<void(native_handle)>& callback)
@@ -409,6 +1345,12 @@ private:
 
     std::chrono::microseconds m_timeout;
     size_t m_chunksize;
+    bool m_adaptive_chunksize;
+    size_t m_min_chunksize;
+    size_t m_max_chunksize;
+    http::socket_options m_socket_options;
+    bool m_expect_continue;
+    std::chrono::milliseconds m_expect_continue_timeout;
     bool m_request_compressed;
 
 #if !defined(__cplusplus_winrt)
@@ -429,6 +1371,41 @@ private:
 
     size_t m_max_redirects;
     bool m_https_to_http_redirects;
+    http::client::retry_policy m_retry_policy;
+    http::client::load_balancing_policy m_load_balancing;
+    utility::string_t m_unix_socket_path;
+    std::function<void(const connection_pool_statistics&)> m_pool_statistics_callback;
+    std::chrono::milliseconds m_pool_statistics_interval;
+    std::shared_ptr<http::client::rate_limiter> m_rate_limiter;
+    std::shared_ptr<http::client::circuit_breaker> m_circuit_breaker;
+    bool m_coalesce_requests;
+    std::vector<utility::string_t> m_coalesce_headers;
+    size_t m_response_cache_size;
+};
+
+/// <summary>
+/// Counts of the CONNECT tunnels an http_client opened through its proxy to reach an HTTPS base URI.
+/// </summary>
+/// <remarks>Only the asio-based client tunnels through the proxy itself, other implementations report no
+/// tunnels.</remarks>
+struct proxy_tunnel_statistics
+{
+    proxy_tunnel_statistics() : established(0), reused(0), failed(0) {}
+
+    /// <summary>
+    /// Tunnels which the proxy accepted.
+    /// </summary>
+    size_t established;
+
+    /// <summary>
+    /// Requests sent through a pooled tunnel instead of opening a new one.
+    /// </summary>
+    size_t reused;
+
+    /// <summary>
+    /// Attempts to open a tunnel which failed before the proxy accepted it.
+    /// </summary>
+    size_t failed;
 };
 
 class http_pipeline;
@@ -474,6 +1451,29 @@ public:
     /// <returns>A reference to the client configuration object.</returns>
     _ASYNCRTIMP const http_client_config& client_config() const;
 
+    /// <summary>
+    /// Opens CONNECT tunnels through the proxy ahead of the requests which use them, and pools them.
+    /// </summary>
+    /// <param name="count">The number of tunnels to open, which are established in parallel.</param>
+    /// <returns>A task completing once every tunnel is open, or failing with the error of a tunnel which could not
+    /// be.</returns>
+    /// <remarks>Tunnels are only used for an HTTPS base URI with a proxy; otherwise the task completes without
+    /// opening any. Only the asio-based client opens tunnels itself.</remarks>
+    _ASYNCRTIMP pplx::task<void> open_proxy_tunnels(size_t count);
+
+    /// <summary>
+    /// Gets counts of the CONNECT tunnels opened and reused so far.
+    /// </summary>
+    /// <returns>The tunnel statistics.</returns>
+    _ASYNCRTIMP proxy_tunnel_statistics tunnel_statistics() const;
+
+    /// <summary>
+    /// Gets the statistics of the connections the client pools for each host.
+    /// </summary>
+    /// <returns>The statistics of every host the client connected to; empty for implementations which do not pool
+    /// connections themselves.</returns>
+    _ASYNCRTIMP connection_pool_statistics pool_statistics() const;
+
     /// <summary>
     /// Adds an HTTP pipeline stage to the client.
     /// </summary>
@@ -751,6 +1751,100 @@ private:
     std::shared_ptr<::web::http::client::http_pipeline> m_pipeline;
 };
 
+/// <summary>
+/// Settings for <see cref="download_ranges" />.
+/// </summary>
+class ranged_download_options
+{
+public:
+    ranged_download_options() : m_segments(4), m_min_segment_size(1024 * 1024), m_max_attempts(3) {}
+
+    /// <summary>
+    /// Get the maximum number of byte ranges fetched in parallel.
+    /// </summary>
+    /// <returns>The number of segments.</returns>
+    size_t segments() const { return m_segments; }
+
+    /// <summary>
+    /// Set the maximum number of byte ranges fetched in parallel, each over its own pooled connection.
+    /// </summary>
+    /// <param name="segments">The number of segments.</param>
+    void set_segments(size_t segments) { m_segments = segments; }
+
+    /// <summary>
+    /// Get the smallest range worth a segment of its own.
+    /// </summary>
+    /// <returns>The minimum segment size in bytes.</returns>
+    utility::size64_t min_segment_size() const { return m_min_segment_size; }
+
+    /// <summary>
+    /// Set the smallest range worth a segment of its own; smaller resources are fetched with fewer segments.
+    /// </summary>
+    /// <param name="size">The minimum segment size in bytes.</param>
+    void set_min_segment_size(utility::size64_t size) { m_min_segment_size = size; }
+
+    /// <summary>
+    /// Get the number of consecutive failed attempts after which a segment gives up.
+    /// </summary>
+    /// <returns>The maximum number of attempts.</returns>
+    size_t max_attempts() const { return m_max_attempts; }
+
+    /// <summary>
+    /// Set the number of consecutive failed attempts after which a segment gives up. An attempt which received
+    /// part of its range resets the count, and the next attempt resumes after the received bytes.
+    /// </summary>
+    /// <param name="max_attempts">The maximum number of attempts.</param>
+    void set_max_attempts(size_t max_attempts) { m_max_attempts = max_attempts; }
+
+    /// <summary>
+    /// Get the progress handler.
+    /// </summary>
+    /// <returns>The handler called with the bytes written so far and the total size.</returns>
+    const std::function<void(utility::size64_t, utility::size64_t)>& progress_handler() const
+    {
+        return m_progress_handler;
+    }
+
+    /// <summary>
+    /// Set a handler called after each write to the target, with the number of bytes written by all segments so far
+    /// and the total size, or zero if the server did not report it.
+    /// </summary>
+    /// <param name="handler">The progress handler; calls are not concurrent.</param>
+    void set_progress_handler(const std::function<void(utility::size64_t, utility::size64_t)>& handler)
+    {
+        m_progress_handler = handler;
+    }
+
+private:
+    size_t m_segments;
+    utility::size64_t m_min_segment_size;
+    size_t m_max_attempts;
+    std::function<void(utility::size64_t, utility::size64_t)> m_progress_handler;
+};
+
+/// <summary>
+/// Asynchronously downloads a resource into a seekable stream buffer, fetching byte ranges of it in parallel.
+/// </summary>
+/// <param name="client">The client through which the requests are sent.</param>
+/// <param name="path_query_fragment">String containing the path, query, and fragment, relative to the http_client's
+/// base URI.</param>
+/// <param name="target">The stream buffer receiving the resource; each range is written at its offset from the
+/// beginning of the buffer, so it must support seeking the write head.</param>
+/// <param name="options">The segmentation, retry and progress settings.</param>
+/// <param name="token">Cancellation token for cancellation of the download.</param>
+/// <returns>A task that completes with the size of the resource once it has been written and the target has been
+/// synchronized.</returns>
+/// <remarks>A HEAD request decides the segments. If the server does not send "Accept-Ranges: bytes" and a
+/// Content-Length, or encodes the content, the resource is fetched with a single GET which restarts from the
+/// beginning when it fails. Ranged requests carry an If-Range validator from the HEAD response, so a resource which
+/// changes during the download fails it rather than being mixed.</remarks>
+_ASYNCRTIMP pplx::task<utility::size64_t> __cdecl download_ranges(
+    const http_client& client,
+    const utility::string_t& path_query_fragment,
+    concurrency::streams::streambuf<uint8_t> target,
+    const ranged_download_options& options = ranged_download_options(),
+    const pplx::cancellation_token& token = pplx::cancellation_token::none());
+
 namespace details
 {
 #if defined(_WIN32) || defined(CPPREST_FORCE_HTTP_CLIENT_WINHTTPPAL)
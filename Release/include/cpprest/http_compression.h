@@ -121,10 +121,12 @@ namespace algorithm
 const utility::char_t* const GZIP = _XPLATSTR("gzip");
 const utility::char_t* const DEFLATE = _XPLATSTR("deflate");
 const utility::char_t* const BROTLI = _XPLATSTR("br");
+const utility::char_t* const ZSTD = _XPLATSTR("zstd");
 #else // ^^^ VS2013 and before ^^^ // vvv VS2015+, and everything else vvv
 constexpr const utility::char_t* const GZIP = _XPLATSTR("gzip");
 constexpr const utility::char_t* const DEFLATE = _XPLATSTR("deflate");
 constexpr const utility::char_t* const BROTLI = _XPLATSTR("br");
+constexpr const utility::char_t* const ZSTD = _XPLATSTR("zstd");
 #endif
 
 /// <summary>
@@ -208,6 +210,56 @@ _ASYNCRTIMP std::unique_ptr<compress_provider> make_deflate_compressor(int compr
 /// </returns>
 _ASYNCRTIMP std::unique_ptr<compress_provider> make_brotli_compressor(
     uint32_t window, uint32_t quality, uint32_t mode, uint32_t block, uint32_t nomodel, uint32_t hint);
+
+/// <summary>
+// Factory function to instantiate a built-in Zstandard compression provider with caller-selected parameters.
+/// </summary>
+/// <param name="compressionLevel">The Zstandard compression level.</param>
+/// <param name="dictionary">An optional dictionary, which the receiver must also use for decompression.  When
+/// supplied, it is digested at <paramref name="compressionLevel"/>.</param>
+/// <returns>
+/// A caller-owned pointer to a Zstandard compression provider, or to nullptr if the library was built without
+/// built-in Zstandard support.
+/// </returns>
+_ASYNCRTIMP std::unique_ptr<compress_provider> make_zstd_compressor(
+    int compressionLevel, const std::vector<uint8_t>& dictionary = std::vector<uint8_t>());
+
+/// <summary>
+// Factory function to instantiate a built-in Zstandard decompression provider with caller-selected parameters.
+/// </summary>
+/// <param name="dictionary">An optional dictionary, matching the one used for compression.</param>
+/// <returns>
+/// A caller-owned pointer to a Zstandard decompression provider, or to nullptr if the library was built without
+/// built-in Zstandard support.
+/// </returns>
+_ASYNCRTIMP std::unique_ptr<decompress_provider> make_zstd_decompressor(
+    const std::vector<uint8_t>& dictionary = std::vector<uint8_t>());
+
+/// <summary>
+// Factory function to instantiate a pooled Zstandard compression provider factory with caller-selected parameters.
+/// </summary>
+/// <param name="compressionLevel">The Zstandard compression level.</param>
+/// <param name="dictionary">An optional dictionary, which is digested once and shared by all providers made by the
+/// factory.</param>
+/// <returns>
+/// A pointer to a factory for use with <c>details::get_compressor_from_header</c>, or to nullptr if the library was
+/// built without built-in Zstandard support.
+/// </returns>
+_ASYNCRTIMP std::shared_ptr<compress_factory> make_zstd_compress_factory(
+    int compressionLevel, const std::vector<uint8_t>& dictionary = std::vector<uint8_t>());
+
+/// <summary>
+// Factory function to instantiate a pooled Zstandard decompression provider factory with caller-selected parameters.
+/// </summary>
+/// <param name="weight">A numeric weight for the algorithm, times 1000, as for <c>make_decompress_factory</c>.</param>
+/// <param name="dictionary">An optional dictionary, which is digested once and shared by all providers made by the
+/// factory.</param>
+/// <returns>
+/// A pointer to a factory for use with <c>http_request::set_decompress_factories</c>, or to nullptr if the library was
+/// built without built-in Zstandard support.
+/// </returns>
+_ASYNCRTIMP std::shared_ptr<decompress_factory> make_zstd_decompress_factory(
+    uint16_t weight, const std::vector<uint8_t>& dictionary = std::vector<uint8_t>());
 } // namespace builtin
 
 /// <summary>
@@ -256,6 +308,37 @@ _ASYNCRTIMP std::shared_ptr<decompress_factory> make_decompress_factory(
     uint16_t weight,
     std::function<std::unique_ptr<decompress_provider>()> make_decompressor);
 
+/// <summary>
+/// Factory function to wrap a compression provider factory so that the providers it makes are reused.
+/// </summary>
+/// <param name="factory">The factory used to instantiate providers when no idle provider is available.</param>
+/// <param name="max_pooled">The maximum number of idle providers to retain for reuse.</param>
+/// <returns>
+/// A pointer to a factory reporting the same algorithm as <paramref name="factory"/>.
+/// </returns>
+/// <remarks>
+/// Providers obtained from the returned factory are <c>reset()</c> and returned to the pool when destroyed, which
+/// avoids reallocating compression state (e.g. zlib's window) for every message.  A provider whose <c>reset()</c>
+/// throws is discarded.  The built-in factories are pooled in this way.
+/// </remarks>
+_ASYNCRTIMP std::shared_ptr<compress_factory> make_pooled_compress_factory(std::shared_ptr<compress_factory> factory,
+                                                                           size_t max_pooled = 16);
+
+/// <summary>
+/// Factory function to wrap a decompression provider factory so that the providers it makes are reused.
+/// </summary>
+/// <param name="factory">The factory used to instantiate providers when no idle provider is available.</param>
+/// <param name="max_pooled">The maximum number of idle providers to retain for reuse.</param>
+/// <returns>
+/// A pointer to a factory reporting the same algorithm and weight as <paramref name="factory"/>.
+/// </returns>
+/// <remarks>
+/// Providers obtained from the returned factory are <c>reset()</c> and returned to the pool when destroyed.  A
+/// provider whose <c>reset()</c> throws is discarded.  The built-in factories are pooled in this way.
+/// </remarks>
+_ASYNCRTIMP std::shared_ptr<decompress_factory> make_pooled_decompress_factory(
+    std::shared_ptr<decompress_factory> factory, size_t max_pooled = 16);
+
 namespace details
 {
 /// <summary>
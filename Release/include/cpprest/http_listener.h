@@ -42,7 +42,7 @@ public:
     /// <summary>
     /// Create an http_listener configuration with default options.
     /// </summary>
-    http_listener_config() : m_timeout(utility::seconds(120)), m_backlog(0) {}
+    http_listener_config() : m_timeout(utility::seconds(120)), m_backlog(0), m_send_continue(true), m_acceptors(1) {}
 
     /// <summary>
     /// Copy constructor.
@@ -51,6 +51,10 @@ public:
     http_listener_config(const http_listener_config& other)
         : m_timeout(other.m_timeout)
         , m_backlog(other.m_backlog)
+        , m_socket_options(other.m_socket_options)
+        , m_send_continue(other.m_send_continue)
+        , m_unix_socket_path(other.m_unix_socket_path)
+        , m_acceptors(other.m_acceptors)
 #if !defined(_WIN32) || defined(CPPREST_FORCE_HTTP_LISTENER_ASIO)
         , m_ssl_context_callback(other.m_ssl_context_callback)
 #endif
@@ -64,6 +68,10 @@ public:
     http_listener_config(http_listener_config&& other)
         : m_timeout(std::move(other.m_timeout))
         , m_backlog(std::move(other.m_backlog))
+        , m_socket_options(std::move(other.m_socket_options))
+        , m_send_continue(other.m_send_continue)
+        , m_unix_socket_path(std::move(other.m_unix_socket_path))
+        , m_acceptors(other.m_acceptors)
 #if !defined(_WIN32) || defined(CPPREST_FORCE_HTTP_LISTENER_ASIO)
         , m_ssl_context_callback(std::move(other.m_ssl_context_callback))
 #endif
@@ -80,6 +88,10 @@ public:
         {
             m_timeout = rhs.m_timeout;
             m_backlog = rhs.m_backlog;
+            m_socket_options = rhs.m_socket_options;
+            m_send_continue = rhs.m_send_continue;
+            m_unix_socket_path = rhs.m_unix_socket_path;
+            m_acceptors = rhs.m_acceptors;
 #if !defined(_WIN32) || defined(CPPREST_FORCE_HTTP_LISTENER_ASIO)
             m_ssl_context_callback = rhs.m_ssl_context_callback;
 #endif
@@ -97,6 +109,10 @@ public:
         {
             m_timeout = std::move(rhs.m_timeout);
             m_backlog = std::move(rhs.m_backlog);
+            m_socket_options = std::move(rhs.m_socket_options);
+            m_send_continue = rhs.m_send_continue;
+            m_unix_socket_path = std::move(rhs.m_unix_socket_path);
+            m_acceptors = rhs.m_acceptors;
 #if !defined(_WIN32) || defined(CPPREST_FORCE_HTTP_LISTENER_ASIO)
             m_ssl_context_callback = std::move(rhs.m_ssl_context_callback);
 #endif
@@ -130,6 +146,69 @@ public:
     /// default.</param> <remarks>The implementation may not honour this value.</remarks>
     void set_backlog(int backlog) { m_backlog = backlog; }
 
+    /// <summary>
+    /// Get the TCP settings applied to the listening socket and each accepted connection.
+    /// </summary>
+    /// <returns>The socket options.</returns>
+    const http::socket_options& socket_options() const { return m_socket_options; }
+
+    /// <summary>
+    /// Sets the TCP settings applied to the listening socket and each accepted connection.
+    /// </summary>
+    /// <param name="options">The socket options.</param>
+    /// <remarks>This is only supported by the asio-based listener.</remarks>
+    void set_socket_options(const http::socket_options& options) { m_socket_options = options; }
+
+    /// <summary>
+    /// Checks if requests sent with Expect: 100-continue are answered with 100 Continue before the body is read, the
+    /// default is on.
+    /// </summary>
+    /// <returns>True if the interim response is sent automatically, false otherwise.</returns>
+    bool send_continue() const { return m_send_continue; }
+
+    /// <summary>
+    /// Sets whether requests sent with Expect: 100-continue are answered with 100 Continue before the body is read.
+    /// </summary>
+    /// <param name="send_continue">True to send the interim response as soon as the headers are read, false to let
+    /// the handler reply before the client sends the body.</param>
+    /// <remarks>Without the interim response, clients send the body once their own wait times out, and a reply sent
+    /// before then saves the upload. The connections of such requests are closed after the reply, since the body may
+    /// or may not follow. This is only supported by the asio-based listener.</remarks>
+    void set_send_continue(bool send_continue) { m_send_continue = send_continue; }
+
+    /// <summary>
+    /// Get the path of the Unix domain socket the listener accepts connections on.
+    /// </summary>
+    /// <returns>The socket path, or an empty string if the listener binds to the host and port of its URI.</returns>
+    const utility::string_t& unix_socket_path() const { return m_unix_socket_path; }
+
+    /// <summary>
+    /// Sets the path of a Unix domain socket to accept connections on instead of the host and port of the listener
+    /// URI. The URI still supplies the path the listener handles.
+    /// </summary>
+    /// <param name="path">The socket path, or an empty string to listen over TCP.</param>
+    /// <remarks>A socket left behind at the path is replaced, and the socket is removed when the listener closes.
+    /// Listeners sharing a socket path share the socket, as listeners on the same port do. This is only supported by
+    /// the asio-based listener on platforms with Unix domain sockets.</remarks>
+    void set_unix_socket_path(const utility::string_t& path) { m_unix_socket_path = path; }
+
+    /// <summary>
+    /// Get the number of accept loops, each keeping an accept outstanding, the default is one.
+    /// </summary>
+    /// <returns>The number of accept loops.</returns>
+    size_t acceptors() const { return m_acceptors; }
+
+    /// <summary>
+    /// Sets the number of accept loops, each keeping an accept outstanding, so that bursts of new connections are
+    /// accepted in parallel.
+    /// </summary>
+    /// <param name="acceptors">The number of accept loops, at least one.</param>
+    /// <remarks>On platforms with SO_REUSEPORT, each loop of a TCP listener listens on a socket of its own bound to
+    /// the same port, and the kernel spreads new connections across them; other processes of the same user may then
+    /// bind the port too. Otherwise the loops share one listening socket. This is only supported by the asio-based
+    /// listener.</remarks>
+    void set_acceptors(size_t acceptors) { m_acceptors = acceptors; }
+
 #if !defined(_WIN32) || defined(CPPREST_FORCE_HTTP_LISTENER_ASIO)
     /// <summary>
     /// Get the callback of ssl context
@@ -154,6 +233,10 @@ public:
 private:
     utility::seconds m_timeout;
     int m_backlog;
+    http::socket_options m_socket_options;
+    bool m_send_continue;
+    utility::string_t m_unix_socket_path;
+    size_t m_acceptors;
 #if !defined(_WIN32) || defined(CPPREST_FORCE_HTTP_LISTENER_ASIO)
     std::function<void(boost::asio::ssl::context&)> m_ssl_context_callback;
 #endif
@@ -18,9 +18,11 @@
 #include "cpprest/http_compression.h"
 #include "cpprest/http_headers.h"
 #include "cpprest/json.h"
+#include "cpprest/rawptrstream.h"
 #include "cpprest/streams.h"
 #include "cpprest/uri.h"
 #include "pplx/pplxtasks.h"
+#include <chrono>
 #include <map>
 #include <memory>
 #include <string>
@@ -287,6 +289,227 @@ private:
     std::string m_msg;
 };
 
+/// <summary>
+/// Timestamps recorded by an http_client while sending a request and receiving its response.
+/// </summary>
+/// <remarks>Timestamps for phases which did not happen, such as resolving and connecting on a reused connection, or
+/// which the client implementation does not report, are left default constructed. Only the asio-based client reports
+/// the connection phases.</remarks>
+struct http_timing
+{
+    typedef std::chrono::steady_clock clock;
+
+    /// <summary>
+    /// When the request was handed to the client implementation.
+    /// </summary>
+    clock::time_point queued;
+
+    /// <summary>
+    /// When a connection was taken from the pool, or created.
+    /// </summary>
+    clock::time_point connection_acquired;
+
+    /// <summary>
+    /// When the host name of a new connection was resolved.
+    /// </summary>
+    clock::time_point resolved;
+
+    /// <summary>
+    /// When a new connection was established.
+    /// </summary>
+    clock::time_point connected;
+
+    /// <summary>
+    /// When the TLS handshake of a new connection completed.
+    /// </summary>
+    clock::time_point tls_done;
+
+    /// <summary>
+    /// When the request headers and body had been written.
+    /// </summary>
+    clock::time_point request_written;
+
+    /// <summary>
+    /// When the first read of the response completed.
+    /// </summary>
+    clock::time_point first_byte;
+
+    /// <summary>
+    /// When the response headers had been parsed and the response was handed to the caller.
+    /// </summary>
+    clock::time_point headers_parsed;
+
+    /// <summary>
+    /// When the response body had been received.
+    /// </summary>
+    clock::time_point body_complete;
+
+    /// <summary>
+    /// True if the request was sent on a pooled connection.
+    /// </summary>
+    bool connection_reused = false;
+};
+
+/// <summary>
+/// TCP settings applied to every socket an http_client or http_listener creates.
+/// </summary>
+/// <remarks>Sizes and durations of zero leave the operating system default in place. Options the platform does not
+/// support are ignored, as are failures to apply an option.</remarks>
+class socket_options
+{
+public:
+    /// <summary>
+    /// Creates socket options tuned for request/response latency: Nagle's algorithm is disabled and everything else
+    /// is left at the operating system default.
+    /// </summary>
+    socket_options()
+        : m_no_delay(true)
+        , m_send_buffer_size(0)
+        , m_receive_buffer_size(0)
+        , m_keep_alive(false)
+        , m_keep_alive_idle(0)
+        , m_keep_alive_interval(0)
+        , m_keep_alive_count(0)
+        , m_fast_open(false)
+        , m_type_of_service(0)
+        , m_busy_poll(0)
+    {
+    }
+
+    /// <summary>
+    /// Checks if Nagle's algorithm is disabled (TCP_NODELAY), the default is true.
+    /// </summary>
+    /// <returns>True if small writes are sent immediately, false if they may be coalesced.</returns>
+    bool no_delay() const { return m_no_delay; }
+
+    /// <summary>
+    /// Sets whether Nagle's algorithm is disabled (TCP_NODELAY).
+    /// </summary>
+    /// <param name="no_delay">True to send small writes immediately, false to allow them to be coalesced.</param>
+    void set_no_delay(bool no_delay) { m_no_delay = no_delay; }
+
+    /// <summary>
+    /// Get the kernel send buffer size (SO_SNDBUF).
+    /// </summary>
+    /// <returns>The send buffer size in bytes, or zero for the operating system default.</returns>
+    int send_buffer_size() const { return m_send_buffer_size; }
+
+    /// <summary>
+    /// Sets the kernel send buffer size (SO_SNDBUF).
+    /// </summary>
+    /// <param name="size">The send buffer size in bytes, or zero for the operating system default.</param>
+    void set_send_buffer_size(int size) { m_send_buffer_size = size; }
+
+    /// <summary>
+    /// Get the kernel receive buffer size (SO_RCVBUF).
+    /// </summary>
+    /// <returns>The receive buffer size in bytes, or zero for the operating system default.</returns>
+    int receive_buffer_size() const { return m_receive_buffer_size; }
+
+    /// <summary>
+    /// Sets the kernel receive buffer size (SO_RCVBUF).
+    /// </summary>
+    /// <param name="size">The receive buffer size in bytes, or zero for the operating system default.</param>
+    /// <remarks>The size is set before connecting or listening, so it is taken into account for window
+    /// scaling.</remarks>
+    void set_receive_buffer_size(int size) { m_receive_buffer_size = size; }
+
+    /// <summary>
+    /// Checks if TCP keepalive probes are enabled (SO_KEEPALIVE), the default is false.
+    /// </summary>
+    /// <returns>True if idle connections are probed, false otherwise.</returns>
+    bool keep_alive() const { return m_keep_alive; }
+
+    /// <summary>
+    /// Get the idle time before the first keepalive probe (TCP_KEEPIDLE).
+    /// </summary>
+    /// <returns>The idle time, or zero for the operating system default.</returns>
+    std::chrono::seconds keep_alive_idle() const { return m_keep_alive_idle; }
+
+    /// <summary>
+    /// Get the time between keepalive probes (TCP_KEEPINTVL).
+    /// </summary>
+    /// <returns>The probe interval, or zero for the operating system default.</returns>
+    std::chrono::seconds keep_alive_interval() const { return m_keep_alive_interval; }
+
+    /// <summary>
+    /// Get the number of unanswered keepalive probes before the connection is dropped (TCP_KEEPCNT).
+    /// </summary>
+    /// <returns>The probe count, or zero for the operating system default.</returns>
+    int keep_alive_count() const { return m_keep_alive_count; }
+
+    /// <summary>
+    /// Sets whether TCP keepalive probes are enabled, and how they are sent.
+    /// </summary>
+    /// <param name="keep_alive">True to probe idle connections, false otherwise.</param>
+    /// <param name="idle">The idle time before the first probe, or zero for the operating system default.</param>
+    /// <param name="interval">The time between probes, or zero for the operating system default.</param>
+    /// <param name="count">The number of unanswered probes before the connection is dropped, or zero for the
+    /// operating system default.</param>
+    void set_keep_alive(bool keep_alive,
+                        std::chrono::seconds idle = std::chrono::seconds(0),
+                        std::chrono::seconds interval = std::chrono::seconds(0),
+                        int count = 0)
+    {
+        m_keep_alive = keep_alive;
+        m_keep_alive_idle = idle;
+        m_keep_alive_interval = interval;
+        m_keep_alive_count = count;
+    }
+
+    /// <summary>
+    /// Checks if TCP Fast Open is requested, the default is false.
+    /// </summary>
+    /// <returns>True if TCP Fast Open is requested, false otherwise.</returns>
+    bool fast_open() const { return m_fast_open; }
+
+    /// <summary>
+    /// Sets whether TCP Fast Open is requested.
+    /// </summary>
+    /// <param name="fast_open">True to request TCP Fast Open, false otherwise.</param>
+    /// <remarks>Listening sockets set TCP_FASTOPEN with the listen backlog as the queue length; client sockets set
+    /// TCP_FASTOPEN_CONNECT where the platform provides it, so the request is sent with the SYN of a repeat
+    /// connection.</remarks>
+    void set_fast_open(bool fast_open) { m_fast_open = fast_open; }
+
+    /// <summary>
+    /// Get the type of service or traffic class byte (IP_TOS or IPV6_TCLASS).
+    /// </summary>
+    /// <returns>The type of service, or zero for the operating system default.</returns>
+    int type_of_service() const { return m_type_of_service; }
+
+    /// <summary>
+    /// Sets the type of service or traffic class byte (IP_TOS or IPV6_TCLASS), for example a DSCP marking.
+    /// </summary>
+    /// <param name="type_of_service">The type of service, or zero for the operating system default.</param>
+    void set_type_of_service(int type_of_service) { m_type_of_service = type_of_service; }
+
+    /// <summary>
+    /// Get the time to busy poll the device queue on blocking receives (SO_BUSY_POLL).
+    /// </summary>
+    /// <returns>The busy poll time, or zero to not busy poll.</returns>
+    std::chrono::microseconds busy_poll() const { return m_busy_poll; }
+
+    /// <summary>
+    /// Sets the time to busy poll the device queue on blocking receives (SO_BUSY_POLL).
+    /// </summary>
+    /// <param name="busy_poll">The busy poll time, or zero to not busy poll.</param>
+    /// <remarks>Only supported on Linux, and may require elevated privileges.</remarks>
+    void set_busy_poll(std::chrono::microseconds busy_poll) { m_busy_poll = busy_poll; }
+
+private:
+    bool m_no_delay;
+    int m_send_buffer_size;
+    int m_receive_buffer_size;
+    bool m_keep_alive;
+    std::chrono::seconds m_keep_alive_idle;
+    std::chrono::seconds m_keep_alive_interval;
+    int m_keep_alive_count;
+    bool m_fast_open;
+    int m_type_of_service;
+    std::chrono::microseconds m_busy_poll;
+};
+
 namespace details
 {
 /// <summary>
@@ -513,6 +736,8 @@ public:
 
     _ASYNCRTIMP utility::string_t to_string() const;
 
+    http::http_timing& timing() { return m_timing; }
+
     _http_server_context* _get_server_context() const { return m_server_context.get(); }
 
     void _set_server_context(std::unique_ptr<details::_http_server_context> server_context)
@@ -525,6 +750,7 @@ private:
 
     http::status_code m_status_code;
     http::reason_phrase m_reason_phrase;
+    http::http_timing m_timing;
 };
 
 } // namespace details
@@ -592,6 +818,13 @@ public:
     /// <returns>HTTP headers for this response.</returns>
     const http_headers& headers() const { return _m_impl->headers(); }
 
+    /// <summary>
+    /// Gets the timestamps recorded by the http_client while sending the request and receiving this response.
+    /// </summary>
+    /// <returns>The timing breakdown of the request.</returns>
+    /// <remarks>The body_complete timestamp is set once the body has been received; see content_ready.</remarks>
+    const http_timing& timing() const { return _m_impl->timing(); }
+
     /// <summary>
     /// Generates a string representation of the message, including the body when possible.
     /// Mainly this should be used for debugging purposes as it has to copy the
@@ -771,6 +1004,23 @@ public:
         set_body(concurrency::streams::bytestream::open_istream(body_data), body_data.size());
     }
 
+    /// <summary>
+    /// Sets the body of the message to the contents of a shared, immutable byte vector. If the 'Content-Type'
+    /// header hasn't already been set it will be set to 'application/octet-stream'.
+    /// </summary>
+    /// <param name="body_data">Shared vector containing body data, which must not be modified while messages are
+    /// being sent from it.</param>
+    /// <remarks>
+    /// This will overwrite any previously set body data. The vector is not copied: any number of messages may be sent
+    /// from it at once, each reading at its own position, and it is kept alive until the last of them is done.
+    /// </remarks>
+    void set_body(std::shared_ptr<const std::vector<unsigned char>> body_data)
+    {
+        auto length = body_data->size();
+        set_body(concurrency::streams::istream(concurrency::streams::rawptr_buffer<uint8_t>(std::move(body_data))),
+                 length);
+    }
+
     /// <summary>
     /// Defines a stream that will be relied on to provide the body of the HTTP message when it is
     /// sent.
@@ -899,6 +1149,13 @@ public:
 
     void _set_listener_path(const utility::string_t& path) { m_listener_path = path; }
 
+    const std::map<utility::string_t, utility::string_t>& path_parameters() const { return m_path_parameters; }
+
+    void _set_path_parameters(std::map<utility::string_t, utility::string_t> parameters)
+    {
+        m_path_parameters = std::move(parameters);
+    }
+
     void _set_base_uri(const http::uri& base_uri) { m_base_uri = base_uri; }
 
     void _set_remote_address(const utility::string_t& remote_address) { m_remote_address = remote_address; }
@@ -922,6 +1179,7 @@ private:
     http::uri m_base_uri;
     http::uri m_uri;
     utility::string_t m_listener_path;
+    std::map<utility::string_t, utility::string_t> m_path_parameters;
 
     concurrency::streams::ostream m_response_stream;
 
@@ -991,6 +1249,19 @@ public:
     /// </remarks>
     uri relative_uri() const { return _m_impl->relative_uri(); }
 
+    /// <summary>
+    /// Gets the path segments matched by the templated segments of the listener's path, by their names.
+    /// </summary>
+    /// <returns>A map from the parameter names to the decoded segments.</returns>
+    /// <remarks>A listener whose path is <c>/users/{id}</c>, with the braces percent-encoded in its URI, handles
+    /// requests such as <c>/users/42/photos</c>, with the <c>id</c> parameter set to <c>42</c> and the relative URI
+    /// <c>/photos</c>. Templated listener paths are only supported by the asio-based listener.
+    /// </remarks>
+    const std::map<utility::string_t, utility::string_t>& path_parameters() const
+    {
+        return _m_impl->path_parameters();
+    }
+
     /// <summary>
     /// Get an absolute URI with scheme, host, port, path, query, and fragment part of
     /// the request message.
@@ -1203,6 +1474,25 @@ public:
         set_body(concurrency::streams::bytestream::open_istream(body_data), body_data.size());
     }
 
+    /// <summary>
+    /// Sets the body of the message to the contents of a shared, immutable byte vector. If the 'Content-Type'
+    /// header hasn't already been set it will be set to 'application/octet-stream'.
+    /// </summary>
+    /// <param name="body_data">Shared vector containing body data, which must not be modified while messages are
+    /// being sent from it.</param>
+    /// <remarks>
+    /// This will overwrite any previously set body data. The vector is not copied: any number of messages may be sent
+    /// from it at once, each reading at its own position, and it is kept alive until the last of them is done.
+    /// </remarks>
+    void set_body(std::shared_ptr<const std::vector<unsigned char>> body_data)
+    {
+        auto length = body_data->size();
+        _m_impl->set_body(
+            concurrency::streams::istream(concurrency::streams::rawptr_buffer<uint8_t>(std::move(body_data))),
+            length,
+            _XPLATSTR("application/octet-stream"));
+    }
+
     /// <summary>
     /// Defines a stream that will be relied on to provide the body of the HTTP message when it is
     /// sent.
@@ -1553,6 +1843,11 @@ public:
 
     void _set_listener_path(const utility::string_t& path) { _m_impl->_set_listener_path(path); }
 
+    void _set_path_parameters(std::map<utility::string_t, utility::string_t> parameters)
+    {
+        _m_impl->_set_path_parameters(std::move(parameters));
+    }
+
     const std::shared_ptr<http::details::_http_request>& _get_impl() const { return _m_impl; }
 
     void _set_cancellation_token(const pplx::cancellation_token& token) { _m_impl->set_cancellation_token(token); }
@@ -394,6 +394,19 @@ private:
         validate_mode(mode);
     }
 
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    /// <param name="data">The read-only memory block, which is kept alive until the buffer is destroyed.</param>
+    basic_rawptr_buffer(std::shared_ptr<const std::vector<_CharType>> data)
+        : streambuf_state_manager<_CharType>(std::ios_base::in)
+        , m_data(const_cast<_CharType*>(data->data()))
+        , m_size(data->size())
+        , m_current_position(0)
+        , m_owner(std::move(data))
+    {
+    }
+
     static void validate_mode(std::ios_base::openmode mode)
     {
         // Disallow simultaneous use of the stream buffer for writing and reading.
@@ -498,6 +511,9 @@ private:
 
     // Read/write head
     size_t m_current_position;
+
+    // The owner of the memory block, if it is shared
+    std::shared_ptr<const std::vector<_CharType>> m_owner;
 };
 
 } // namespace details
@@ -538,6 +554,17 @@ public:
     {
     }
 
+    /// <summary>
+    /// Create a read-only rawptr_buffer over a shared memory block, which it keeps alive. Any number of buffers may
+    /// read the same block, each at its own position, without copying it.
+    /// </summary>
+    /// <param name="data">The shared memory block.</param>
+    rawptr_buffer(std::shared_ptr<const std::vector<char_type>> data)
+        : streambuf<char_type>(std::shared_ptr<details::basic_rawptr_buffer<char_type>>(
+              new details::basic_rawptr_buffer<char_type>(std::move(data))))
+    {
+    }
+
     /// <summary>
     /// Default constructor.
     /// </summary>
@@ -52,11 +52,13 @@ void request_context::complete_headers()
     // Well, there are test cases that assumes that the istream is valid when t receives the response!
     // For now, we will drop our reference which will close the stream if the user doesn't have one.
     m_request.set_body(Concurrency::streams::istream());
+    record_timing(&http_timing::headers_parsed);
     m_request_completion.set(m_response);
 }
 
 void request_context::complete_request(utility::size64_t body_size)
 {
+    record_timing(&http_timing::body_complete);
     m_response._get_impl()->_complete(body_size);
 
     finish();
@@ -185,6 +187,7 @@ request_context::request_context(const std::shared_ptr<_http_client_communicator
     : m_http_client(client), m_request(request), m_uploaded(0), m_downloaded(0)
 {
     auto responseImpl = m_response._get_impl();
+    responseImpl->timing().queued = http_timing::clock::now();
 
     // Copy the user specified output stream over to the response
     responseImpl->set_outstream(request._get_impl()->_response_stream(), false);
@@ -386,6 +389,31 @@ http_client::http_client(const uri& base_uri, const http_client_config& client_c
 
     m_pipeline = std::make_shared<http_pipeline>(std::move(final_pipeline_stage));
 
+    // Cache hits never reach the later stages. Coalescing comes next, so that one upstream request is retried on
+    // behalf of all its waiters; retries come before later stages such as OAuth, so that those see each attempt.
+    // The circuit breaker and then the rate limiter come after retries, so that every attempt passes them, and a
+    // request failed by an open circuit does not wait for a token
+    if (client_config.response_cache_size() != 0)
+    {
+        add_handler(details::create_cache_stage(client_config.response_cache_size()));
+    }
+    if (client_config.coalesce_requests())
+    {
+        add_handler(details::create_coalescing_stage(client_config.coalesce_headers()));
+    }
+    if (client_config.retry_policy().enabled())
+    {
+        add_handler(details::create_retry_stage(client_config.retry_policy(), this->base_uri()));
+    }
+    if (client_config.circuit_breaker())
+    {
+        add_handler(details::create_circuit_breaker_stage(client_config.circuit_breaker(), this->base_uri()));
+    }
+    if (client_config.rate_limiter())
+    {
+        add_handler(details::create_rate_limit_stage(client_config.rate_limiter()));
+    }
+
 #if _WIN32_WINNT >= _WIN32_WINNT_VISTA
     add_handler(std::static_pointer_cast<http::http_pipeline_stage>(
         std::make_shared<oauth1::details::oauth1_handler>(client_config.oauth1())));
@@ -401,6 +429,15 @@ const http_client_config& http_client::client_config() const { return m_pipeline
 
 const uri& http_client::base_uri() const { return m_pipeline->m_last_stage->base_uri(); }
 
+pplx::task<void> http_client::open_proxy_tunnels(size_t count)
+{
+    return m_pipeline->m_last_stage->open_proxy_tunnels(count);
+}
+
+proxy_tunnel_statistics http_client::tunnel_statistics() const { return m_pipeline->m_last_stage->tunnel_statistics(); }
+
+connection_pool_statistics http_client::pool_statistics() const { return m_pipeline->m_last_stage->pool_statistics(); }
+
 // Macros to help build string at compile time and avoid overhead.
 #define STRINGIFY(x) _XPLATSTR(#x)
 #define TOSTRING(x) STRINGIFY(x)
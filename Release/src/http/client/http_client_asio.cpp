@@ -39,11 +39,17 @@
 #error "Cpp rest SDK requires c++11 smart pointer support from boost"
 #endif
 
+#include "../common/adaptive_chunk_size.h"
+#include "../common/asio_sendfile.h"
+#include "../common/asio_socket_options.h"
+#include "../common/asio_timer_wheel.h"
+#include "../common/endpoint_balancer.h"
 #include "../common/x509_cert_utilities.h"
 #include "cpprest/base_uri.h"
 #include "cpprest/details/http_helpers.h"
 #include "http_client_impl.h"
 #include "pplx/threadpool.h"
+#include <array>
 #include <memory>
 #include <unordered_set>
 
@@ -119,6 +125,8 @@ namespace client
 {
 namespace details
 {
+using web::http::details::asio_timer_wheel;
+
 enum class httpclient_errorcode_context
 {
     none = 0,
@@ -141,6 +149,30 @@ static std::string generate_base64_userpass(const ::web::credentials& creds)
 
 class asio_connection_pool;
 
+// Counts kept for the connections under one pool key. Each connection holds the counts of its key, so that they
+// follow the connection out of the pool and back.
+struct pool_host_counters
+{
+    pool_host_counters()
+        : connections(0)
+        , acquires(0)
+        , reuses(0)
+        , new_connections(0)
+        , stale_evictions(0)
+        , server_closes(0)
+        , wait_microseconds(0)
+    {
+    }
+
+    std::atomic<size_t> connections;
+    std::atomic<size_t> acquires;
+    std::atomic<size_t> reuses;
+    std::atomic<size_t> new_connections;
+    std::atomic<size_t> stale_evictions;
+    std::atomic<size_t> server_closes;
+    std::atomic<long long> wait_microseconds;
+};
+
 class asio_connection
 {
     friend class asio_client;
@@ -151,13 +183,22 @@ public:
         , m_socket(io_service)
         , m_ssl_stream()
         , m_cn_hostname()
+        , m_pool_key()
+        , m_counters()
         , m_is_reused(false)
         , m_keep_alive(true)
         , m_closed(false)
     {
     }
 
-    ~asio_connection() { close(); }
+    ~asio_connection()
+    {
+        close();
+        if (m_counters)
+        {
+            --m_counters->connections;
+        }
+    }
 
     // This simply instantiates the internal state to support ssl. It does not perform the handshake.
     void upgrade_to_ssl(std::string&& cn_hostname,
@@ -172,7 +213,7 @@ public:
         {
             ssl_context_callback(ssl_context);
         }
-        m_ssl_stream = utility::details::make_unique<boost::asio::ssl::stream<boost::asio::ip::tcp::socket&>>(
+        m_ssl_stream = utility::details::make_unique<boost::asio::ssl::stream<web::http::details::stream_socket&>>(
             m_socket, ssl_context);
         m_cn_hostname = std::move(cn_hostname);
     }
@@ -186,7 +227,7 @@ public:
         m_closed = true;
 
         boost::system::error_code error;
-        m_socket.shutdown(tcp::socket::shutdown_both, error);
+        m_socket.shutdown(boost::asio::socket_base::shutdown_both, error);
         m_socket.close(error);
     }
 
@@ -203,6 +244,30 @@ public:
     bool keep_alive() const { return m_keep_alive; }
     bool is_ssl() const { return m_ssl_stream ? true : false; }
     const std::string& cn_hostname() const { return m_cn_hostname; }
+    const std::string& pool_key() const { return m_pool_key; }
+    void set_pool_key(std::string&& pool_key, std::shared_ptr<pool_host_counters>&& counters)
+    {
+        m_pool_key = std::move(pool_key);
+        m_counters = std::move(counters);
+        ++m_counters->connections;
+    }
+    bool is_closed() const { return m_closed; }
+
+    void record_wait(const std::chrono::microseconds& wait)
+    {
+        if (m_counters)
+        {
+            m_counters->wait_microseconds += wait.count();
+        }
+    }
+
+    void record_server_close()
+    {
+        if (m_counters)
+        {
+            ++m_counters->server_closes;
+        }
+    }
 
     // Check if the error code indicates that the connection was closed by the
     // server: this is used to detect if a connection in the pool was closed during
@@ -242,14 +307,26 @@ public:
         return false;
     }
 
-    template<typename Iterator, typename Handler>
-    void async_connect(const Iterator& begin, const Handler& handler)
+    template<typename Handler>
+    void async_connect(const boost::asio::generic::stream_protocol::endpoint& endpoint,
+                       const socket_options& options,
+                       const Handler& handler)
     {
         {
             std::lock_guard<std::mutex> lock(m_socket_lock);
             if (!m_closed)
             {
-                m_socket.async_connect(begin, handler);
+                // Open the socket first, so that options such as the receive buffer size apply to the handshake
+                boost::system::error_code ec;
+                if (!m_socket.is_open())
+                {
+                    m_socket.open(endpoint.protocol(), ec);
+                }
+                if (!ec)
+                {
+                    web::http::details::apply_client_socket_options(m_socket, endpoint.protocol(), options);
+                }
+                m_socket.async_connect(endpoint, handler);
                 return;
             }
         } // unlock
@@ -300,6 +377,15 @@ public:
         }
     }
 
+    // Sends part of a file with sendfile(2). Only connections without TLS can send kernel-side.
+    template<typename Handler>
+    void async_sendfile(int fd, uint64_t offset, size_t count, const Handler& handler)
+    {
+        std::lock_guard<std::mutex> lock(m_socket_lock);
+        assert(!is_ssl());
+        web::http::details::async_sendfile(m_socket, fd, offset, count, handler);
+    }
+
     template<typename MutableBufferSequence, typename CompletionCondition, typename Handler>
     void async_read(MutableBufferSequence& buffer, const CompletionCondition& condition, const Handler& readHandler)
     {
@@ -330,11 +416,23 @@ public:
 
     void start_reuse() { m_is_reused = true; }
 
-    void enable_no_delay()
+    // The number of bytes which can be read from the socket without blocking
+    size_t available()
     {
-        boost::asio::ip::tcp::no_delay option(true);
+        std::lock_guard<std::mutex> lock(m_socket_lock);
         boost::system::error_code error_ignored;
-        m_socket.set_option(option, error_ignored);
+        return m_socket.available(error_ignored);
+    }
+
+    // The chunk size adapted to the transfers on this connection, starting from the configured chunk size
+    adaptive_chunk_size& chunk_size(const http_client_config& config)
+    {
+        if (!m_chunk_size)
+        {
+            m_chunk_size.reset(
+                new adaptive_chunk_size(config.chunksize(), config.min_chunksize(), config.max_chunksize()));
+        }
+        return *m_chunk_size;
     }
 
 private:
@@ -342,18 +440,25 @@ private:
     // because timeouts and cancellation can touch the socket at the same time
     // as normal message processing.
     std::mutex m_socket_lock;
-    tcp::socket m_socket;
-    std::unique_ptr<boost::asio::ssl::stream<tcp::socket&>> m_ssl_stream;
+    // A TCP or a Unix domain socket
+    web::http::details::stream_socket m_socket;
+    std::unique_ptr<boost::asio::ssl::stream<web::http::details::stream_socket&>> m_ssl_stream;
     std::string m_cn_hostname;
+    // Idle connections are pooled by endpoint and TLS host name
+    std::string m_pool_key;
+    std::shared_ptr<pool_host_counters> m_counters;
 
     bool m_is_reused;
     bool m_keep_alive;
     bool m_closed;
+
+    // Only touched by the request currently using the connection
+    std::unique_ptr<adaptive_chunk_size> m_chunk_size;
 };
 
 /// <summary>Implements a connection pool with adaptive connection removal</summary>
 /// <remarks>
-/// Every 30 seconds, the lambda in `start_epoch_interval` fires, triggering the
+/// Every 30 seconds, the shared timer wheel calls `start_epoch_interval`'s lambda, triggering the
 /// cleanup of any connections that have resided in the pool since the last
 /// cleanup phase.
 ///
@@ -378,36 +483,67 @@ public:
     asio_connection_pool()
         : m_lock()
         , m_connections()
+        , m_counters()
         , m_is_timer_running(false)
-        , m_pool_epoch_timer(crossplat::threadpool::shared_instance().service())
+        , m_pool_epoch_timer()
+        , m_report_timer()
     {
     }
 
+    ~asio_connection_pool()
+    {
+        if (m_pool_epoch_timer)
+        {
+            asio_timer_wheel::shared_instance()->cancel(*m_pool_epoch_timer);
+        }
+        if (m_report_timer)
+        {
+            asio_timer_wheel::shared_instance()->cancel(*m_report_timer);
+        }
+    }
+
     asio_connection_pool(const asio_connection_pool&) = delete;
     asio_connection_pool& operator=(const asio_connection_pool&) = delete;
 
-    std::shared_ptr<asio_connection> try_acquire(const std::string& cn_hostname)
+    std::shared_ptr<asio_connection> try_acquire(const std::string& pool_key)
     {
         std::lock_guard<std::mutex> lock(m_lock);
+        auto& counters = *host_counters(pool_key);
+        ++counters.acquires;
         if (m_connections.empty())
         {
             return nullptr;
         }
 
-        auto conn = m_connections[cn_hostname].try_acquire();
+        auto conn = m_connections[pool_key].try_acquire();
         if (conn)
         {
             conn->start_reuse();
+            ++counters.reuses;
         }
 
         return conn;
     }
 
+    // Counts a connection opened for the pool key, returning the counts the connection keeps
+    std::shared_ptr<pool_host_counters> connection_opened(const std::string& pool_key)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        auto counters = host_counters(pool_key);
+        ++counters->new_connections;
+        return counters;
+    }
+
     void release(std::shared_ptr<asio_connection>&& connection)
     {
         connection->cancel();
         if (!connection->keep_alive())
         {
+            // A connection the client did not close is one the response said not to keep alive
+            if (!connection->is_closed())
+            {
+                connection->record_server_close();
+            }
             connection.reset();
             return;
         }
@@ -419,78 +555,246 @@ public:
             m_is_timer_running = true;
         }
 
-        m_connections[connection->cn_hostname()].release(std::move(connection));
+        m_connections[connection->pool_key()].release(std::move(connection));
     }
 
-private:
-    // Note: must be called under m_lock
-    static void start_epoch_interval(const std::shared_ptr<asio_connection_pool>& pool)
+    // Closes the idle connections whose pool key starts with the prefix
+    void drop(const std::string& key_prefix)
     {
-        auto& self = *pool;
-        std::weak_ptr<asio_connection_pool> weak_pool = pool;
-
-        self.m_pool_epoch_timer.expires_from_now(boost::posix_time::seconds(30));
-        self.m_pool_epoch_timer.async_wait([weak_pool](const boost::system::error_code& ec) {
-            if (ec)
+        std::lock_guard<std::mutex> lock(m_lock);
+        for (auto it = m_connections.begin(); it != m_connections.end();)
+        {
+            if (it->first.compare(0, key_prefix.size(), key_prefix) == 0)
             {
-                return;
+                it = m_connections.erase(it);
             }
+            else
+            {
+                ++it;
+            }
+        }
+    }
 
+    connection_pool_statistics statistics()
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        connection_pool_statistics result;
+        for (const auto& host : m_counters)
+        {
+            const auto& counters = *host.second;
+            connection_pool_host_statistics statistics;
+            const auto idle = m_connections.find(host.first);
+            statistics.idle = idle == m_connections.end() ? 0 : idle->second.size();
+            statistics.total = (std::max)(counters.connections.load(), statistics.idle);
+            statistics.in_use = statistics.total - statistics.idle;
+            statistics.acquires = counters.acquires;
+            statistics.reuses = counters.reuses;
+            statistics.new_connections = counters.new_connections;
+            statistics.stale_evictions = counters.stale_evictions;
+            statistics.server_closes = counters.server_closes;
+            statistics.wait_time = std::chrono::microseconds(counters.wait_microseconds.load());
+            result[utility::conversions::to_string_t(host.first)] = statistics;
+        }
+        return result;
+    }
+
+    // Passes the statistics to the callback every interval for as long as the pool exists
+    static void start_reporting(const std::shared_ptr<asio_connection_pool>& pool,
+                                const std::function<void(const connection_pool_statistics&)>& callback,
+                                const std::chrono::milliseconds& interval)
+    {
+        std::weak_ptr<asio_connection_pool> weak_pool = pool;
+        pool->m_report_timer = std::make_shared<asio_timer_wheel::entry>([weak_pool, callback, interval]() {
             auto pool = weak_pool.lock();
             if (!pool)
             {
                 return;
             }
 
-            auto& self = *pool;
-            std::lock_guard<std::mutex> lock(self.m_lock);
-            bool restartTimer = false;
-            for (auto& entry : self.m_connections)
-            {
-                if (entry.second.free_stale_connections())
-                {
-                    restartTimer = true;
-                }
-            }
-
-            if (restartTimer)
+            try
             {
-                start_epoch_interval(pool);
+                callback(pool->statistics());
             }
-            else
+            catch (...)
             {
-                self.m_is_timer_running = false;
+                // A failing callback does not stop the following reports
             }
+            asio_timer_wheel::shared_instance()->schedule(pool->m_report_timer, interval);
         });
+        asio_timer_wheel::shared_instance()->schedule(pool->m_report_timer, interval);
+    }
+
+private:
+    // Note: must be called under m_lock
+    std::shared_ptr<pool_host_counters>& host_counters(const std::string& pool_key)
+    {
+        auto& counters = m_counters[pool_key];
+        if (!counters)
+        {
+            counters = std::make_shared<pool_host_counters>();
+        }
+        return counters;
+    }
+
+    // Note: must be called under m_lock
+    static void start_epoch_interval(const std::shared_ptr<asio_connection_pool>& pool)
+    {
+        auto& self = *pool;
+        if (!self.m_pool_epoch_timer)
+        {
+            std::weak_ptr<asio_connection_pool> weak_pool = pool;
+            self.m_pool_epoch_timer = std::make_shared<asio_timer_wheel::entry>([weak_pool]() {
+                auto pool = weak_pool.lock();
+                if (!pool)
+                {
+                    return;
+                }
+
+                auto& self = *pool;
+                std::lock_guard<std::mutex> lock(self.m_lock);
+                bool restartTimer = false;
+                for (auto& entry : self.m_connections)
+                {
+                    const size_t pooled = entry.second.size();
+                    if (entry.second.free_stale_connections())
+                    {
+                        restartTimer = true;
+                    }
+                    self.host_counters(entry.first)->stale_evictions += pooled - entry.second.size();
+                }
+
+                if (restartTimer)
+                {
+                    start_epoch_interval(pool);
+                }
+                else
+                {
+                    self.m_is_timer_running = false;
+                }
+            });
+        }
+
+        asio_timer_wheel::shared_instance()->schedule(self.m_pool_epoch_timer, std::chrono::seconds(30));
     }
 
     std::mutex m_lock;
     std::map<std::string, connection_pool_stack<asio_connection>> m_connections;
+    std::map<std::string, std::shared_ptr<pool_host_counters>> m_counters;
     bool m_is_timer_running;
-    boost::asio::deadline_timer m_pool_epoch_timer;
+    std::shared_ptr<asio_timer_wheel::entry> m_pool_epoch_timer;
+    std::shared_ptr<asio_timer_wheel::entry> m_report_timer;
 };
 
 class asio_client final : public _http_client_communicator
 {
 public:
+    // The address which requests picking an endpoint of a load balanced client connect to
+    struct balanced_endpoint
+    {
+        std::string m_host;
+        int m_port;
+        std::string m_pool_key;
+    };
+
     asio_client(http::uri&& address, http_client_config&& client_config)
         : _http_client_communicator(std::move(address), std::move(client_config))
         , m_pool(std::make_shared<asio_connection_pool>())
+        , m_tunnels_established(0)
+        , m_tunnels_reused(0)
+        , m_tunnels_failed(0)
+        , m_tunnels(false)
     {
+        // Idle connections are pooled under the address they connect to, followed by the TLS host name. Connections
+        // through a proxy are only interchangeable for the same proxy and target.
+        const int default_port = base_uri().scheme() == U("https") ? 443 : 80;
+        const auto host_port = [](const web::uri& address, int unspecified_port) {
+            return utility::conversions::to_utf8string(address.host()) + ":" +
+                   std::to_string(address.port() > 0 ? address.port() : unspecified_port);
+        };
+        const auto& proxy = this->client_config().proxy();
+        if (!this->client_config().unix_socket_path().empty())
+        {
+            m_pool_key_prefix = "unix:" + utility::conversions::to_utf8string(this->client_config().unix_socket_path());
+        }
+        else if (proxy.is_specified())
+        {
+            m_pool_key_prefix = host_port(proxy.address(), 8080) + ">" + host_port(base_uri(), default_port);
+            m_tunnels = base_uri().scheme() == U("https");
+        }
+        else
+        {
+            m_pool_key_prefix = host_port(base_uri(), default_port);
+        }
+        m_pool_key_prefix += "/";
+
+        const auto& statistics_callback = this->client_config().pool_statistics_callback();
+        if (statistics_callback)
+        {
+            asio_connection_pool::start_reporting(
+                m_pool, statistics_callback, this->client_config().pool_statistics_interval());
+        }
+
+        // A proxy or a Unix domain socket carries every request, so there is nothing to balance
+        const auto& policy = this->client_config().load_balancing();
+        if (policy.enabled() && !this->client_config().proxy().is_specified() &&
+            this->client_config().unix_socket_path().empty())
+        {
+            for (const auto& address : policy.endpoints())
+            {
+                balanced_endpoint endpoint;
+                endpoint.m_host = utility::conversions::to_utf8string(address.host());
+                endpoint.m_port = address.is_port_default() ? default_port : address.port();
+                endpoint.m_pool_key = endpoint.m_host + ":" + std::to_string(endpoint.m_port) + "/";
+                m_endpoints.push_back(std::move(endpoint));
+            }
+            m_balancer = utility::details::make_unique<endpoint_balancer>(m_endpoints.size(), policy);
+        }
     }
 
     virtual void send_request(const std::shared_ptr<request_context>& request_ctx) override;
 
     void release_connection(std::shared_ptr<asio_connection>&& conn) { m_pool->release(std::move(conn)); }
 
-    std::shared_ptr<asio_connection> obtain_connection(const http_request& req)
+    // Picks the endpoint for a new request, or returns endpoint_balancer::npos if requests go to the base URI
+    size_t pick_endpoint() { return m_balancer ? m_balancer->pick() : endpoint_balancer::npos; }
+
+    const balanced_endpoint& endpoint(size_t index) const { return m_endpoints[index]; }
+
+    void endpoint_succeeded(size_t index, const std::chrono::microseconds& latency)
+    {
+        m_balancer->succeeded(index, latency);
+    }
+
+    void endpoint_connect_failed(size_t index)
+    {
+        if (m_balancer->connect_failed(index))
+        {
+            m_pool->drop(m_endpoints[index].m_pool_key);
+        }
+    }
+
+    void endpoint_released(size_t index) { m_balancer->released(index); }
+
+    // Whether requests reach the base URI through a CONNECT tunnel opened through the proxy
+    bool tunnels_through_proxy() const { return m_tunnels; }
+
+    void tunnel_opened(bool established) { ++(established ? m_tunnels_established : m_tunnels_failed); }
+
+    void tunnel_reused() { ++m_tunnels_reused; }
+
+    // Takes an idle connection from the pool, unless pooled is false, or creates a new connection.
+    std::shared_ptr<asio_connection> obtain_connection(const http_request& req, size_t endpoint, bool pooled = true)
     {
         std::string cn_host = calc_cn_host(base_uri(), req.headers());
-        std::shared_ptr<asio_connection> conn = m_pool->try_acquire(cn_host);
+        std::string pool_key =
+            (endpoint == endpoint_balancer::npos ? m_pool_key_prefix : m_endpoints[endpoint].m_pool_key) + cn_host;
+        std::shared_ptr<asio_connection> conn = pooled ? m_pool->try_acquire(pool_key) : nullptr;
         if (conn == nullptr)
         {
             // Pool was empty. Create a new connection
             conn = std::make_shared<asio_connection>(crossplat::threadpool::shared_instance().service());
+            auto counters = m_pool->connection_opened(pool_key);
+            conn->set_pool_key(std::move(pool_key), std::move(counters));
             if (base_uri().scheme() == U("https") && !this->client_config().proxy().is_specified())
             {
                 conn->upgrade_to_ssl(std::move(cn_host), this->client_config().get_ssl_context_callback());
@@ -502,8 +806,29 @@ public:
 
     virtual pplx::task<http_response> propagate(http_request request) override;
 
+    virtual pplx::task<void> open_proxy_tunnels(size_t count) override;
+
+    virtual connection_pool_statistics pool_statistics() const override { return m_pool->statistics(); }
+
+    virtual proxy_tunnel_statistics tunnel_statistics() const override
+    {
+        proxy_tunnel_statistics statistics;
+        statistics.established = m_tunnels_established;
+        statistics.reused = m_tunnels_reused;
+        statistics.failed = m_tunnels_failed;
+        return statistics;
+    }
+
 private:
     const std::shared_ptr<asio_connection_pool> m_pool;
+    std::vector<balanced_endpoint> m_endpoints;
+    std::unique_ptr<endpoint_balancer> m_balancer;
+    // Prefix of the pool keys of connections which are not to a load balanced endpoint
+    std::string m_pool_key_prefix;
+    std::atomic<size_t> m_tunnels_established;
+    std::atomic<size_t> m_tunnels_reused;
+    std::atomic<size_t> m_tunnels_failed;
+    bool m_tunnels;
 };
 
 class asio_context final : public request_context, public std::enable_shared_from_this<asio_context>
@@ -513,13 +838,23 @@ class asio_context final : public request_context, public std::enable_shared_fro
 public:
     asio_context(const std::shared_ptr<_http_client_communicator>& client,
                  http_request& request,
-                 const std::shared_ptr<asio_connection>& connection)
+                 const std::shared_ptr<asio_connection>& connection,
+                 size_t endpoint)
         : request_context(client, request)
         , m_content_length(0)
         , m_needChunked(false)
+        , m_expect_continue(false)
+        , m_awaiting_continue(false)
         , m_timer(client->client_config().timeout<std::chrono::microseconds>())
         , m_resolver(crossplat::threadpool::shared_instance().service())
         , m_connection(connection)
+        , m_connection_released(false)
+        , m_endpoint(endpoint)
+        , m_endpoint_outcome(endpoint_outcome::pending)
+        , m_endpoint_start(std::chrono::steady_clock::now())
+        , m_endpoint_latency(0)
+        , m_tunnel_only(false)
+        , m_tunnel_open(false)
 #ifdef CPPREST_PLATFORM_ASIO_CERT_VERIFICATION_AVAILABLE
         , m_openssl_failed(false)
 #endif // CPPREST_PLATFORM_ASIO_CERT_VERIFICATION_AVAILABLE
@@ -529,17 +864,51 @@ public:
     virtual ~asio_context()
     {
         m_timer.stop();
-        // Release connection back to the pool. If connection was not closed, it will be put to the pool for reuse.
-        std::static_pointer_cast<asio_client>(m_http_client)->release_connection(std::move(m_connection));
+        release_connection();
+        auto client = std::static_pointer_cast<asio_client>(m_http_client);
+        if (m_endpoint != endpoint_balancer::npos)
+        {
+            switch (m_endpoint_outcome)
+            {
+                case endpoint_outcome::responded: client->endpoint_succeeded(m_endpoint, m_endpoint_latency); break;
+                case endpoint_outcome::connect_failed: client->endpoint_connect_failed(m_endpoint); break;
+                default: client->endpoint_released(m_endpoint); break;
+            }
+        }
+
+        // A tunnel is only usable by requests once it is back in the pool
+        if (m_tunnel_only && m_tunnel_open)
+        {
+            m_request_completion.set(m_response);
+        }
+        else if (m_tunnel_only)
+        {
+            m_request_completion.set_exception(http_exception("The proxy tunnel was closed before it was opened"));
+        }
     }
 
     static std::shared_ptr<request_context> create_request_context(std::shared_ptr<_http_client_communicator>& client,
                                                                    http_request& request)
     {
         auto client_cast(std::static_pointer_cast<asio_client>(client));
-        auto connection(client_cast->obtain_connection(request));
-        auto ctx = std::make_shared<asio_context>(client, request, connection);
+        const auto endpoint = client_cast->pick_endpoint();
+        std::shared_ptr<asio_connection> connection;
+        try
+        {
+            connection = client_cast->obtain_connection(request, endpoint);
+        }
+        catch (...)
+        {
+            if (endpoint != endpoint_balancer::npos)
+            {
+                client_cast->endpoint_released(endpoint);
+            }
+            throw;
+        }
+        auto ctx = std::make_shared<asio_context>(client, request, connection, endpoint);
         ctx->m_timer.set_ctx(std::weak_ptr<asio_context>(ctx));
+        ctx->record_timing(&http_timing::connection_acquired);
+        ctx->m_response._get_impl()->timing().connection_reused = connection->is_reused();
         return ctx;
     }
 
@@ -592,17 +961,40 @@ public:
         }
 
     private:
+        // The attempt is counted as failed before the context reports the error
+        void report_error(const std::string& message,
+                          const boost::system::error_code& ec,
+                          httpclient_errorcode_context context)
+        {
+            static_cast<asio_client&>(*m_context->m_http_client).tunnel_opened(false);
+            m_context->report_error(message, ec, context);
+        }
+
+        void report_exception(std::exception_ptr exceptionPtr)
+        {
+            static_cast<asio_client&>(*m_context->m_http_client).tunnel_opened(false);
+            m_context->report_exception(exceptionPtr);
+        }
+
+        void handle_failed_read_status_line(const boost::system::error_code& ec, const char* generic_error_message)
+        {
+            static_cast<asio_client&>(*m_context->m_http_client).tunnel_opened(false);
+            m_context->handle_failed_read_status_line(ec, generic_error_message);
+        }
+
         void handle_resolve(const boost::system::error_code& ec, tcp::resolver::iterator endpoints)
         {
             if (ec)
             {
-                m_context->report_error("Error resolving proxy address", ec, httpclient_errorcode_context::connect);
+                report_error("Error resolving proxy address", ec, httpclient_errorcode_context::connect);
             }
             else
             {
                 m_context->m_timer.reset();
-                auto endpoint = *endpoints;
+                m_context->record_timing(&http_timing::resolved);
+                const tcp::endpoint endpoint = *endpoints;
                 m_context->m_connection->async_connect(endpoint,
+                                                       m_context->m_http_client->client_config().socket_options(),
                                                        boost::bind(&ssl_proxy_tunnel::handle_tcp_connect,
                                                                    shared_from_this(),
                                                                    boost::asio::placeholders::error,
@@ -615,7 +1007,7 @@ public:
             if (!ec)
             {
                 m_context->m_timer.reset();
-                m_context->m_connection->enable_no_delay();
+                m_context->record_timing(&http_timing::connected);
                 m_context->m_connection->async_write(m_request,
                                                      boost::bind(&ssl_proxy_tunnel::handle_write_request,
                                                                  shared_from_this(),
@@ -623,7 +1015,7 @@ public:
             }
             else if (endpoints == tcp::resolver::iterator())
             {
-                m_context->report_error(
+                report_error(
                     "Failed to connect to any resolved proxy endpoint", ec, httpclient_errorcode_context::connect);
             }
             else
@@ -633,16 +1025,18 @@ public:
                 auto client = std::static_pointer_cast<asio_client>(m_context->m_http_client);
                 try
                 {
-                    m_context->m_connection = client->obtain_connection(m_context->m_request);
+                    m_context->m_connection =
+                        client->obtain_connection(m_context->m_request, m_context->m_endpoint, false);
                 }
                 catch (...)
                 {
-                    m_context->report_exception(std::current_exception());
+                    report_exception(std::current_exception());
                     return;
                 }
 
-                auto endpoint = *endpoints;
+                const tcp::endpoint endpoint = *endpoints;
                 m_context->m_connection->async_connect(endpoint,
+                                                       m_context->m_http_client->client_config().socket_options(),
                                                        boost::bind(&ssl_proxy_tunnel::handle_tcp_connect,
                                                                    shared_from_this(),
                                                                    boost::asio::placeholders::error,
@@ -663,7 +1057,7 @@ public:
             }
             else
             {
-                m_context->report_error(
+                report_error(
                     "Failed to send connect request to proxy.", err, httpclient_errorcode_context::writebody);
             }
         }
@@ -682,7 +1076,7 @@ public:
 
                 if (!response_stream || http_version.substr(0, 5) != "HTTP/")
                 {
-                    m_context->report_error("Invalid HTTP status line during proxy connection",
+                    report_error("Invalid HTTP status line during proxy connection",
                                             ec,
                                             httpclient_errorcode_context::readheader);
                     return;
@@ -690,12 +1084,14 @@ public:
 
                 if (status_code != 200)
                 {
-                    m_context->report_error("Expected a 200 response from proxy, received: " + to_string(status_code),
+                    report_error("Expected a 200 response from proxy, received: " + to_string(status_code),
                                             ec,
                                             httpclient_errorcode_context::readheader);
                     return;
                 }
 
+                static_cast<asio_client&>(*m_context->m_http_client).tunnel_opened(true);
+
                 try
                 {
                     m_context->upgrade_to_ssl();
@@ -710,7 +1106,7 @@ public:
             }
             else
             {
-                m_context->handle_failed_read_status_line(ec, "Failed to read HTTP status line from proxy");
+                handle_failed_read_status_line(ec, "Failed to read HTTP status line from proxy");
             }
         }
 
@@ -742,8 +1138,9 @@ public:
         int proxy_port = -1;
 
         // There is no support for auto-detection of proxies on non-windows platforms, it must be specified explicitly
-        // from the client code.
-        if (m_http_client->client_config().proxy().is_specified())
+        // from the client code. Requests over a Unix domain socket do not use the proxy.
+        if (m_http_client->client_config().proxy().is_specified() &&
+            m_http_client->client_config().unix_socket_path().empty())
         {
             proxy_type =
                 m_http_client->base_uri().scheme() == U("https") ? http_proxy_type::ssl_tunnel : http_proxy_type::http;
@@ -852,6 +1249,19 @@ public:
                 }
             }
 
+            // Hold the body back until the server accepts the request
+            utility::string_t expect;
+            if (ctx->m_request.headers().match(header_names::expect, expect))
+            {
+                ctx->m_expect_continue = boost::iequals(expect, U("100-continue"));
+            }
+            else if (ctx->m_http_client->client_config().expect_continue() &&
+                     (ctx->m_needChunked || ctx->m_content_length != 0))
+            {
+                ctx->m_expect_continue = true;
+                extra_headers.append("Expect: 100-continue\r\n");
+            }
+
             if (proxy_type == http_proxy_type::http)
             {
                 extra_headers.append("Cache-Control: no-store, no-cache\r\n"
@@ -876,6 +1286,11 @@ public:
                 // request directly. In both cases we have already established a tcp connection.
                 ctx->write_request();
             }
+            else if (!ctx->m_http_client->client_config().unix_socket_path().empty())
+            {
+                // A new connection over a Unix domain socket has no address to resolve.
+                ctx->connect_unix_socket();
+            }
             else
             {
                 // If the connection is new (unresolved and unconnected socket), then start async
@@ -884,6 +1299,12 @@ public:
                 // For normal http proxies, we want to connect directly to the proxy server. It will relay our request.
                 auto tcp_host = proxy_type == http_proxy_type::http ? proxy_host : host;
                 auto tcp_port = proxy_type == http_proxy_type::http ? proxy_port : port;
+                if (ctx->m_endpoint != endpoint_balancer::npos)
+                {
+                    const auto& endpoint = static_cast<asio_client&>(*ctx->m_http_client).endpoint(ctx->m_endpoint);
+                    tcp_host = endpoint.m_host;
+                    tcp_port = endpoint.m_port;
+                }
 
                 tcp::resolver::query query(tcp_host, to_string(tcp_port));
                 ctx->m_resolver.async_resolve(query,
@@ -921,10 +1342,22 @@ public:
         }
         else
         {
+            if (proxy_type == http_proxy_type::ssl_tunnel)
+            {
+                static_cast<asio_client&>(*m_http_client).tunnel_reused();
+            }
             start_http_request_flow(shared_from_this());
         }
     }
 
+    // Opens a CONNECT tunnel and completes the TLS handshake through it, without sending a request
+    void open_tunnel()
+    {
+        auto ssl_tunnel = std::make_shared<ssl_proxy_tunnel>(
+            shared_from_this(), [](std::shared_ptr<asio_context> ctx) { ctx->write_request(); });
+        ssl_tunnel->start_proxy_connect();
+    }
+
     template<typename _ExceptionType>
     void report_exception(const _ExceptionType& e)
     {
@@ -935,10 +1368,48 @@ public:
     {
         // Don't recycle connections that had an error into the connection pool.
         m_connection->close();
+        if (m_tunnel_only)
+        {
+            // There is no response, and no request queued behind this one
+            m_request_completion.set_exception(exceptionPtr);
+            return;
+        }
         request_context::report_exception(exceptionPtr);
     }
 
 private:
+    void complete_request(utility::size64_t body_size)
+    {
+        // Pool the connection before the response completes, so that a request sent as soon as this one completes
+        // can reuse it. Neither the timer nor a cancellation may close it once another request could be using it.
+        m_timer.stop();
+        if (m_cancellationRegistration != pplx::cancellation_token_registration())
+        {
+            m_request._cancellation_token().deregister_callback(m_cancellationRegistration);
+            m_cancellationRegistration = pplx::cancellation_token_registration();
+        }
+        release_connection();
+        request_context::complete_request(body_size);
+    }
+
+    // Release connection back to the pool. If connection was not closed, it will be put to the pool for reuse.
+    void release_connection()
+    {
+        if (m_connection_released)
+        {
+            return;
+        }
+        m_connection_released = true;
+
+        const auto& config = m_http_client->client_config();
+        if (config.adaptive_chunksize())
+        {
+            m_connection->chunk_size(config).record_message(
+                static_cast<size_t>((std::max)(m_uploaded, m_downloaded)));
+        }
+        static_cast<asio_client&>(*m_http_client).release_connection(std::shared_ptr<asio_connection>(m_connection));
+    }
+
     void upgrade_to_ssl()
     {
         auto& client = static_cast<asio_client&>(*m_http_client);
@@ -1011,16 +1482,21 @@ private:
         m_timer.reset();
         if (!ec)
         {
-            m_connection->enable_no_delay();
+            record_timing(&http_timing::connected);
             write_request();
         }
         else if (ec.value() == boost::system::errc::operation_canceled ||
                  ec.value() == boost::asio::error::operation_aborted)
         {
+            if (m_timer.has_timedout())
+            {
+                m_endpoint_outcome = endpoint_outcome::connect_failed;
+            }
             report_error("Request canceled by user.", ec, httpclient_errorcode_context::connect);
         }
         else if (endpoints == tcp::resolver::iterator())
         {
+            m_endpoint_outcome = endpoint_outcome::connect_failed;
             report_error("Failed to connect to any resolved endpoint", ec, httpclient_errorcode_context::connect);
         }
         else
@@ -1029,7 +1505,7 @@ private:
             auto client = std::static_pointer_cast<asio_client>(m_http_client);
             try
             {
-                m_connection = client->obtain_connection(m_request);
+                m_connection = client->obtain_connection(m_request, m_endpoint, false);
             }
             catch (...)
             {
@@ -1037,9 +1513,10 @@ private:
                 return;
             }
 
-            auto endpoint = *endpoints;
+            const tcp::endpoint endpoint = *endpoints;
             m_connection->async_connect(
                 endpoint,
+                m_http_client->client_config().socket_options(),
                 boost::bind(
                     &asio_context::handle_connect, shared_from_this(), boost::asio::placeholders::error, ++endpoints));
         }
@@ -1049,25 +1526,65 @@ private:
     {
         if (ec)
         {
+            m_endpoint_outcome = endpoint_outcome::connect_failed;
             report_error("Error resolving address", ec, httpclient_errorcode_context::connect);
         }
         else if (endpoints == tcp::resolver::iterator())
         {
+            m_endpoint_outcome = endpoint_outcome::connect_failed;
             report_error("Failed to resolve address", ec, httpclient_errorcode_context::connect);
         }
         else
         {
             m_timer.reset();
-            auto endpoint = *endpoints;
+            record_timing(&http_timing::resolved);
+            const tcp::endpoint endpoint = *endpoints;
             m_connection->async_connect(
                 endpoint,
+                m_http_client->client_config().socket_options(),
                 boost::bind(
                     &asio_context::handle_connect, shared_from_this(), boost::asio::placeholders::error, ++endpoints));
         }
     }
 
+    void connect_unix_socket()
+    {
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+        boost::asio::local::stream_protocol::endpoint endpoint;
+        try
+        {
+            endpoint.path(utility::conversions::to_utf8string(m_http_client->client_config().unix_socket_path()));
+        }
+        catch (const boost::system::system_error& e)
+        {
+            report_error("Invalid Unix domain socket path", e.code(), httpclient_errorcode_context::connect);
+            return;
+        }
+
+        m_timer.reset();
+        record_timing(&http_timing::resolved);
+        m_connection->async_connect(endpoint,
+                                    m_http_client->client_config().socket_options(),
+                                    boost::bind(&asio_context::handle_connect,
+                                                shared_from_this(),
+                                                boost::asio::placeholders::error,
+                                                tcp::resolver::iterator()));
+#else
+        report_error("Unix domain sockets are not supported on this platform",
+                     boost::asio::error::operation_not_supported,
+                     httpclient_errorcode_context::connect);
+#endif
+    }
+
     void write_request()
     {
+        if (!m_tunnel_only)
+        {
+            // The request has waited for its connection until it is connected, before any TLS handshake
+            m_connection->record_wait(std::chrono::duration_cast<std::chrono::microseconds>(
+                http_timing::clock::now() - m_response._get_impl()->timing().connection_acquired));
+        }
+
         // Only perform handshake if a TLS connection and not being reused.
         if (m_connection->is_ssl() && !m_connection->is_reused())
         {
@@ -1091,9 +1608,7 @@ private:
         }
         else
         {
-            m_connection->async_write(
-                m_body_buf,
-                boost::bind(&asio_context::handle_write_headers, shared_from_this(), boost::asio::placeholders::error));
+            write_headers();
         }
     }
 
@@ -1101,9 +1616,15 @@ private:
     {
         if (!ec)
         {
-            m_connection->async_write(
-                m_body_buf,
-                boost::bind(&asio_context::handle_write_headers, shared_from_this(), boost::asio::placeholders::error));
+            record_timing(&http_timing::tls_done);
+            if (m_tunnel_only)
+            {
+                // The destructor completes the context once the tunnel is pooled
+                m_timer.stop();
+                m_tunnel_open = true;
+                return;
+            }
+            write_headers();
         }
         else
         {
@@ -1138,23 +1659,150 @@ private:
         return rfc2818(preverified, verifyCtx);
     }
 
+    // Writes the request headers. The first part of a body held in memory is gathered into the same write, straight
+    // from the request stream, unless the server has to accept the request before the body is sent.
+    void write_headers()
+    {
+        uint8_t* body = nullptr;
+        const size_t body_size = m_needChunked || m_expect_continue ? 0 : acquire_memory_body(body);
+        if (body_size == 0)
+        {
+            m_connection->async_write(
+                m_body_buf,
+                boost::bind(&asio_context::handle_write_headers, shared_from_this(), boost::asio::placeholders::error));
+            return;
+        }
+
+        const size_t header_size = m_body_buf.size();
+        std::array<boost::asio::const_buffer, 2> buffers {
+            {boost::asio::buffer(m_body_buf.data()), boost::asio::buffer(static_cast<const void*>(body), body_size)}};
+        const auto this_request = shared_from_this();
+        m_connection->async_write(
+            buffers,
+            [this_request, body, header_size, body_size AND_CAPTURE_MEMBER_FUNCTION_POINTERS](
+                const boost::system::error_code& ec, size_t) {
+                this_request->m_body_buf.consume(header_size);
+                if (ec)
+                {
+                    this_request->_get_readbuffer().release(body, 0);
+                    this_request->report_error(
+                        "Failed to write request headers", ec, httpclient_errorcode_context::writeheader);
+                    return;
+                }
+                this_request->memory_body_written(body, body_size);
+                this_request->handle_write_large_body(ec);
+            });
+    }
+
     void handle_write_headers(const boost::system::error_code& ec)
     {
         if (ec)
         {
             report_error("Failed to write request headers", ec, httpclient_errorcode_context::writeheader);
         }
+        else if (m_expect_continue)
+        {
+            read_continue();
+        }
         else
         {
-            if (m_needChunked)
+            write_body();
+        }
+    }
+
+    void write_body()
+    {
+        if (m_needChunked)
+        {
+            handle_write_chunked_body(boost::system::error_code());
+        }
+        else
+        {
+            handle_write_large_body(boost::system::error_code());
+        }
+    }
+
+    // Waits for the server to accept a request sent with Expect: 100-continue. If no interim response arrives in time,
+    // the read is canceled and the body sent anyway, as RFC 7231 section 5.1.1 allows.
+    void read_continue()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_continue_lock);
+            m_awaiting_continue = true;
+        }
+
+        std::weak_ptr<asio_context> weak_ctx = shared_from_this();
+        m_continue_timer = asio_timer_wheel::shared_instance()->arm(
+            m_http_client->client_config().expect_continue_timeout(), [weak_ctx]() {
+                auto ctx = weak_ctx.lock();
+                if (ctx)
+                {
+                    // Canceling under the lock keeps the cancellation from reaching the writes of the body
+                    std::lock_guard<std::mutex> lock(ctx->m_continue_lock);
+                    if (ctx->m_awaiting_continue)
+                    {
+                        ctx->m_awaiting_continue = false;
+                        ctx->m_connection->cancel();
+                    }
+                }
+            });
+
+        m_connection->async_read_until(m_body_buf,
+                                       CRLF + CRLF,
+                                       boost::bind(&asio_context::handle_continue,
+                                                   shared_from_this(),
+                                                   boost::asio::placeholders::error,
+                                                   boost::asio::placeholders::bytes_transferred));
+    }
+
+    void handle_continue(const boost::system::error_code& ec, size_t header_size)
+    {
+        bool timed_out;
+        {
+            std::lock_guard<std::mutex> lock(m_continue_lock);
+            timed_out = !m_awaiting_continue;
+            m_awaiting_continue = false;
+        }
+        asio_timer_wheel::shared_instance()->cancel(*m_continue_timer);
+
+        if (ec == boost::asio::error::operation_aborted && timed_out && m_body_buf.size() == 0)
+        {
+            // The server has not answered, so it is not going to reject the request early
+            write_body();
+            return;
+        }
+        if (ec)
+        {
+            handle_status_line(ec);
+            return;
+        }
+
+        std::istringstream status_stream(
+            std::string(boost::asio::buffer_cast<const char*>(m_body_buf.data()), header_size));
+        status_stream.imbue(std::locale::classic());
+        std::string http_version;
+        status_code status = 0;
+        status_stream >> http_version >> status;
+        if (status >= 100 && status < 200)
+        {
+            m_timer.reset();
+            m_body_buf.consume(header_size);
+            if (status != status_codes::Continue)
             {
-                handle_write_chunked_body(ec);
+                // Other interim responses, such as 103 Early Hints, leave the server still to decide
+                read_continue();
+                return;
             }
-            else
+            if (m_body_buf.size() == 0)
             {
-                handle_write_large_body(ec);
+                write_body();
+                return;
             }
         }
+
+        // The server answered before receiving the body, so the connection is not in a state to carry another request
+        m_connection->set_keep_alive(false);
+        handle_status_line(ec);
     }
 
     void handle_write_chunked_body(const boost::system::error_code& ec)
@@ -1180,7 +1828,7 @@ private:
             }
         }
 
-        const auto& chunkSize = m_http_client->client_config().chunksize();
+        const auto chunkSize = chunk_size();
         auto readbuf = _get_readbuffer();
         uint8_t* buf = boost::asio::buffer_cast<uint8_t*>(
             m_body_buf.prepare(chunkSize + http::details::chunked_encoding::additional_encoding_space));
@@ -1198,6 +1846,7 @@ private:
                     return;
                 }
 
+                this_request->record_chunk(readSize, this_request->_get_readbuffer().in_avail());
                 const size_t offset = http::details::chunked_encoding::add_chunked_delimiters(
                     buf, chunkSize + http::details::chunked_encoding::additional_encoding_space, readSize);
                 this_request->m_body_buf.commit(readSize + http::details::chunked_encoding::additional_encoding_space);
@@ -1243,9 +1892,14 @@ private:
             }
         }
 
+        const auto readSize =
+            static_cast<size_t>((std::min)(static_cast<uint64_t>(chunk_size()), m_content_length - m_uploaded));
+        if (write_file_body(readSize) || write_memory_body())
+        {
+            return;
+        }
+
         const auto this_request = shared_from_this();
-        const auto readSize = static_cast<size_t>((std::min)(
-            static_cast<uint64_t>(m_http_client->client_config().chunksize()), m_content_length - m_uploaded));
         auto readbuf = _get_readbuffer();
         readbuf.getn(boost::asio::buffer_cast<uint8_t*>(m_body_buf.prepare(readSize)), readSize)
             .then([this_request AND_CAPTURE_MEMBER_FUNCTION_POINTERS](pplx::task<size_t> op) {
@@ -1258,6 +1912,7 @@ private:
                             "Unexpected end of request body stream encountered before Content-Length satisfied."));
                         return;
                     }
+                    this_request->record_chunk(actualReadSize, this_request->_get_readbuffer().in_avail());
                     this_request->m_uploaded += static_cast<uint64_t>(actualReadSize);
                     this_request->m_body_buf.commit(actualReadSize);
                     this_request->m_connection->async_write(this_request->m_body_buf,
@@ -1273,6 +1928,110 @@ private:
             });
     }
 
+    // Sends the next `size` bytes of a file body straight from the file to the socket, if the connection is plain TCP.
+    // Returns false when the body has to be read through m_body_buf instead.
+    bool write_file_body(size_t size)
+    {
+        if (m_connection->is_ssl())
+        {
+            return false;
+        }
+
+        auto readbuf = _get_readbuffer();
+        const int fd = web::http::details::sendfile_descriptor(readbuf);
+        const std::streamoff offset = fd == -1 ? -1 : static_cast<std::streamoff>(readbuf.getpos(std::ios_base::in));
+        if (offset < 0)
+        {
+            return false;
+        }
+
+        // Move the read position first: once the bytes are on the wire, the caller may already close the stream
+        readbuf.seekoff(static_cast<std::streamoff>(size), std::ios_base::cur, std::ios_base::in);
+        const auto this_request = shared_from_this();
+        m_connection->async_sendfile(
+            fd,
+            static_cast<uint64_t>(offset),
+            size,
+            [this_request AND_CAPTURE_MEMBER_FUNCTION_POINTERS](const boost::system::error_code& ec, size_t sent) {
+                this_request->m_uploaded += static_cast<uint64_t>(sent);
+                if (ec == boost::asio::error::eof)
+                {
+                    this_request->report_exception(http_exception(
+                        "Unexpected end of request body stream encountered before Content-Length satisfied."));
+                    return;
+                }
+                this_request->record_chunk(sent,
+                                           static_cast<size_t>((std::min)(
+                                               static_cast<uint64_t>(this_request->chunk_size()),
+                                               this_request->m_content_length - this_request->m_uploaded)));
+                this_request->handle_write_large_body(ec);
+            });
+        return true;
+    }
+
+    // Acquires the next part of the body, up to a chunk, if the request stream holds it in memory. Returns its size, or
+    // zero when the body has to be read through m_body_buf instead; a part acquired has to be released.
+    size_t acquire_memory_body(uint8_t*& data)
+    {
+        // a request without a body has no stream to acquire from
+        if (m_uploaded >= m_content_length)
+        {
+            return 0;
+        }
+        auto readbuf = _get_readbuffer();
+        size_t available = 0;
+        if (!readbuf.acquire(data, available) || data == nullptr)
+        {
+            return 0;
+        }
+        const auto size = static_cast<size_t>((std::min)(
+            static_cast<uint64_t>((std::min)(available, chunk_size())), m_content_length - m_uploaded));
+        if (size == 0)
+        {
+            readbuf.release(data, 0);
+        }
+        return size;
+    }
+
+    // Releases a part of the body written from the memory of the request stream, moving its read position past it
+    void memory_body_written(uint8_t* data, size_t size)
+    {
+        auto readbuf = _get_readbuffer();
+        readbuf.release(data, size);
+        m_uploaded += static_cast<uint64_t>(size);
+        record_chunk(size, readbuf.in_avail());
+    }
+
+    // Sends the next part of a body held in memory, such as a shared body, without copying it into m_body_buf.
+    // Returns false when the body has to be read through m_body_buf instead.
+    bool write_memory_body()
+    {
+        uint8_t* data = nullptr;
+        const size_t size = acquire_memory_body(data);
+        if (size == 0)
+        {
+            return false;
+        }
+
+        auto buffer = boost::asio::buffer(static_cast<const void*>(data), size);
+        const auto this_request = shared_from_this();
+        m_connection->async_write(
+            buffer,
+            [this_request, data, size AND_CAPTURE_MEMBER_FUNCTION_POINTERS](const boost::system::error_code& ec,
+                                                                            size_t) {
+                if (ec)
+                {
+                    this_request->_get_readbuffer().release(data, 0);
+                }
+                else
+                {
+                    this_request->memory_body_written(data, size);
+                }
+                this_request->handle_write_large_body(ec);
+            });
+        return true;
+    }
+
     void handle_write_body(const boost::system::error_code& ec)
     {
         if (!ec)
@@ -1292,6 +2051,7 @@ private:
                 }
             }
 
+            record_timing(&http_timing::request_written);
             // Read until the end of entire headers
             m_connection->async_read_until(
                 m_body_buf,
@@ -1309,6 +2069,7 @@ private:
         if (!ec)
         {
             m_timer.reset();
+            record_timing(&http_timing::first_byte);
 
             std::istream response_stream(&m_body_buf);
             response_stream.imbue(std::locale::classic());
@@ -1340,6 +2101,9 @@ private:
                 m_connection->set_keep_alive(false);
             }
 
+            m_endpoint_outcome = endpoint_outcome::responded;
+            m_endpoint_latency = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - m_endpoint_start);
             read_headers();
         }
         else
@@ -1497,8 +2261,7 @@ private:
             if (!needChunked)
             {
                 async_read_until_buffersize(
-                    static_cast<size_t>((std::min)(m_content_length,
-                                                   static_cast<uint64_t>(m_http_client->client_config().chunksize()))),
+                    static_cast<size_t>((std::min)(m_content_length, static_cast<uint64_t>(chunk_size()))),
                     boost::bind(
                         &asio_context::handle_read_content, shared_from_this(), boost::asio::placeholders::error));
             }
@@ -1513,6 +2276,23 @@ private:
         }
     }
 
+    // The size of the next read or write on the connection
+    size_t chunk_size() const
+    {
+        const auto& config = m_http_client->client_config();
+        return config.adaptive_chunksize() ? m_connection->chunk_size(config).size() : config.chunksize();
+    }
+
+    // Records a read or write of `transferred` bytes, after which `ready` more bytes could be transferred at once
+    void record_chunk(size_t transferred, size_t ready)
+    {
+        const auto& config = m_http_client->client_config();
+        if (config.adaptive_chunksize())
+        {
+            m_connection->chunk_size(config).record_chunk(transferred, ready);
+        }
+    }
+
     template<typename ReadHandler>
     void async_read_until_buffersize(size_t size, const ReadHandler& handler)
     {
@@ -1561,12 +2341,17 @@ private:
         }
     }
 
-    bool decompress(const uint8_t* input, size_t input_size, std::vector<uint8_t>& output)
+    // Decompresses input into the response body. If the body is the library-owned producer/consumer buffer, the
+    // output is decoded straight into blocks obtained from its alloc(). Otherwise (e.g. a user-supplied container or
+    // file stream, where an oversized alloc() would leave garbage behind) the output is decoded into m_decompress_buf,
+    // which is kept across chunks; the number of bytes left there for the caller to write out is returned.
+    // Throws if the decompressor reports an error.
+    size_t decompress(const uint8_t* input, size_t input_size, concurrency::streams::streambuf<uint8_t>& output)
     {
         // Need to guard against attempting to decompress when we're already finished or encountered an error!
         if (input == nullptr || input_size == 0)
         {
-            return false;
+            throw std::runtime_error("Failed to decompress the response body");
         }
 
         size_t processed;
@@ -1574,34 +2359,69 @@ private:
         size_t inbytes = 0;
         size_t outbytes = 0;
         bool done;
+        const size_t block_size = (std::max)(input_size * 3, static_cast<size_t>(1024));
 
-        try
+        if (!m_request._get_impl()->_response_stream())
         {
-            output.resize(input_size * 3);
             do
             {
-                if (inbytes)
+                uint8_t* block = output.alloc(block_size);
+                if (block == nullptr)
                 {
-                    output.resize(output.size() + (std::max)(input_size, static_cast<size_t>(1024)));
+                    break;
                 }
-                got = m_decompressor->decompress(input + inbytes,
-                                                 input_size - inbytes,
-                                                 output.data() + outbytes,
-                                                 output.size() - outbytes,
-                                                 web::http::compression::operation_hint::has_more,
-                                                 processed,
-                                                 done);
+
+                try
+                {
+                    got = m_decompressor->decompress(input + inbytes,
+                                                     input_size - inbytes,
+                                                     block,
+                                                     block_size,
+                                                     web::http::compression::operation_hint::has_more,
+                                                     processed,
+                                                     done);
+                }
+                catch (...)
+                {
+                    output.commit(0);
+                    throw;
+                }
+
+                output.commit(got);
                 inbytes += processed;
-                outbytes += got;
-            } while (got && !done);
-            output.resize(outbytes);
+
+                // A block that was not filled up means the decompressor has no more output pending for this input.
+                if (!got || done || (got < block_size && inbytes == input_size))
+                {
+                    return 0;
+                }
+            } while (true);
         }
-        catch (...)
+
+        // Grow the scratch buffer only when it is too small; its size carries over to the following chunks.
+        if (m_decompress_buf.size() < block_size)
         {
-            return false;
+            m_decompress_buf.resize(block_size);
         }
 
-        return true;
+        do
+        {
+            if (outbytes == m_decompress_buf.size())
+            {
+                m_decompress_buf.resize(m_decompress_buf.size() + (std::max)(input_size, static_cast<size_t>(1024)));
+            }
+            got = m_decompressor->decompress(input + inbytes,
+                                             input_size - inbytes,
+                                             m_decompress_buf.data() + outbytes,
+                                             m_decompress_buf.size() - outbytes,
+                                             web::http::compression::operation_hint::has_more,
+                                             processed,
+                                             done);
+            inbytes += processed;
+            outbytes += got;
+        } while (got && !done);
+
+        return outbytes;
     }
 
     void handle_chunk(const boost::system::error_code& ec, int to_read)
@@ -1636,19 +2456,22 @@ private:
                 const auto this_request = shared_from_this();
                 if (m_decompressor)
                 {
-                    std::vector<uint8_t> decompressed;
-
-                    bool boo =
-                        decompress(boost::asio::buffer_cast<const uint8_t*>(m_body_buf.data()), to_read, decompressed);
-                    if (!boo)
+                    size_t decompressed;
+                    try
+                    {
+                        decompressed =
+                            decompress(boost::asio::buffer_cast<const uint8_t*>(m_body_buf.data()), to_read, writeBuffer);
+                    }
+                    catch (...)
                     {
                         report_exception(std::runtime_error("Failed to decompress the response body"));
                         return;
                     }
 
-                    // It is valid for the decompressor to sometimes return an empty output for a given chunk, the data
+                    // Either the output already went straight into the response stream, or it is valid for the
+                    // decompressor to sometimes return an empty output for a given chunk; in the latter case the data
                     // will be flushed when the next chunk is received
-                    if (decompressed.empty())
+                    if (decompressed == 0)
                     {
                         m_body_buf.consume(to_read + CRLF.size()); // consume crlf
                         m_connection->async_read_until(m_body_buf,
@@ -1659,13 +2482,9 @@ private:
                     }
                     else
                     {
-                        // Move the decompressed buffer into a shared_ptr to keep it alive until putn_nocopy completes.
-                        // When VS 2013 support is dropped, this should be changed to a unique_ptr plus a move capture.
-                        auto shared_decompressed = std::make_shared<std::vector<uint8_t>>(std::move(decompressed));
-
-                        writeBuffer.putn_nocopy(shared_decompressed->data(), shared_decompressed->size())
-                            .then([this_request, to_read, shared_decompressed AND_CAPTURE_MEMBER_FUNCTION_POINTERS](
-                                      pplx::task<size_t> op) {
+                        // m_decompress_buf is not touched again until putn_nocopy completes and the next chunk is read.
+                        writeBuffer.putn_nocopy(m_decompress_buf.data(), decompressed)
+                            .then([this_request, to_read AND_CAPTURE_MEMBER_FUNCTION_POINTERS](pplx::task<size_t> op) {
                                 try
                                 {
                                     op.get();
@@ -1732,6 +2551,10 @@ private:
         }
 
         m_timer.reset();
+        if (m_http_client->client_config().adaptive_chunksize())
+        {
+            record_chunk(m_body_buf.size(), m_connection->available());
+        }
         const auto& progress = m_request._get_impl()->_progress_handler();
         if (progress)
         {
@@ -1756,28 +2579,32 @@ private:
 
             if (m_decompressor)
             {
-                std::vector<uint8_t> decompressed;
-
-                bool boo =
-                    decompress(boost::asio::buffer_cast<const uint8_t*>(m_body_buf.data()), read_size, decompressed);
-                if (!boo)
+                size_t decompressed;
+                try
+                {
+                    decompressed =
+                        decompress(boost::asio::buffer_cast<const uint8_t*>(m_body_buf.data()), read_size, writeBuffer);
+                }
+                catch (...)
                 {
                     this_request->report_exception(std::runtime_error("Failed to decompress the response body"));
                     return;
                 }
 
-                // It is valid for the decompressor to sometimes return an empty output for a given chunk, the data will
+                // Either the output already went straight into the response stream, or it is valid for the
+                // decompressor to sometimes return an empty output for a given chunk; in the latter case the data will
                 // be flushed when the next chunk is received
-                if (decompressed.empty())
+                if (decompressed == 0)
                 {
                     try
                     {
                         this_request->m_downloaded += static_cast<uint64_t>(read_size);
+                        this_request->m_body_buf.consume(read_size);
 
                         this_request->async_read_until_buffersize(
-                            static_cast<size_t>((std::min)(
-                                static_cast<uint64_t>(this_request->m_http_client->client_config().chunksize()),
-                                this_request->m_content_length - this_request->m_downloaded)),
+                            static_cast<size_t>(
+                                (std::min)(static_cast<uint64_t>(this_request->chunk_size()),
+                                           this_request->m_content_length - this_request->m_downloaded)),
                             boost::bind(
                                 &asio_context::handle_read_content, this_request, boost::asio::placeholders::error));
                     }
@@ -1789,13 +2616,9 @@ private:
                 }
                 else
                 {
-                    // Move the decompressed buffer into a shared_ptr to keep it alive until putn_nocopy completes.
-                    // When VS 2013 support is dropped, this should be changed to a unique_ptr plus a move capture.
-                    auto shared_decompressed = std::make_shared<std::vector<uint8_t>>(std::move(decompressed));
-
-                    writeBuffer.putn_nocopy(shared_decompressed->data(), shared_decompressed->size())
-                        .then([this_request, read_size, shared_decompressed AND_CAPTURE_MEMBER_FUNCTION_POINTERS](
-                                  pplx::task<size_t> op) {
+                    // m_decompress_buf is not touched again until putn_nocopy completes and more content is read.
+                    writeBuffer.putn_nocopy(m_decompress_buf.data(), decompressed)
+                        .then([this_request, read_size AND_CAPTURE_MEMBER_FUNCTION_POINTERS](pplx::task<size_t> op) {
                             size_t writtenSize = 0;
                             (void)writtenSize;
                             try
@@ -1804,9 +2627,9 @@ private:
                                 this_request->m_downloaded += static_cast<uint64_t>(read_size);
                                 this_request->m_body_buf.consume(read_size);
                                 this_request->async_read_until_buffersize(
-                                    static_cast<size_t>((std::min)(
-                                        static_cast<uint64_t>(this_request->m_http_client->client_config().chunksize()),
-                                        this_request->m_content_length - this_request->m_downloaded)),
+                                    static_cast<size_t>(
+                                        (std::min)(static_cast<uint64_t>(this_request->chunk_size()),
+                                                   this_request->m_content_length - this_request->m_downloaded)),
                                     boost::bind(&asio_context::handle_read_content,
                                                 this_request,
                                                 boost::asio::placeholders::error));
@@ -1830,9 +2653,9 @@ private:
                             this_request->m_downloaded += static_cast<uint64_t>(writtenSize);
                             this_request->m_body_buf.consume(writtenSize);
                             this_request->async_read_until_buffersize(
-                                static_cast<size_t>((std::min)(
-                                    static_cast<uint64_t>(this_request->m_http_client->client_config().chunksize()),
-                                    this_request->m_content_length - this_request->m_downloaded)),
+                                static_cast<size_t>(
+                                    (std::min)(static_cast<uint64_t>(this_request->chunk_size()),
+                                               this_request->m_content_length - this_request->m_downloaded)),
                                 boost::bind(&asio_context::handle_read_content,
                                             this_request,
                                             boost::asio::placeholders::error));
@@ -1852,15 +2675,12 @@ private:
         }
     }
 
-    // Simple timer class wrapping Boost deadline timer.
-    // Closes the connection when timer fires.
+    // Timer closing the connection when no progress is made for the timeout duration. It is filed in the shared timer
+    // wheel, so resetting it after every read and write only stores a new deadline.
     class timeout_timer
     {
     public:
-        timeout_timer(const std::chrono::microseconds& timeout)
-            : m_duration(timeout.count()), m_state(created), m_timer(crossplat::threadpool::shared_instance().service())
-        {
-        }
+        timeout_timer(const std::chrono::microseconds& timeout) : m_duration(timeout), m_state(created) {}
 
         void set_ctx(const std::weak_ptr<asio_context>& ctx) { m_ctx = ctx; }
 
@@ -1870,25 +2690,18 @@ private:
             assert(!m_ctx.expired());
             m_state = started;
 
-            m_timer.expires_from_now(m_duration);
             auto ctx = m_ctx;
-            m_timer.async_wait([ctx AND_CAPTURE_MEMBER_FUNCTION_POINTERS](const boost::system::error_code& ec) {
-                handle_timeout(ec, ctx);
-            });
+            m_entry = asio_timer_wheel::shared_instance()->arm(
+                m_duration, [ctx AND_CAPTURE_MEMBER_FUNCTION_POINTERS]() { handle_timeout(ctx); });
         }
 
         void reset()
         {
             assert(m_state == started || m_state == timedout);
             assert(!m_ctx.expired());
-            if (m_timer.expires_from_now(m_duration) > 0)
+            if (m_state == started)
             {
-                // The existing handler was canceled so schedule a new one.
-                assert(m_state == started);
-                auto ctx = m_ctx;
-                m_timer.async_wait([ctx AND_CAPTURE_MEMBER_FUNCTION_POINTERS](const boost::system::error_code& ec) {
-                    handle_timeout(ec, ctx);
-                });
+                asio_timer_wheel::shared_instance()->extend(*m_entry, m_duration);
             }
         }
 
@@ -1899,18 +2712,21 @@ private:
         void stop()
         {
             m_state = stopped;
-            m_timer.cancel();
+            if (m_entry)
+            {
+                asio_timer_wheel::shared_instance()->cancel(*m_entry);
+            }
         }
 
-        static void handle_timeout(const boost::system::error_code& ec, const std::weak_ptr<asio_context>& ctx)
+        static void handle_timeout(const std::weak_ptr<asio_context>& ctx)
         {
-            if (!ec)
+            auto shared_ctx = ctx.lock();
+            if (shared_ctx)
             {
-                auto shared_ctx = ctx.lock();
-                if (shared_ctx)
+                // The wheel may already have taken the entry when the timer was stopped
+                auto expected = started;
+                if (shared_ctx->m_timer.m_state.compare_exchange_strong(expected, timedout))
                 {
-                    assert(shared_ctx->m_timer.m_state != timedout);
-                    shared_ctx->m_timer.m_state = timedout;
                     shared_ctx->m_connection->close();
                 }
             }
@@ -1925,22 +2741,41 @@ private:
             timedout
         };
 
-#if (defined(ANDROID) || defined(__ANDROID__)) && !defined(_LIBCPP_VERSION)
-        boost::chrono::microseconds m_duration;
-#else
         std::chrono::microseconds m_duration;
-#endif
         std::atomic<timer_state> m_state;
         std::weak_ptr<asio_context> m_ctx;
-        boost::asio::steady_timer m_timer;
+        std::shared_ptr<asio_timer_wheel::entry> m_entry;
     };
 
     uint64_t m_content_length;
     bool m_needChunked;
+    bool m_expect_continue;
+    std::mutex m_continue_lock;
+    bool m_awaiting_continue;
+    std::shared_ptr<asio_timer_wheel::entry> m_continue_timer;
     timeout_timer m_timer;
     tcp::resolver m_resolver;
     boost::asio::streambuf m_body_buf;
+    std::vector<uint8_t> m_decompress_buf;
     std::shared_ptr<asio_connection> m_connection;
+    // Set once the connection is returned to the pool; the context keeps its reference until it is destroyed
+    bool m_connection_released;
+
+    // What the request showed about the endpoint of a load balanced client it was sent to
+    enum class endpoint_outcome
+    {
+        pending,
+        responded,
+        connect_failed
+    };
+    size_t m_endpoint;
+    endpoint_outcome m_endpoint_outcome;
+    std::chrono::steady_clock::time_point m_endpoint_start;
+    std::chrono::microseconds m_endpoint_latency;
+
+    // Set for contexts which only open a tunnel for the pool, and once the tunnel is open
+    bool m_tunnel_only;
+    bool m_tunnel_open;
 
 #ifdef CPPREST_PLATFORM_ASIO_CERT_VERIFICATION_AVAILABLE
     bool m_openssl_failed;
@@ -1977,6 +2812,55 @@ void asio_client::send_request(const std::shared_ptr<request_context>& request_c
     ctx->start_request();
 }
 
+pplx::task<void> asio_client::open_proxy_tunnels(size_t count)
+{
+    if (!tunnels_through_proxy())
+    {
+        return pplx::task_from_result();
+    }
+
+    auto self = std::static_pointer_cast<_http_client_communicator>(shared_from_this());
+    std::vector<std::shared_ptr<asio_context>> contexts;
+    for (size_t i = 0; i < count; ++i)
+    {
+        http_request request(U("CONNECT"));
+        auto connection = obtain_connection(request, endpoint_balancer::npos, false);
+        auto ctx = std::make_shared<asio_context>(self, request, connection, endpoint_balancer::npos);
+        ctx->m_timer.set_ctx(std::weak_ptr<asio_context>(ctx));
+        ctx->m_tunnel_only = true;
+        contexts.push_back(std::move(ctx));
+    }
+
+    // Every tunnel is waited for, so none of them fails unobserved
+    std::vector<pplx::task<std::exception_ptr>> tunnels;
+    for (auto& ctx : contexts)
+    {
+        tunnels.push_back(pplx::create_task(ctx->m_request_completion).then([](pplx::task<http_response> opened) {
+            try
+            {
+                opened.wait();
+            }
+            catch (...)
+            {
+                return std::current_exception();
+            }
+            return std::exception_ptr();
+        }));
+        ctx->open_tunnel();
+    }
+    contexts.clear();
+
+    return pplx::when_all(tunnels.begin(), tunnels.end()).then([](std::vector<std::exception_ptr> errors) {
+        for (const auto& error : errors)
+        {
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+        }
+    });
+}
+
 static bool is_retrieval_redirection(status_code code)
 {
     // See https://tools.ietf.org/html/rfc7231#section-6.4
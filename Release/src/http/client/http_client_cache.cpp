@@ -0,0 +1,538 @@
+/***
+ * Copyright (C) Microsoft. All rights reserved.
+ * Licensed under the MIT license. See LICENSE.txt file in the project root for full license information.
+ *
+ * =+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+ *
+ * HTTP Library: Client-side private response cache pipeline stage (RFC 7234)
+ *
+ * For the latest on this and related APIs, please see: https://github.com/Microsoft/cpprestsdk
+ *
+ * =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+ ****/
+
+#include "stdafx.h"
+
+#include "cpprest/containerstream.h"
+#include "cpprest/rawptrstream.h"
+#include "../common/internal_http_helpers.h"
+#include "http_client_impl.h"
+#include <list>
+#include <unordered_map>
+
+using namespace web;
+using namespace web::http;
+
+namespace web
+{
+namespace http
+{
+namespace client
+{
+namespace details
+{
+namespace
+{
+typedef std::shared_ptr<const std::vector<uint8_t>> body_ptr;
+typedef std::map<utility::string_t, utility::string_t> directives;
+
+const int64_t no_lifetime = -1;
+
+// Parses a Cache-Control header into lower-case directive names and their unquoted arguments
+directives parse_cache_control(const http_headers& headers)
+{
+    directives result;
+    utility::string_t value;
+    if (!headers.match(header_names::cache_control, value))
+    {
+        return result;
+    }
+
+    size_t pos = 0;
+    while (pos < value.size())
+    {
+        auto end = value.find(_XPLATSTR(','), pos);
+        if (end == utility::string_t::npos)
+        {
+            end = value.size();
+        }
+
+        auto directive = value.substr(pos, end - pos);
+        utility::string_t argument;
+        auto equals = directive.find(_XPLATSTR('='));
+        if (equals != utility::string_t::npos)
+        {
+            argument = directive.substr(equals + 1);
+            directive.resize(equals);
+            http::details::trim_whitespace(argument);
+            if (argument.size() >= 2 && argument.front() == _XPLATSTR('"') && argument.back() == _XPLATSTR('"'))
+            {
+                argument = argument.substr(1, argument.size() - 2);
+            }
+        }
+        http::details::trim_whitespace(directive);
+        if (!directive.empty())
+        {
+            utility::details::inplace_tolower(directive);
+            result[directive] = argument;
+        }
+        pos = end + 1;
+    }
+    return result;
+}
+
+// Parses a delta-seconds value, returning no_lifetime if it is malformed
+int64_t parse_delta_seconds(const utility::string_t& value)
+{
+    if (value.empty() ||
+        !std::all_of(value.begin(), value.end(), [](utility::char_t ch) { return ch >= '0' && ch <= '9'; }))
+    {
+        return no_lifetime;
+    }
+    return utility::conversions::details::scan_string<int64_t>(value);
+}
+
+// Gets the delta-seconds argument of a directive, or no_lifetime if it is absent or malformed
+int64_t delta_seconds(const directives& dirs, const utility::char_t* name)
+{
+    auto it = dirs.find(name);
+    return it == dirs.end() ? no_lifetime : parse_delta_seconds(it->second);
+}
+
+// Gets an HTTP-date header in seconds since the epoch, or no_lifetime if it is absent or malformed
+int64_t date_seconds(const http_headers& headers, const utility::string_t& name)
+{
+    utility::string_t value;
+    if (!headers.match(name, value))
+    {
+        return no_lifetime;
+    }
+    auto date = utility::datetime::from_string(value, utility::datetime::RFC_1123);
+    if (!date.is_initialized())
+    {
+        return no_lifetime;
+    }
+    return static_cast<int64_t>(date.to_interval() / 10000000);
+}
+
+// Status codes which are cacheable by default, per RFC 7231 section 6.1
+bool is_cacheable_status(status_code code)
+{
+    switch (code)
+    {
+        case status_codes::OK:
+        case status_codes::NonAuthInfo:
+        case status_codes::NoContent:
+        case status_codes::MultipleChoices:
+        case status_codes::MovedPermanently:
+        case status_codes::NotFound:
+        case status_codes::MethodNotAllowed:
+        case status_codes::Gone:
+        case status_codes::RequestUriTooLarge:
+        case status_codes::NotImplemented: return true;
+        default: return false;
+    }
+}
+
+// Splits the Vary header into the names of the request headers which select a stored response
+std::vector<utility::string_t> vary_names(const http_headers& headers)
+{
+    std::vector<utility::string_t> names;
+    utility::string_t value;
+    if (headers.match(header_names::vary, value))
+    {
+        size_t pos = 0;
+        while (pos < value.size())
+        {
+            auto end = value.find(_XPLATSTR(','), pos);
+            if (end == utility::string_t::npos)
+            {
+                end = value.size();
+            }
+            auto name = value.substr(pos, end - pos);
+            http::details::trim_whitespace(name);
+            if (!name.empty())
+            {
+                names.push_back(std::move(name));
+            }
+            pos = end + 1;
+        }
+    }
+    return names;
+}
+
+utility::string_t variant_key(const http_request& request, const std::vector<utility::string_t>& names)
+{
+    utility::string_t key;
+    for (const auto& name : names)
+    {
+        utility::string_t value;
+        key.push_back(_XPLATSTR('\n'));
+        if (request.headers().match(name, value))
+        {
+            key.push_back(_XPLATSTR(':'));
+            key.append(value);
+        }
+    }
+    return key;
+}
+
+struct cache_entry
+{
+    utility::string_t m_key;
+    utility::string_t m_variant;
+    std::vector<utility::string_t> m_vary;
+
+    status_code m_status;
+    utility::string_t m_reason;
+    http_headers m_headers;
+    body_ptr m_body;
+
+    // Freshness, in seconds: the age when stored, the freshness lifetime, and when it was stored
+    int64_t m_initial_age;
+    int64_t m_lifetime;
+    std::chrono::steady_clock::time_point m_stored_at;
+    bool m_must_revalidate;
+
+    size_t m_size;
+    std::list<std::shared_ptr<cache_entry>>::iterator m_lru;
+
+    int64_t age() const
+    {
+        return m_initial_age +
+               std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - m_stored_at).count();
+    }
+
+    bool has_validator() const
+    {
+        return m_headers.has(header_names::etag) || m_headers.has(header_names::last_modified);
+    }
+};
+
+class cache_handler : public http_pipeline_stage
+{
+public:
+    cache_handler(size_t max_bytes) : m_max_bytes(max_bytes), m_bytes(0) {}
+
+    virtual pplx::task<http_response> propagate(http_request request) override
+    {
+        auto self = std::static_pointer_cast<cache_handler>(shared_from_this());
+        const auto& mtd = request.method();
+        if (mtd != methods::GET)
+        {
+            if (mtd == methods::HEAD || mtd == methods::OPTIONS || mtd == methods::TRCE)
+            {
+                return next_stage()->propagate(request);
+            }
+
+            // A successful unsafe request invalidates what is stored for its URI
+            auto key = request.absolute_uri().to_string();
+            return next_stage()->propagate(request).then([self, key](http_response response) {
+                if (response.status_code() < status_codes::BadRequest)
+                {
+                    self->invalidate(key);
+                }
+                return response;
+            });
+        }
+
+        auto& impl = *request._get_impl();
+        const auto request_directives = parse_cache_control(request.headers());
+        if (impl.instream() || impl._response_stream() || impl._progress_handler() ||
+            request_directives.count(_XPLATSTR("no-store")) || request.headers().has(header_names::if_none_match) ||
+            request.headers().has(header_names::if_modified_since))
+        {
+            // The caller handles these responses themselves
+            return next_stage()->propagate(request);
+        }
+
+        auto key = request.absolute_uri().to_string();
+        auto entry = lookup(key, request);
+        if (entry && is_fresh(*entry, request, request_directives))
+        {
+            // Served entirely from memory, without scheduling any work
+            return pplx::task_from_result(make_response(*entry));
+        }
+
+        if (request_directives.count(_XPLATSTR("only-if-cached")))
+        {
+            return pplx::task_from_result(http_response(status_codes::GatewayTimeout));
+        }
+
+        if (entry && entry->has_validator())
+        {
+            utility::string_t validator;
+            if (entry->m_headers.match(header_names::etag, validator))
+            {
+                request.headers().add(header_names::if_none_match, validator);
+            }
+            if (entry->m_headers.match(header_names::last_modified, validator))
+            {
+                request.headers().add(header_names::if_modified_since, validator);
+            }
+        }
+
+        auto request_time = std::chrono::steady_clock::now();
+        return next_stage()->propagate(request).then(
+            [self, request, key, entry, request_time](http_response response) -> pplx::task<http_response> {
+                if (entry && response.status_code() == status_codes::NotModified)
+                {
+                    return pplx::task_from_result(self->refresh(entry, response, request_time));
+                }
+                return self->store(request, key, response, request_time);
+            });
+    }
+
+private:
+    std::shared_ptr<cache_entry> lookup(const utility::string_t& key, const http_request& request)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        auto it = m_entries.find(key);
+        if (it == m_entries.end())
+        {
+            return nullptr;
+        }
+
+        for (const auto& entry : it->second)
+        {
+            if (entry->m_variant == variant_key(request, entry->m_vary))
+            {
+                m_lru.splice(m_lru.begin(), m_lru, entry->m_lru);
+                return entry;
+            }
+        }
+        return nullptr;
+    }
+
+    static bool is_fresh(const cache_entry& entry, const http_request& request, const directives& request_directives)
+    {
+        if (entry.m_must_revalidate || request_directives.count(_XPLATSTR("no-cache")))
+        {
+            return false;
+        }
+
+        utility::string_t pragma;
+        if (request_directives.empty() && request.headers().match(header_names::pragma, pragma) &&
+            pragma.find(_XPLATSTR("no-cache")) != utility::string_t::npos)
+        {
+            return false;
+        }
+
+        auto age = entry.age();
+        auto max_age = delta_seconds(request_directives, _XPLATSTR("max-age"));
+        if (max_age != no_lifetime && age > max_age)
+        {
+            return false;
+        }
+        auto min_fresh = delta_seconds(request_directives, _XPLATSTR("min-fresh"));
+        return age + (min_fresh == no_lifetime ? 0 : min_fresh) < entry.m_lifetime;
+    }
+
+    // Computes the freshness lifetime of a response per RFC 7234 section 4.2.1, or no_lifetime if it must always be
+    // revalidated
+    static int64_t freshness_lifetime(const http_response& response, const directives& response_directives)
+    {
+        auto max_age = delta_seconds(response_directives, _XPLATSTR("max-age"));
+        if (max_age != no_lifetime)
+        {
+            return max_age;
+        }
+
+        const auto& headers = response.headers();
+        auto date = date_seconds(headers, header_names::date);
+        if (date == no_lifetime)
+        {
+            date = static_cast<int64_t>(utility::datetime::utc_timestamp());
+        }
+
+        if (headers.has(header_names::expires))
+        {
+            // An invalid date, such as "0", means already expired
+            auto expires = date_seconds(headers, header_names::expires);
+            return expires == no_lifetime ? 0 : (std::max)(expires - date, int64_t(0));
+        }
+
+        // Heuristic freshness: a tenth of the time since the resource last changed
+        auto last_modified = date_seconds(headers, header_names::last_modified);
+        if (last_modified != no_lifetime && last_modified < date)
+        {
+            return (date - last_modified) / 10;
+        }
+        return no_lifetime;
+    }
+
+    // The age of a response when it arrived: its Age header plus the time it took to arrive
+    static int64_t initial_age(const http_response& response, const std::chrono::steady_clock::time_point& request_time)
+    {
+        utility::string_t value;
+        auto age = response.headers().match(header_names::age, value) ? parse_delta_seconds(value) : no_lifetime;
+        auto delay = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - request_time);
+        return (age == no_lifetime ? 0 : age) + delay.count();
+    }
+
+    pplx::task<http_response> store(const http_request& request,
+                                     const utility::string_t& key,
+                                     const http_response& response,
+                                     const std::chrono::steady_clock::time_point& request_time)
+    {
+        const auto response_directives = parse_cache_control(response.headers());
+        if (!is_cacheable_status(response.status_code()) || response_directives.count(_XPLATSTR("no-store")))
+        {
+            return pplx::task_from_result(response);
+        }
+
+        auto vary = vary_names(response.headers());
+        auto lifetime = freshness_lifetime(response, response_directives);
+        const bool has_validator =
+            response.headers().has(header_names::etag) || response.headers().has(header_names::last_modified);
+        if (std::find(vary.begin(), vary.end(), _XPLATSTR("*")) != vary.end() ||
+            (lifetime == no_lifetime && !has_validator))
+        {
+            return pplx::task_from_result(response);
+        }
+
+        auto entry = std::make_shared<cache_entry>();
+        entry->m_key = key;
+        entry->m_variant = variant_key(request, vary);
+        entry->m_vary = std::move(vary);
+        entry->m_status = response.status_code();
+        entry->m_reason = response.reason_phrase();
+        entry->m_headers = response.headers();
+        entry->m_initial_age = initial_age(response, request_time);
+        entry->m_lifetime = lifetime == no_lifetime ? 0 : lifetime;
+        entry->m_stored_at = std::chrono::steady_clock::now();
+        entry->m_must_revalidate = response_directives.count(_XPLATSTR("no-cache")) != 0;
+
+        // The body is buffered once, and each hit reads it in place
+        auto self = std::static_pointer_cast<cache_handler>(shared_from_this());
+        auto buffer = std::make_shared<concurrency::streams::container_buffer<std::vector<uint8_t>>>();
+        return response.body().read_to_end(*buffer).then([self, entry, buffer](size_t) {
+            entry->m_body = std::make_shared<const std::vector<uint8_t>>(std::move(buffer->collection()));
+            self->insert(entry);
+            return make_response(*entry);
+        });
+    }
+
+    // Updates a stored response from a 304 Not Modified response, per RFC 7234 section 4.3.4; stored entries are
+    // never modified in place, since hits read them without holding the lock
+    http_response refresh(const std::shared_ptr<cache_entry>& entry,
+                          const http_response& not_modified,
+                          const std::chrono::steady_clock::time_point& request_time)
+    {
+        auto updated = std::make_shared<cache_entry>(*entry);
+        for (const auto& header : not_modified.headers())
+        {
+            if (header.first != header_names::content_length)
+            {
+                updated->m_headers[header.first] = header.second;
+            }
+        }
+
+        auto lifetime = freshness_lifetime(not_modified, parse_cache_control(updated->m_headers));
+        updated->m_initial_age = initial_age(not_modified, request_time);
+        updated->m_lifetime = lifetime == no_lifetime ? 0 : lifetime;
+        updated->m_stored_at = std::chrono::steady_clock::now();
+        insert(updated);
+        return make_response(*updated);
+    }
+
+    void insert(const std::shared_ptr<cache_entry>& entry)
+    {
+        entry->m_size = entry->m_key.size() + entry->m_variant.size() + entry->m_body->size();
+        for (const auto& header : entry->m_headers)
+        {
+            entry->m_size += header.first.size() + header.second.size();
+        }
+
+        std::lock_guard<std::mutex> lock(m_lock);
+        auto& variants = m_entries[entry->m_key];
+        for (auto it = variants.begin(); it != variants.end(); ++it)
+        {
+            if ((*it)->m_variant == entry->m_variant)
+            {
+                remove(*it);
+                variants.erase(it);
+                break;
+            }
+        }
+
+        if (entry->m_size > m_max_bytes)
+        {
+            if (variants.empty())
+            {
+                m_entries.erase(entry->m_key);
+            }
+            return;
+        }
+
+        variants.push_back(entry);
+        m_lru.push_front(entry);
+        entry->m_lru = m_lru.begin();
+        m_bytes += entry->m_size;
+
+        // Evict the least recently used responses until the new one fits
+        while (m_bytes > m_max_bytes)
+        {
+            auto victim = m_lru.back();
+            remove(victim);
+            auto victim_variants = m_entries.find(victim->m_key);
+            victim_variants->second.erase(
+                std::find(victim_variants->second.begin(), victim_variants->second.end(), victim));
+            if (victim_variants->second.empty())
+            {
+                m_entries.erase(victim_variants);
+            }
+        }
+    }
+
+    void invalidate(const utility::string_t& key)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        auto it = m_entries.find(key);
+        if (it != m_entries.end())
+        {
+            for (const auto& entry : it->second)
+            {
+                remove(entry);
+            }
+            m_entries.erase(it);
+        }
+    }
+
+    // Removes an entry from the LRU list and the byte count; the caller removes it from m_entries
+    void remove(const std::shared_ptr<cache_entry>& entry)
+    {
+        m_bytes -= entry->m_size;
+        m_lru.erase(entry->m_lru);
+    }
+
+    static http_response make_response(const cache_entry& entry)
+    {
+        http_response response(entry.m_status);
+        response.set_reason_phrase(entry.m_reason);
+        response.headers() = entry.m_headers;
+        response.headers()[header_names::age] = utility::conversions::details::print_string(entry.age());
+
+        auto& impl = *response._get_impl();
+        impl.set_instream(concurrency::streams::rawptr_buffer<uint8_t>(entry.m_body));
+        impl._complete(entry.m_body->size());
+        return response;
+    }
+
+    const size_t m_max_bytes;
+
+    std::mutex m_lock;
+    size_t m_bytes;
+    std::list<std::shared_ptr<cache_entry>> m_lru;
+    std::unordered_map<utility::string_t, std::vector<std::shared_ptr<cache_entry>>> m_entries;
+};
+} // namespace
+
+std::shared_ptr<http_pipeline_stage> create_cache_stage(size_t max_bytes)
+{
+    return std::make_shared<cache_handler>(max_bytes);
+}
+} // namespace details
+} // namespace client
+} // namespace http
+} // namespace web
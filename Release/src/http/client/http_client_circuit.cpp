@@ -0,0 +1,320 @@
+/***
+ * Copyright (C) Microsoft. All rights reserved.
+ * Licensed under the MIT license. See LICENSE.txt file in the project root for full license information.
+ *
+ * =+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+ *
+ * HTTP Library: Client-side circuit breaker pipeline stage
+ *
+ * For the latest on this and related APIs, please see: https://github.com/Microsoft/cpprestsdk
+ *
+ * =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+ ****/
+
+#include "stdafx.h"
+
+#include "http_client_impl.h"
+#include <atomic>
+#include <deque>
+#include <map>
+
+using namespace web;
+using namespace web::http;
+
+namespace web
+{
+namespace http
+{
+namespace client
+{
+namespace details
+{
+// The circuits of a circuit_breaker, one per host, shared by the pipeline stages of the clients it is set on
+class circuit_breaker_impl
+{
+public:
+    // How a request sent through a circuit ended; canceled requests say nothing about the host
+    enum class outcome
+    {
+        succeeded,
+        failed,
+        ignored
+    };
+
+    // Whether a request may be sent, and what to record its outcome against once it completes
+    struct ticket
+    {
+        bool m_admitted;
+        bool m_trial;
+        unsigned long long m_generation;
+    };
+
+    circuit_breaker_impl(const circuit_breaker_policy& policy) : m_policy(policy), m_rejected(0) {}
+
+    const circuit_breaker_policy& policy() const { return m_policy; }
+    size_t rejected() const { return m_rejected; }
+
+    circuit_state state(const utility::string_t& host) const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        auto it = m_circuits.find(host);
+        return it == m_circuits.end() ? circuit_state::closed : it->second.m_state;
+    }
+
+    // Admits a request to the host unless its circuit is open; once the open duration is over, the circuit turns
+    // half open and admits the trial requests
+    ticket admit(const utility::string_t& host)
+    {
+        ticket result {true, false, 0};
+        bool half_opened = false;
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            auto& entry = m_circuits[host];
+            if (entry.m_state == circuit_state::open &&
+                std::chrono::steady_clock::now() - entry.m_opened >= m_policy.open_duration())
+            {
+                change_state(entry, circuit_state::half_open);
+                half_opened = true;
+            }
+
+            if (entry.m_state == circuit_state::half_open)
+            {
+                result.m_admitted = entry.m_trials < m_policy.half_open_requests();
+                result.m_trial = result.m_admitted;
+                entry.m_trials += result.m_admitted ? 1 : 0;
+            }
+            else
+            {
+                result.m_admitted = entry.m_state == circuit_state::closed;
+            }
+            result.m_generation = entry.m_generation;
+        }
+
+        if (half_opened)
+        {
+            report(host, circuit_state::half_open);
+        }
+        if (!result.m_admitted)
+        {
+            ++m_rejected;
+        }
+        return result;
+    }
+
+    // Records the outcome of an admitted request, opening or closing the circuit
+    void record(const utility::string_t& host, const ticket& admitted, outcome result)
+    {
+        bool changed = false;
+        circuit_state state;
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            auto& entry = m_circuits[host];
+
+            // The circuit changed state since the request was admitted, so its outcome is stale
+            if (entry.m_generation != admitted.m_generation)
+            {
+                return;
+            }
+
+            if (admitted.m_trial)
+            {
+                if (result == outcome::ignored)
+                {
+                    --entry.m_trials;
+                }
+                else if (result == outcome::failed)
+                {
+                    open(entry);
+                    changed = true;
+                }
+                else if (++entry.m_trial_successes >= m_policy.half_open_requests())
+                {
+                    change_state(entry, circuit_state::closed);
+                    changed = true;
+                }
+            }
+            else if (result != outcome::ignored)
+            {
+                const bool failed = result == outcome::failed;
+                entry.m_window.push_back(failed);
+                entry.m_failures += failed ? 1 : 0;
+                if (entry.m_window.size() > m_policy.window_size())
+                {
+                    entry.m_failures -= entry.m_window.front() ? 1 : 0;
+                    entry.m_window.pop_front();
+                }
+
+                const size_t minimum = (std::min)(m_policy.minimum_requests(), m_policy.window_size());
+                if (entry.m_window.size() >= (std::max)(minimum, static_cast<size_t>(1)) &&
+                    static_cast<double>(entry.m_failures) >=
+                        m_policy.failure_rate_threshold() * static_cast<double>(entry.m_window.size()))
+                {
+                    open(entry);
+                    changed = true;
+                }
+            }
+            state = entry.m_state;
+        }
+
+        if (changed)
+        {
+            report(host, state);
+        }
+    }
+
+private:
+    struct circuit
+    {
+        circuit_state m_state {circuit_state::closed};
+        // Bumped on every change of state, so that requests admitted before it are not recorded after it
+        unsigned long long m_generation {0};
+        std::chrono::steady_clock::time_point m_opened;
+
+        // The outcomes of the most recent requests while closed, true for a failure
+        std::deque<bool> m_window;
+        size_t m_failures {0};
+
+        // The trial requests admitted while half open, and those of them which succeeded
+        size_t m_trials {0};
+        size_t m_trial_successes {0};
+    };
+
+    void change_state(circuit& entry, circuit_state state)
+    {
+        entry.m_state = state;
+        ++entry.m_generation;
+        entry.m_window.clear();
+        entry.m_failures = 0;
+        entry.m_trials = 0;
+        entry.m_trial_successes = 0;
+    }
+
+    void open(circuit& entry)
+    {
+        change_state(entry, circuit_state::open);
+        entry.m_opened = std::chrono::steady_clock::now();
+    }
+
+    void report(const utility::string_t& host, circuit_state state)
+    {
+        const auto& callback = m_policy.state_callback();
+        if (callback)
+        {
+            callback(host, state);
+        }
+    }
+
+    const circuit_breaker_policy m_policy;
+    std::atomic<size_t> m_rejected;
+
+    mutable std::mutex m_lock;
+    std::map<utility::string_t, circuit> m_circuits;
+};
+
+namespace
+{
+// The host a client sends its requests to, as "host:port"
+utility::string_t circuit_host(const uri& base_uri)
+{
+    int port = base_uri.port();
+    if (port <= 0)
+    {
+        port = base_uri.scheme() == _XPLATSTR("https") || base_uri.scheme() == _XPLATSTR("wss") ? 443 : 80;
+    }
+    return base_uri.host() + _XPLATSTR(":") + utility::conversions::details::to_string_t(port);
+}
+
+class circuit_breaker_handler : public http_pipeline_stage
+{
+public:
+    circuit_breaker_handler(const std::shared_ptr<circuit_breaker_impl>& breaker, const uri& base_uri)
+        : m_breaker(breaker), m_host(circuit_host(base_uri))
+    {
+    }
+
+    virtual pplx::task<http_response> propagate(http_request request) override
+    {
+        const auto admitted = m_breaker->admit(m_host);
+        if (!admitted.m_admitted)
+        {
+            return pplx::task_from_exception<http_response>(
+                http_exception(std::make_error_code(std::errc::resource_unavailable_try_again),
+                               "The circuit to " + utility::conversions::to_utf8string(m_host) +
+                                   " is open, so the request was not sent"));
+        }
+
+        auto breaker = m_breaker;
+        auto host = m_host;
+        const auto slow_call_duration = breaker->policy().slow_call_duration();
+        const auto start = std::chrono::steady_clock::now();
+        pplx::task<http_response> response;
+        try
+        {
+            response = next_stage()->propagate(request);
+        }
+        catch (...)
+        {
+            breaker->record(host, admitted, circuit_breaker_impl::outcome::failed);
+            throw;
+        }
+
+        return response.then([breaker, host, admitted, slow_call_duration, start](pplx::task<http_response> sent) {
+            try
+            {
+                auto response = sent.get();
+                const bool slow = slow_call_duration.count() > 0 &&
+                                  std::chrono::steady_clock::now() - start > slow_call_duration;
+                breaker->record(host,
+                                admitted,
+                                response.status_code() >= 500 || slow ? circuit_breaker_impl::outcome::failed
+                                                                      : circuit_breaker_impl::outcome::succeeded);
+                return response;
+            }
+            catch (const http_exception& e)
+            {
+                breaker->record(host,
+                                admitted,
+                                e.error_code() == std::errc::operation_canceled
+                                    ? circuit_breaker_impl::outcome::ignored
+                                    : circuit_breaker_impl::outcome::failed);
+                throw;
+            }
+            catch (const pplx::task_canceled&)
+            {
+                breaker->record(host, admitted, circuit_breaker_impl::outcome::ignored);
+                throw;
+            }
+            catch (...)
+            {
+                breaker->record(host, admitted, circuit_breaker_impl::outcome::failed);
+                throw;
+            }
+        });
+    }
+
+private:
+    const std::shared_ptr<circuit_breaker_impl> m_breaker;
+    const utility::string_t m_host;
+};
+} // namespace
+
+std::shared_ptr<http_pipeline_stage> create_circuit_breaker_stage(const std::shared_ptr<circuit_breaker>& breaker,
+                                                                  const uri& base_uri)
+{
+    return std::make_shared<circuit_breaker_handler>(breaker->_get_impl(), base_uri);
+}
+} // namespace details
+
+circuit_breaker::circuit_breaker(const circuit_breaker_policy& policy)
+    : m_impl(std::make_shared<details::circuit_breaker_impl>(policy))
+{
+}
+
+const circuit_breaker_policy& circuit_breaker::policy() const { return m_impl->policy(); }
+
+circuit_state circuit_breaker::state(const utility::string_t& host) const { return m_impl->state(host); }
+
+size_t circuit_breaker::rejected() const { return m_impl->rejected(); }
+} // namespace client
+} // namespace http
+} // namespace web
@@ -0,0 +1,223 @@
+/***
+ * Copyright (C) Microsoft. All rights reserved.
+ * Licensed under the MIT license. See LICENSE.txt file in the project root for full license information.
+ *
+ * =+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+ *
+ * HTTP Library: Client-side pipeline stage coalescing identical in-flight requests
+ *
+ * For the latest on this and related APIs, please see: https://github.com/Microsoft/cpprestsdk
+ *
+ * =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+ ****/
+
+#include "stdafx.h"
+
+#include "cpprest/containerstream.h"
+#include "http_client_impl.h"
+#include <unordered_map>
+
+using namespace web;
+using namespace web::http;
+
+namespace web
+{
+namespace http
+{
+namespace client
+{
+namespace details
+{
+namespace
+{
+typedef std::shared_ptr<const std::vector<uint8_t>> body_ptr;
+
+// A request joining an in-flight one; it completes independently when its own token is canceled
+struct waiter
+{
+    pplx::task_completion_event<http_response> m_result;
+    pplx::cancellation_token m_token {pplx::cancellation_token::none()};
+    pplx::cancellation_token_registration m_registration;
+};
+
+// The single request sent upstream on behalf of all the waiters with the same key
+struct flight
+{
+    std::vector<std::shared_ptr<waiter>> m_waiters;
+};
+
+class coalescing_handler : public http_pipeline_stage
+{
+public:
+    coalescing_handler(const std::vector<utility::string_t>& key_headers) : m_key_headers(key_headers) {}
+
+    virtual pplx::task<http_response> propagate(http_request request) override
+    {
+        auto& impl = *request._get_impl();
+        if ((request.method() != methods::GET && request.method() != methods::HEAD) || impl.instream() ||
+            impl._response_stream() || impl._progress_handler())
+        {
+            // Only requests without a body whose response is buffered in memory can share a response
+            return next_stage()->propagate(request);
+        }
+
+        auto key = make_key(request);
+        auto joining = std::make_shared<waiter>();
+        joining->m_token = request._cancellation_token();
+
+        bool leader = false;
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            auto& current = m_flights[key];
+            if (!current)
+            {
+                current = std::make_shared<flight>();
+                leader = true;
+            }
+            current->m_waiters.push_back(joining);
+        }
+
+        if (joining->m_token.is_cancelable())
+        {
+            std::weak_ptr<waiter> weak_waiter = joining;
+            joining->m_registration = joining->m_token.register_callback([weak_waiter]() {
+                auto canceled = weak_waiter.lock();
+                if (canceled)
+                {
+                    canceled->m_result.set_exception(
+                        http_exception((int)std::errc::operation_canceled, std::generic_category()));
+                }
+            });
+        }
+
+        if (leader)
+        {
+            send(key, request);
+        }
+        return pplx::create_task(joining->m_result);
+    }
+
+private:
+    // The upstream request must outlive any one waiter, so it is not canceled with the leader's token
+    void send(const utility::string_t& key, http_request request)
+    {
+        auto self = std::static_pointer_cast<coalescing_handler>(shared_from_this());
+        request._set_cancellation_token(pplx::cancellation_token::none());
+
+        next_stage()
+            ->propagate(request)
+            .then([](http_response response) { return response.content_ready(); })
+            .then([self, key](pplx::task<http_response> previous) {
+                http_response response;
+                std::exception_ptr error;
+                try
+                {
+                    response = previous.get();
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+
+                if (error)
+                {
+                    self->complete(key, response, body_ptr(), error);
+                    return;
+                }
+
+                auto body = std::make_shared<concurrency::streams::container_buffer<std::vector<uint8_t>>>();
+                response.body().read_to_end(*body).then([self, key, response, body](pplx::task<size_t> read) {
+                    try
+                    {
+                        read.wait();
+                        self->complete(key,
+                                       response,
+                                       std::make_shared<const std::vector<uint8_t>>(std::move(body->collection())),
+                                       std::exception_ptr());
+                    }
+                    catch (...)
+                    {
+                        self->complete(key, response, body_ptr(), std::current_exception());
+                    }
+                });
+            });
+    }
+
+    void complete(const utility::string_t& key,
+                  const http_response& response,
+                  const body_ptr& body,
+                  const std::exception_ptr& error)
+    {
+        std::shared_ptr<flight> done;
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            auto it = m_flights.find(key);
+            done = it->second;
+            m_flights.erase(it);
+        }
+
+        for (auto& waiting : done->m_waiters)
+        {
+            if (waiting->m_token.is_cancelable())
+            {
+                waiting->m_token.deregister_callback(waiting->m_registration);
+            }
+
+            if (error)
+            {
+                waiting->m_result.set_exception(error);
+            }
+            else
+            {
+                waiting->m_result.set(copy_response(response, *body));
+            }
+        }
+    }
+
+    // Each waiter receives its own message, with its own copy of the body to read
+    static http_response copy_response(const http_response& response, const std::vector<uint8_t>& body)
+    {
+        http_response copy(response.status_code());
+        copy.set_reason_phrase(response.reason_phrase());
+        copy.headers() = response.headers();
+
+        auto& impl = *copy._get_impl();
+        impl.set_instream(concurrency::streams::container_stream<std::vector<uint8_t>>::open_istream(body));
+        impl._complete(body.size());
+        return copy;
+    }
+
+    // Requests are identical if they have the same method, absolute URI and values of the key headers
+    utility::string_t make_key(const http_request& request) const
+    {
+        utility::string_t key = request.method();
+        key.push_back(_XPLATSTR(' '));
+        key.append(request.absolute_uri().to_string());
+        for (const auto& name : m_key_headers)
+        {
+            utility::string_t value;
+            key.push_back(_XPLATSTR('\n'));
+            if (request.headers().match(name, value))
+            {
+                key.push_back(_XPLATSTR(':'));
+                key.append(value);
+            }
+        }
+        return key;
+    }
+
+    const std::vector<utility::string_t> m_key_headers;
+
+    std::mutex m_lock;
+    std::unordered_map<utility::string_t, std::shared_ptr<flight>> m_flights;
+};
+} // namespace
+
+std::shared_ptr<http_pipeline_stage> create_coalescing_stage(const std::vector<utility::string_t>& key_headers)
+{
+    return std::make_shared<coalescing_handler>(key_headers);
+}
+} // namespace details
+} // namespace client
+} // namespace http
+} // namespace web
@@ -87,6 +87,12 @@ public:
 
     concurrency::streams::streambuf<uint8_t> _get_writebuffer();
 
+    // Records that a phase of the request completed now
+    void record_timing(http_timing::clock::time_point http_timing::*phase)
+    {
+        m_response._get_impl()->timing().*phase = http_timing::clock::now();
+    }
+
     // Reference to the http_client implementation.
     std::shared_ptr<_http_client_communicator> m_http_client;
 
@@ -129,6 +135,13 @@ public:
 
     const uri& base_uri() const;
 
+    // Implementations which tunnel through the proxy themselves open and count the tunnels.
+    virtual pplx::task<void> open_proxy_tunnels(size_t) { return pplx::task_from_result(); }
+    virtual proxy_tunnel_statistics tunnel_statistics() const { return proxy_tunnel_statistics(); }
+
+    // Implementations which pool connections themselves report the pool.
+    virtual connection_pool_statistics pool_statistics() const { return connection_pool_statistics(); }
+
 protected:
     _http_client_communicator(http::uri&& address, http_client_config&& client_config);
 
@@ -157,6 +170,32 @@ private:
 std::shared_ptr<_http_client_communicator> create_platform_final_pipeline_stage(uri&& base_uri,
                                                                                 http_client_config&& client_config);
 
+/// <summary>
+/// Constructs the pipeline stage which retries and hedges requests according to the given policy.
+/// </summary>
+std::shared_ptr<http_pipeline_stage> create_retry_stage(const retry_policy& policy, const uri& base_uri);
+
+/// <summary>
+/// Constructs the pipeline stage which queues or rejects requests over the limits of the given rate limiter.
+/// </summary>
+std::shared_ptr<http_pipeline_stage> create_rate_limit_stage(const std::shared_ptr<rate_limiter>& limiter);
+
+/// <summary>
+/// Constructs the pipeline stage which fails requests at once while the circuit breaker holds the circuit open.
+/// </summary>
+std::shared_ptr<http_pipeline_stage> create_circuit_breaker_stage(const std::shared_ptr<circuit_breaker>& breaker,
+                                                                  const uri& base_uri);
+
+/// <summary>
+/// Constructs the pipeline stage which sends only one of identical in-flight requests, keyed by the given headers.
+/// </summary>
+std::shared_ptr<http_pipeline_stage> create_coalescing_stage(const std::vector<utility::string_t>& key_headers);
+
+/// <summary>
+/// Constructs the pipeline stage which caches responses in memory, up to the given number of bytes.
+/// </summary>
+std::shared_ptr<http_pipeline_stage> create_cache_stage(size_t max_bytes);
+
 } // namespace details
 } // namespace client
 } // namespace http
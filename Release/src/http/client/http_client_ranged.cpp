@@ -0,0 +1,361 @@
+/***
+ * Copyright (C) Microsoft. All rights reserved.
+ * Licensed under the MIT license. See LICENSE.txt file in the project root for full license information.
+ *
+ * =+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+ *
+ * HTTP Library: Parallel ranged downloads on top of http_client
+ *
+ * For the latest on this and related APIs, please see: https://github.com/Microsoft/cpprestsdk
+ *
+ * =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+ ****/
+
+#include "stdafx.h"
+
+#include <limits>
+
+using namespace web;
+using namespace web::http;
+
+namespace web
+{
+namespace http
+{
+namespace client
+{
+namespace details
+{
+namespace
+{
+// The most each read from a response body hands to the target in one write
+const size_t piece_size = 64 * 1024;
+
+const utility::size64_t unknown_length = (std::numeric_limits<utility::size64_t>::max)();
+
+struct segment
+{
+    segment(utility::size64_t first, utility::size64_t length)
+        : m_first(first), m_length(length), m_received(0), m_attempts(0), m_fatal(false)
+    {
+    }
+
+    bool ranged() const { return m_length != unknown_length; }
+
+    utility::size64_t m_first;
+    utility::size64_t m_length;
+    utility::size64_t m_received;
+    size_t m_attempts;
+    // Set when retrying cannot help, e.g. when the resource changed since the HEAD request
+    bool m_fatal;
+};
+
+// Parses the first byte position of "Content-Range: bytes first-last/complete-length"
+bool parse_content_range_first(const utility::string_t& value, utility::size64_t& first)
+{
+    utility::istringstream_t in(value);
+    utility::string_t unit;
+    in >> unit >> first;
+    return !in.fail() && utility::details::str_iequal(unit, _XPLATSTR("bytes"));
+}
+
+class ranged_download : public std::enable_shared_from_this<ranged_download>
+{
+public:
+    ranged_download(const http_client& client,
+                    const utility::string_t& path_query_fragment,
+                    concurrency::streams::streambuf<uint8_t> target,
+                    const ranged_download_options& options,
+                    pplx::cancellation_token token)
+        : m_client(client)
+        , m_path(path_query_fragment)
+        , m_target(std::move(target))
+        , m_options(options)
+        , m_cancellation(token == pplx::cancellation_token::none()
+                             ? pplx::cancellation_token_source()
+                             : pplx::cancellation_token_source::create_linked_source(token))
+        , m_total(0)
+        , m_written(0)
+        , m_writes(pplx::task_from_result())
+    {
+    }
+
+    pplx::task<utility::size64_t> start()
+    {
+        auto self = shared_from_this();
+        http_request head(methods::HEAD);
+        head.set_request_uri(m_path);
+        return m_client.request(head, m_cancellation.get_token())
+            .then([self](http_response response) { return self->download_segments(response); })
+            .then([self]() {
+                std::lock_guard<std::mutex> lock(self->m_lock);
+                return self->m_writes;
+            })
+            .then([self](pplx::task<void> writes) {
+                std::exception_ptr error;
+                try
+                {
+                    writes.get();
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+
+                // Report the failure that stopped the download rather than the cancellation of the other segments
+                std::lock_guard<std::mutex> lock(self->m_lock);
+                if (self->m_error)
+                {
+                    error = self->m_error;
+                }
+                if (error)
+                {
+                    std::rethrow_exception(error);
+                }
+            })
+            .then([self]() { return self->m_target.sync(); })
+            .then([self]() { return self->m_written; });
+    }
+
+private:
+    // Records the error which stopped the download; the other segments cannot make it succeed any more
+    void fail(std::exception_ptr error)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            if (!m_error)
+            {
+                m_error = error;
+            }
+        }
+        m_cancellation.cancel();
+    }
+
+    pplx::task<void> download_segments(const http_response& head)
+    {
+        const auto& headers = head.headers();
+        utility::string_t accept_ranges;
+        utility::size64_t length = 0;
+        const bool ranged = head.status_code() == status_codes::OK &&
+                            headers.match(header_names::accept_ranges, accept_ranges) &&
+                            utility::details::str_iequal(accept_ranges, _XPLATSTR("bytes")) &&
+                            headers.match(header_names::content_length, length) &&
+                            !headers.has(header_names::content_encoding);
+
+        std::vector<std::shared_ptr<segment>> segments;
+        if (!ranged)
+        {
+            segments.push_back(std::make_shared<segment>(0, unknown_length));
+        }
+        else if (length != 0)
+        {
+            m_total = length;
+
+            // Only a strong entity tag or a modification date can validate a range
+            utility::string_t validator;
+            if (headers.match(header_names::etag, validator) && validator.compare(0, 2, _XPLATSTR("W/")) != 0)
+            {
+                m_validator = validator;
+            }
+            else if (headers.match(header_names::last_modified, validator))
+            {
+                m_validator = validator;
+            }
+
+            const auto min_size = (std::max)(m_options.min_segment_size(), static_cast<utility::size64_t>(1));
+            auto count = (std::min)(static_cast<utility::size64_t>((std::max)(m_options.segments(), size_t(1))),
+                                    (std::max)(length / min_size, static_cast<utility::size64_t>(1)));
+            utility::size64_t first = 0;
+            for (utility::size64_t i = 0; i < count; ++i)
+            {
+                const auto next = length * (i + 1) / count;
+                segments.push_back(std::make_shared<segment>(first, next - first));
+                first = next;
+            }
+        }
+
+        std::vector<pplx::task<void>> downloads;
+        for (const auto& seg : segments)
+        {
+            downloads.push_back(download(seg));
+        }
+        return pplx::when_all(downloads.begin(), downloads.end());
+    }
+
+    // Sends attempts for the segment until it is complete, resuming ranged segments after the received bytes
+    pplx::task<void> download(const std::shared_ptr<segment>& seg)
+    {
+        auto self = shared_from_this();
+        const auto received = seg->m_received;
+        return fetch(seg).then([self, seg, received](pplx::task<void> attempt) {
+            try
+            {
+                attempt.get();
+                return pplx::task_from_result();
+            }
+            catch (...)
+            {
+                if (seg->ranged() && seg->m_received != received)
+                {
+                    seg->m_attempts = 0;
+                }
+                if (self->m_cancellation.get_token().is_canceled() || seg->m_fatal ||
+                    ++seg->m_attempts >= self->m_options.max_attempts())
+                {
+                    // Segments complete without an exception, so that none of theirs goes unobserved
+                    self->fail(std::current_exception());
+                    return pplx::task_from_result();
+                }
+            }
+
+            if (!seg->ranged())
+            {
+                std::lock_guard<std::mutex> lock(self->m_lock);
+                self->m_written -= seg->m_received;
+                seg->m_received = 0;
+            }
+            return self->download(seg);
+        });
+    }
+
+    pplx::task<void> fetch(const std::shared_ptr<segment>& seg)
+    {
+        http_request request(methods::GET);
+        request.set_request_uri(m_path);
+        const auto first = seg->m_first + seg->m_received;
+        if (seg->ranged())
+        {
+            utility::ostringstream_t range;
+            range << _XPLATSTR("bytes=") << first << _XPLATSTR('-') << seg->m_first + seg->m_length - 1;
+            request.headers().add(header_names::range, range.str());
+            if (!m_validator.empty())
+            {
+                request.headers().add(header_names::if_range, m_validator);
+            }
+        }
+
+        auto self = shared_from_this();
+        return m_client.request(request, m_cancellation.get_token()).then([self, seg, first](http_response response) {
+            const auto expected = seg->ranged() ? status_codes::PartialContent : status_codes::OK;
+            bool matches = response.status_code() == expected;
+            if (matches && seg->ranged())
+            {
+                utility::string_t content_range;
+                utility::size64_t range_first = 0;
+                matches = response.headers().match(header_names::content_range, content_range) &&
+                          parse_content_range_first(content_range, range_first) && range_first == first;
+            }
+            if (!matches)
+            {
+                // A full response to a ranged request means that the If-Range validator no longer matches
+                seg->m_fatal = response.status_code() < status_codes::InternalError;
+                utility::ostringstream_t message;
+                message << _XPLATSTR("Unexpected response to a ranged download request: ") << response.status_code();
+                throw http_exception(message.str());
+            }
+
+            auto body = response.body();
+            return pplx::details::_do_while([self, seg, body]() { return self->read_piece(seg, body); })
+                .then([](bool) {});
+        });
+    }
+
+    pplx::task<bool> read_piece(const std::shared_ptr<segment>& seg, concurrency::streams::istream body)
+    {
+        size_t count = piece_size;
+        if (seg->ranged())
+        {
+            const auto remaining = seg->m_length - seg->m_received;
+            if (remaining == 0)
+            {
+                return pplx::task_from_result(false);
+            }
+            count = static_cast<size_t>((std::min)(remaining, static_cast<utility::size64_t>(piece_size)));
+        }
+
+        auto self = shared_from_this();
+        auto buffer = std::make_shared<std::vector<uint8_t>>(count);
+        return body.streambuf().getn(buffer->data(), count).then([self, seg, buffer](size_t read) {
+            if (read == 0)
+            {
+                if (seg->ranged())
+                {
+                    throw http_exception(_XPLATSTR("Response body ended before the requested range was received"));
+                }
+                return pplx::task_from_result(false);
+            }
+            return self->write(seg, buffer, read).then([]() { return true; });
+        });
+    }
+
+    // Writes are chained so that each seek and the write following it are not interleaved with other segments
+    pplx::task<void> write(const std::shared_ptr<segment>& seg,
+                           const std::shared_ptr<std::vector<uint8_t>>& buffer,
+                           size_t count)
+    {
+        auto self = shared_from_this();
+        const auto offset = seg->m_first + seg->m_received;
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_writes = m_writes.then([self, seg, buffer, count, offset]() {
+            typedef concurrency::streams::streambuf<uint8_t>::pos_type pos_type;
+            const auto position = static_cast<pos_type>(static_cast<std::streamoff>(offset));
+            if (self->m_target.seekpos(position, std::ios_base::out) != position)
+            {
+                throw std::runtime_error("Ranged download target does not support seeking the write head");
+            }
+            return self->m_target.putn_nocopy(buffer->data(), count).then([self, seg, buffer, count](size_t written) {
+                if (written != count)
+                {
+                    throw std::runtime_error("Ranged download target did not accept all bytes");
+                }
+                utility::size64_t total_written;
+                {
+                    std::lock_guard<std::mutex> lock(self->m_lock);
+                    seg->m_received += count;
+                    self->m_written += count;
+                    total_written = self->m_written;
+                }
+                const auto& handler = self->m_options.progress_handler();
+                if (handler)
+                {
+                    handler(total_written, self->m_total);
+                }
+            });
+        });
+        return m_writes;
+    }
+
+    http_client m_client;
+    utility::string_t m_path;
+    concurrency::streams::streambuf<uint8_t> m_target;
+    ranged_download_options m_options;
+    pplx::cancellation_token_source m_cancellation;
+    utility::string_t m_validator;
+    utility::size64_t m_total;
+
+    std::mutex m_lock;
+    utility::size64_t m_written;
+    pplx::task<void> m_writes;
+    std::exception_ptr m_error;
+};
+} // namespace
+} // namespace details
+
+pplx::task<utility::size64_t> __cdecl download_ranges(const http_client& client,
+                                                      const utility::string_t& path_query_fragment,
+                                                      concurrency::streams::streambuf<uint8_t> target,
+                                                      const ranged_download_options& options,
+                                                      const pplx::cancellation_token& token)
+{
+    if (!target.can_write())
+    {
+        throw std::invalid_argument("target stream buffer must be open for writing");
+    }
+    auto download =
+        std::make_shared<details::ranged_download>(client, path_query_fragment, std::move(target), options, token);
+    return download->start();
+}
+
+} // namespace client
+} // namespace http
+} // namespace web
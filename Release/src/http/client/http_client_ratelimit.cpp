@@ -0,0 +1,385 @@
+/***
+ * Copyright (C) Microsoft. All rights reserved.
+ * Licensed under the MIT license. See LICENSE.txt file in the project root for full license information.
+ *
+ * =+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+ *
+ * HTTP Library: Client-side rate and concurrency limiting pipeline stage
+ *
+ * For the latest on this and related APIs, please see: https://github.com/Microsoft/cpprestsdk
+ *
+ * =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+ ****/
+
+#include "stdafx.h"
+
+#include "../common/delay_timer.h"
+#include "http_client_impl.h"
+#include <algorithm>
+#include <atomic>
+#include <deque>
+
+using namespace web;
+using namespace web::http;
+
+namespace web
+{
+namespace http
+{
+namespace client
+{
+namespace details
+{
+// The state of a rate_limiter, shared by the pipeline stages of the clients it is set on. The token bucket and the
+// requests in flight are atomics, so that a request which finds a token and a free slot takes no lock; only requests
+// which have to wait for a slot are queued under the lock.
+class rate_limiter_impl : public std::enable_shared_from_this<rate_limiter_impl>
+{
+public:
+    // How a request in flight ended, which adapts the concurrency limit
+    enum class outcome
+    {
+        succeeded,
+        overloaded,
+        failed
+    };
+
+    rate_limiter_impl(const rate_limit_policy& policy)
+        : m_policy(policy)
+        , m_epoch(std::chrono::steady_clock::now())
+        , m_interval(policy.requests_per_second() > 0 ? static_cast<long long>(1e9 / policy.requests_per_second())
+                                                      : 0)
+        , m_tolerance(m_interval * static_cast<long long>(policy.burst() - 1))
+        , m_arrival(0)
+        , m_in_flight(0)
+        , m_limit(static_cast<double>(policy.max_in_flight()))
+        , m_queued(0)
+        , m_waiting(0)
+        , m_rejected(0)
+    {
+    }
+
+    const rate_limit_policy& policy() const { return m_policy; }
+    size_t queue_depth() const { return m_queued; }
+    size_t in_flight() const { return m_in_flight; }
+    size_t concurrency_limit() const { return static_cast<size_t>(m_limit.load()); }
+    size_t rejected() const { return m_rejected; }
+
+    // Completes once the request may be sent, or fails if it is rejected or canceled while it waits
+    pplx::task<void> acquire(const pplx::cancellation_token& token)
+    {
+        bool queued = false;
+        std::chrono::nanoseconds wait;
+        if (!take_token(wait, queued))
+        {
+            return reject();
+        }
+        if (wait.count() == 0)
+        {
+            return acquire_slot(token, queued);
+        }
+
+        // The token is reserved, the request only waits for its turn
+        auto self = shared_from_this();
+        auto timer = std::make_shared<delay_timer>();
+        const auto delay = std::chrono::duration_cast<std::chrono::milliseconds>(
+            wait + std::chrono::milliseconds(1) - std::chrono::nanoseconds(1));
+        return timer->wait(delay).then([self, token, timer](bool) { return self->acquire_slot(token, true); });
+    }
+
+    // Ends a request in flight, adapting the limit and admitting a waiting request to the freed slot
+    void release(outcome result)
+    {
+        if (m_policy.adaptive_concurrency() && result != outcome::failed)
+        {
+            const double min_limit = static_cast<double>(m_policy.min_in_flight());
+            const double max_limit = static_cast<double>(m_policy.max_in_flight());
+            double limit = m_limit.load();
+            double adapted;
+            do
+            {
+                adapted = result == outcome::succeeded ? (std::min)(limit + 1.0 / limit, max_limit)
+                                                       : (std::max)(limit * 0.9, min_limit);
+            } while (!m_limit.compare_exchange_weak(limit, adapted));
+        }
+
+        --m_in_flight;
+        if (m_waiting.load() != 0)
+        {
+            admit_waiters();
+        }
+    }
+
+private:
+    // A request queued for a slot; it is either admitted or canceled, whichever removes it from the queue first
+    struct waiter
+    {
+        pplx::task_completion_event<void> m_admitted;
+        pplx::cancellation_token m_token {pplx::cancellation_token::none()};
+        pplx::cancellation_token_registration m_registration;
+    };
+
+    long long now() const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_epoch)
+            .count();
+    }
+
+    // Takes a token from the bucket, kept as the theoretical arrival time of the next request (GCRA): a request may
+    // be sent once the clock has reached that time, less the burst tolerance. A request which has to wait reserves
+    // its token and a place in the queue, or is rejected if the queue is full.
+    bool take_token(std::chrono::nanoseconds& wait, bool& queued)
+    {
+        wait = std::chrono::nanoseconds(0);
+        if (m_interval == 0)
+        {
+            return true;
+        }
+
+        const long long current = now();
+        long long arrival = m_arrival.load();
+        for (;;)
+        {
+            const long long delay = (std::max)(arrival - m_tolerance - current, 0LL);
+            if (delay != 0 && !queued)
+            {
+                if (!enter_queue())
+                {
+                    return false;
+                }
+                queued = true;
+            }
+            if (m_arrival.compare_exchange_weak(arrival, (std::max)(arrival, current) + m_interval))
+            {
+                wait = std::chrono::nanoseconds(delay);
+                return true;
+            }
+        }
+    }
+
+    // Takes a slot for a request in flight if the concurrency limit allows it
+    bool try_take_slot()
+    {
+        const size_t limit = concurrency_limit();
+        size_t in_flight = m_in_flight.load();
+        do
+        {
+            if (limit != 0 && in_flight >= limit)
+            {
+                return false;
+            }
+        } while (!m_in_flight.compare_exchange_weak(in_flight, in_flight + 1));
+        return true;
+    }
+
+    bool enter_queue()
+    {
+        if (m_queued.fetch_add(1) >= m_policy.max_queue())
+        {
+            --m_queued;
+            return false;
+        }
+        return true;
+    }
+
+    pplx::task<void> reject()
+    {
+        ++m_rejected;
+        return pplx::task_from_exception<void>(
+            http_exception(std::make_error_code(std::errc::resource_unavailable_try_again),
+                           "The request was rejected by the client rate limiter because its queue is full"));
+    }
+
+    pplx::task<void> acquire_slot(const pplx::cancellation_token& token, bool queued)
+    {
+        if (token.is_canceled())
+        {
+            if (queued)
+            {
+                --m_queued;
+            }
+            return pplx::task_from_exception<void>(
+                http_exception(static_cast<int>(std::errc::operation_canceled), std::generic_category()));
+        }
+
+        // Requests already waiting for a slot are admitted first
+        if (m_waiting.load() == 0 && try_take_slot())
+        {
+            if (queued)
+            {
+                --m_queued;
+            }
+            return pplx::task_from_result();
+        }
+        if (!queued && !enter_queue())
+        {
+            return reject();
+        }
+
+        auto entry = std::make_shared<waiter>();
+        entry->m_token = token;
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_waiters.push_back(entry);
+            ++m_waiting;
+        }
+        if (token.is_cancelable())
+        {
+            std::weak_ptr<rate_limiter_impl> weak_self = shared_from_this();
+            std::weak_ptr<waiter> weak_entry = entry;
+            entry->m_registration = token.register_callback([weak_self, weak_entry]() {
+                auto self = weak_self.lock();
+                auto entry = weak_entry.lock();
+                if (self && entry)
+                {
+                    self->cancel_waiter(entry);
+                }
+            });
+        }
+
+        // A slot may have been freed before the request was queued
+        admit_waiters();
+        return pplx::create_task(entry->m_admitted);
+    }
+
+    void admit_waiters()
+    {
+        std::vector<std::shared_ptr<waiter>> admitted;
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            while (!m_waiters.empty() && try_take_slot())
+            {
+                admitted.push_back(std::move(m_waiters.front()));
+                m_waiters.pop_front();
+                --m_waiting;
+                --m_queued;
+            }
+        }
+
+        for (auto& entry : admitted)
+        {
+            if (entry->m_token.is_cancelable())
+            {
+                entry->m_token.deregister_callback(entry->m_registration);
+            }
+            entry->m_admitted.set();
+        }
+    }
+
+    void cancel_waiter(const std::shared_ptr<waiter>& entry)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            auto it = std::find(m_waiters.begin(), m_waiters.end(), entry);
+            if (it == m_waiters.end())
+            {
+                return;
+            }
+            m_waiters.erase(it);
+            --m_waiting;
+            --m_queued;
+        }
+
+        entry->m_admitted.set_exception(
+            http_exception(static_cast<int>(std::errc::operation_canceled), std::generic_category()));
+    }
+
+    const rate_limit_policy m_policy;
+    const std::chrono::steady_clock::time_point m_epoch;
+    // Nanoseconds between two tokens, and how far ahead of the clock the burst lets the arrival time run
+    const long long m_interval;
+    const long long m_tolerance;
+    std::atomic<long long> m_arrival;
+
+    std::atomic<size_t> m_in_flight;
+    std::atomic<double> m_limit;
+    // Requests waiting for a token or a slot, and those of them queued for a slot
+    std::atomic<size_t> m_queued;
+    std::atomic<size_t> m_waiting;
+    std::atomic<size_t> m_rejected;
+
+    std::mutex m_lock;
+    std::deque<std::shared_ptr<waiter>> m_waiters;
+};
+
+namespace
+{
+class rate_limit_handler : public http_pipeline_stage
+{
+public:
+    rate_limit_handler(const std::shared_ptr<rate_limiter_impl>& limiter) : m_limiter(limiter) {}
+
+    virtual pplx::task<http_response> propagate(http_request request) override
+    {
+        auto self = std::static_pointer_cast<rate_limit_handler>(shared_from_this());
+        return m_limiter->acquire(request._cancellation_token()).then([self, request]() {
+            return self->send(request);
+        });
+    }
+
+private:
+    pplx::task<http_response> send(const http_request& request)
+    {
+        auto limiter = m_limiter;
+        pplx::task<http_response> response;
+        try
+        {
+            response = next_stage()->propagate(request);
+        }
+        catch (...)
+        {
+            limiter->release(rate_limiter_impl::outcome::failed);
+            throw;
+        }
+
+        return response.then([limiter](pplx::task<http_response> sent) {
+            try
+            {
+                auto response = sent.get();
+                const auto code = response.status_code();
+                limiter->release(code == status_codes::TooManyRequests || code == status_codes::ServiceUnavailable
+                                     ? rate_limiter_impl::outcome::overloaded
+                                     : rate_limiter_impl::outcome::succeeded);
+                return response;
+            }
+            catch (const http_exception& e)
+            {
+                limiter->release(e.error_code() == std::errc::timed_out ? rate_limiter_impl::outcome::overloaded
+                                                                         : rate_limiter_impl::outcome::failed);
+                throw;
+            }
+            catch (...)
+            {
+                limiter->release(rate_limiter_impl::outcome::failed);
+                throw;
+            }
+        });
+    }
+
+    const std::shared_ptr<rate_limiter_impl> m_limiter;
+};
+} // namespace
+
+std::shared_ptr<http_pipeline_stage> create_rate_limit_stage(const std::shared_ptr<rate_limiter>& limiter)
+{
+    return std::make_shared<rate_limit_handler>(limiter->_get_impl());
+}
+} // namespace details
+
+rate_limiter::rate_limiter(const rate_limit_policy& policy)
+    : m_impl(std::make_shared<details::rate_limiter_impl>(policy))
+{
+}
+
+const rate_limit_policy& rate_limiter::policy() const { return m_impl->policy(); }
+
+size_t rate_limiter::queue_depth() const { return m_impl->queue_depth(); }
+
+size_t rate_limiter::in_flight() const { return m_impl->in_flight(); }
+
+size_t rate_limiter::concurrency_limit() const { return m_impl->concurrency_limit(); }
+
+size_t rate_limiter::rejected() const { return m_impl->rejected(); }
+} // namespace client
+} // namespace http
+} // namespace web
@@ -0,0 +1,408 @@
+/***
+ * Copyright (C) Microsoft. All rights reserved.
+ * Licensed under the MIT license. See LICENSE.txt file in the project root for full license information.
+ *
+ * =+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+ *
+ * HTTP Library: Client-side retry and hedging pipeline stage
+ *
+ * For the latest on this and related APIs, please see: https://github.com/Microsoft/cpprestsdk
+ *
+ * =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+ ****/
+
+#include "stdafx.h"
+
+#include "../common/delay_timer.h"
+#include "cpprest/containerstream.h"
+#include "cpprest/rawptrstream.h"
+#include "http_client_impl.h"
+#include <cmath>
+#include <random>
+
+using namespace web;
+using namespace web::http;
+
+namespace web
+{
+namespace http
+{
+namespace client
+{
+namespace details
+{
+namespace
+{
+// Methods which RFC 7231 section 4.2.2 defines as idempotent
+bool is_idempotent(const method& mtd)
+{
+    return mtd == methods::GET || mtd == methods::HEAD || mtd == methods::OPTIONS || mtd == methods::TRCE ||
+           mtd == methods::PUT || mtd == methods::DEL;
+}
+
+// Errors which mean that the request cannot have reached the server, so that any method may be retried
+bool is_connect_error(const http_exception& e)
+{
+    const auto& code = e.error_code();
+    return code == std::errc::host_unreachable || code == std::errc::connection_refused ||
+           code == std::errc::network_unreachable;
+}
+
+typedef std::shared_ptr<const std::vector<uint8_t>> body_ptr;
+
+// The state shared by the attempts of one hedged send; the first response wins and the other attempt is canceled
+struct hedge_state
+{
+    std::mutex m_lock;
+    pplx::task_completion_event<http_response> m_result;
+    bool m_done {false};
+    size_t m_pending {0};
+    std::vector<pplx::cancellation_token_source> m_sources;
+    pplx::cancellation_token m_token {pplx::cancellation_token::none()};
+    pplx::cancellation_token_registration m_registration;
+    std::shared_ptr<delay_timer> m_timer {std::make_shared<delay_timer>()};
+};
+
+class retry_handler : public http_pipeline_stage
+{
+public:
+    retry_handler(const retry_policy& policy, const uri& base_uri)
+        : m_policy(policy)
+        , m_base_uri(base_uri)
+        , m_budget(static_cast<double>(policy.retry_budget_reserve()))
+        , m_random(std::random_device()())
+    {
+    }
+
+    virtual pplx::task<http_response> propagate(http_request request) override
+    {
+        auto self = std::static_pointer_cast<retry_handler>(shared_from_this());
+        deposit();
+
+        auto& impl = *request._get_impl();
+        if (impl.compressor())
+        {
+            // A compression provider is stateful and cannot be shared between attempts
+            return next_stage()->propagate(request);
+        }
+
+        auto body = impl.instream();
+        if (!body)
+        {
+            return send(request, body_ptr(), 1);
+        }
+
+        // Buffer the body once, so that each attempt replays it from memory
+        auto buffer = std::make_shared<concurrency::streams::container_buffer<std::vector<uint8_t>>>();
+        return body.read_to_end(*buffer).then([self, request, buffer](size_t) {
+            auto data = std::make_shared<std::vector<uint8_t>>(std::move(buffer->collection()));
+            return self->send(request, data, 1);
+        });
+    }
+
+private:
+    pplx::task<http_response> send(const http_request& request, const body_ptr& body, size_t attempt)
+    {
+        auto self = std::static_pointer_cast<retry_handler>(shared_from_this());
+
+        // A caller-supplied response stream can only receive one body, so the response to any attempt is final
+        const bool replayable = !request._get_impl()->_response_stream();
+        const bool idempotent = is_idempotent(request.method()) || m_policy.retry_non_idempotent();
+
+        auto result = (m_policy.hedging() && idempotent && replayable)
+                          ? send_hedged(request, body)
+                          : send_once(request, body, request._cancellation_token());
+
+        return result.then([self, request, body, attempt, replayable, idempotent](
+                               pplx::task<http_response> previous) -> pplx::task<http_response> {
+            std::chrono::milliseconds delay;
+            try
+            {
+                auto response = previous.get();
+                if (!replayable || !idempotent || !self->is_retryable_status(response.status_code()) ||
+                    !self->retry_after(response, attempt, delay) || !self->can_retry(request, attempt))
+                {
+                    return pplx::task_from_result(response);
+                }
+            }
+            catch (const http_exception& e)
+            {
+                if (!(idempotent || is_connect_error(e)) || !self->can_retry(request, attempt))
+                {
+                    throw;
+                }
+                delay = self->backoff(attempt);
+            }
+
+            auto timer = std::make_shared<delay_timer>();
+            return timer->wait(delay).then(
+                [self, request, body, attempt, timer](bool) { return self->send(request, body, attempt + 1); });
+        });
+    }
+
+    pplx::task<http_response> send_once(const http_request& request,
+                                        const body_ptr& body,
+                                        const pplx::cancellation_token& token)
+    {
+        auto self = std::static_pointer_cast<retry_handler>(shared_from_this());
+        auto start = std::chrono::steady_clock::now();
+        return next_stage()
+            ->propagate(make_attempt(request, body, token))
+            .then([self, start, body](http_response response) {
+                self->record_latency(std::chrono::steady_clock::now() - start);
+                return response;
+            });
+    }
+
+    pplx::task<http_response> send_hedged(const http_request& request, const body_ptr& body)
+    {
+        auto self = std::static_pointer_cast<retry_handler>(shared_from_this());
+        auto state = std::make_shared<hedge_state>();
+
+        state->m_token = request._cancellation_token();
+        if (state->m_token.is_cancelable())
+        {
+            std::weak_ptr<hedge_state> weak_state = state;
+            state->m_registration = state->m_token.register_callback([weak_state]() {
+                auto state = weak_state.lock();
+                if (state)
+                {
+                    std::lock_guard<std::mutex> lock(state->m_lock);
+                    for (auto& source : state->m_sources)
+                    {
+                        source.cancel();
+                    }
+                }
+            });
+        }
+
+        launch(state, request, body);
+        state->m_timer->wait(hedge_delay()).then([self, state, request, body](bool expired) {
+            if (expired && self->withdraw())
+            {
+                self->launch(state, request, body);
+            }
+        });
+
+        return pplx::create_task(state->m_result);
+    }
+
+    void launch(const std::shared_ptr<hedge_state>& state, const http_request& request, const body_ptr& body)
+    {
+        pplx::cancellation_token_source source;
+        size_t index;
+        {
+            std::lock_guard<std::mutex> lock(state->m_lock);
+            if (state->m_done)
+            {
+                return;
+            }
+            index = state->m_sources.size();
+            state->m_sources.push_back(source);
+            ++state->m_pending;
+        }
+
+        send_once(request, body, source.get_token()).then([state, index](pplx::task<http_response> attempt) {
+            // The result is always observed, including that of a canceled loser
+            http_response response;
+            std::exception_ptr error;
+            try
+            {
+                response = attempt.get();
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+
+            std::vector<pplx::cancellation_token_source> losers;
+            {
+                std::lock_guard<std::mutex> lock(state->m_lock);
+                --state->m_pending;
+                if (state->m_done || (error && state->m_pending != 0))
+                {
+                    // Either another attempt has won, or it may still succeed
+                    return;
+                }
+
+                if (!error)
+                {
+                    for (size_t i = 0; i < state->m_sources.size(); ++i)
+                    {
+                        if (i != index)
+                        {
+                            losers.push_back(state->m_sources[i]);
+                        }
+                    }
+                }
+                state->m_done = true;
+            }
+
+            state->m_timer->cancel();
+            if (state->m_token.is_cancelable())
+            {
+                state->m_token.deregister_callback(state->m_registration);
+            }
+            for (auto& loser : losers)
+            {
+                loser.cancel();
+            }
+
+            if (error)
+            {
+                state->m_result.set_exception(error);
+            }
+            else
+            {
+                state->m_result.set(response);
+            }
+        });
+    }
+
+    http_request make_attempt(const http_request& request, const body_ptr& body, const pplx::cancellation_token& token)
+    {
+        http_request attempt(request.method());
+        attempt.set_request_uri(request.request_uri());
+        attempt._set_base_uri(m_base_uri);
+        attempt.headers() = request.headers();
+        attempt._set_cancellation_token(token);
+
+        auto& impl = *request._get_impl();
+        auto& attempt_impl = *attempt._get_impl();
+        if (body)
+        {
+            // Attempts read the shared buffer in place; the continuation in send_once keeps it alive
+            attempt_impl.set_instream(
+                concurrency::streams::rawptr_stream<uint8_t>::open_istream(body->data(), body->size()));
+        }
+        attempt_impl.set_decompress_factories(impl.decompress_factories());
+        if (impl._response_stream())
+        {
+            attempt_impl.set_response_stream(impl._response_stream());
+        }
+        if (impl._progress_handler())
+        {
+            attempt_impl.set_progress_handler(*impl._progress_handler());
+        }
+        return attempt;
+    }
+
+    bool is_retryable_status(status_code code) const
+    {
+        const auto& codes = m_policy.retry_status_codes();
+        return std::find(codes.begin(), codes.end(), code) != codes.end();
+    }
+
+    bool can_retry(const http_request& request, size_t attempt)
+    {
+        return attempt < m_policy.max_attempts() && !request._cancellation_token().is_canceled() && withdraw();
+    }
+
+    // Computes the delay before retrying a response, honouring a Retry-After header given in delta-seconds; returns
+    // false if the server asked for a longer delay than the policy allows
+    bool retry_after(const http_response& response, size_t attempt, std::chrono::milliseconds& delay)
+    {
+        delay = backoff(attempt);
+
+        utility::string_t value;
+        if (response.headers().match(header_names::retry_after, value) && !value.empty() &&
+            std::all_of(value.begin(), value.end(), [](utility::char_t ch) { return ch >= '0' && ch <= '9'; }))
+        {
+            std::chrono::milliseconds requested(
+                std::chrono::seconds(utility::conversions::details::scan_string<int>(value)));
+            if (requested > m_policy.max_backoff())
+            {
+                return false;
+            }
+            delay = (std::max)(delay, requested);
+        }
+        return true;
+    }
+
+    // Exponential backoff with "full jitter", i.e. a uniformly random delay up to the exponential bound
+    std::chrono::milliseconds backoff(size_t attempt)
+    {
+        double bound = static_cast<double>(m_policy.initial_backoff().count()) *
+                       std::pow(m_policy.backoff_multiplier(), static_cast<double>(attempt - 1));
+        bound = (std::min)(bound, static_cast<double>(m_policy.max_backoff().count()));
+
+        std::lock_guard<std::mutex> lock(m_lock);
+        std::uniform_real_distribution<double> jitter(0.0, bound);
+        return std::chrono::milliseconds(static_cast<std::chrono::milliseconds::rep>(jitter(m_random)));
+    }
+
+    // The retry budget is a token bucket: each request earns a fraction of a retry, and each retry or hedged attempt
+    // spends one, so that retries stay a bounded share of the traffic when the server is struggling
+    void deposit()
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_budget = (std::min)(m_budget + m_policy.retry_budget_ratio(),
+                              static_cast<double>(m_policy.retry_budget_reserve()));
+    }
+
+    bool withdraw()
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (m_budget < 1.0)
+        {
+            return false;
+        }
+        m_budget -= 1.0;
+        return true;
+    }
+
+    void record_latency(const std::chrono::steady_clock::duration& latency)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        auto sample = std::chrono::duration_cast<std::chrono::milliseconds>(latency);
+        if (m_latencies.size() < latency_samples)
+        {
+            m_latencies.push_back(sample);
+        }
+        else
+        {
+            m_latencies[m_next_latency] = sample;
+        }
+        m_next_latency = (m_next_latency + 1) % latency_samples;
+    }
+
+    // The hedged attempt is sent once the first has taken longer than 95% of recent responses
+    std::chrono::milliseconds hedge_delay()
+    {
+        std::vector<std::chrono::milliseconds> latencies;
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            if (m_latencies.size() < min_latency_samples)
+            {
+                return m_policy.hedge_delay();
+            }
+            latencies = m_latencies;
+        }
+
+        auto p95 = latencies.begin() + static_cast<std::ptrdiff_t>(latencies.size() * 95 / 100);
+        std::nth_element(latencies.begin(), p95, latencies.end());
+        return (std::max)(*p95, m_policy.hedge_delay());
+    }
+
+    static const size_t latency_samples = 128;
+    static const size_t min_latency_samples = 20;
+
+    const retry_policy m_policy;
+    const uri m_base_uri;
+
+    std::mutex m_lock;
+    double m_budget;
+    std::mt19937 m_random;
+    std::vector<std::chrono::milliseconds> m_latencies;
+    size_t m_next_latency {0};
+};
+} // namespace
+
+std::shared_ptr<http_pipeline_stage> create_retry_stage(const retry_policy& policy, const uri& base_uri)
+{
+    return std::make_shared<retry_handler>(policy, base_uri);
+}
+} // namespace details
+} // namespace client
+} // namespace http
+} // namespace web
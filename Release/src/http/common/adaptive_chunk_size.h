@@ -0,0 +1,55 @@
+#pragma once
+
+#include <algorithm>
+#include <stddef.h>
+
+namespace web
+{
+namespace http
+{
+namespace client
+{
+namespace details
+{
+// Tracks the I/O chunk size of one connection. Full chunks with as much again ready to transfer double the size, so
+// bulk transfers on fast links take fewer reads and writes; whole messages fitting in a quarter of a chunk halve it,
+// so connections carrying small messages do not hold large buffers.
+class adaptive_chunk_size
+{
+public:
+    adaptive_chunk_size(size_t initial, size_t min_size, size_t max_size)
+        : m_min(min_size), m_max(std::max(min_size, max_size)), m_size(std::min(std::max(initial, m_min), m_max))
+    {
+    }
+
+    size_t size() const { return m_size; }
+
+    // records a read or write of `transferred` bytes into a buffer of size(), after which `ready` more bytes could be
+    // transferred without waiting
+    void record_chunk(size_t transferred, size_t ready)
+    {
+        if (transferred >= m_size && ready >= m_size)
+        {
+            m_size = std::min(m_size * 2, m_max);
+        }
+    }
+
+    // records the body size of a whole message sent or received on the connection
+    void record_message(size_t body_size)
+    {
+        if (body_size < m_size / 4)
+        {
+            m_size = std::max(m_size / 2, m_min);
+        }
+    }
+
+private:
+    size_t m_min;
+    size_t m_max;
+    size_t m_size;
+};
+
+} // namespace details
+} // namespace client
+} // namespace http
+} // namespace web
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "asio_socket_options.h"
+#include "cpprest/filestream.h"
+#if defined(__linux__)
+#include <signal.h>
+#include <sys/sendfile.h>
+#endif
+
+namespace web
+{
+namespace http
+{
+namespace details
+{
+// returns the descriptor of the file behind a message body when its bytes can be sent kernel-side by async_sendfile,
+// or -1 when the body has to be copied through a buffer
+inline int sendfile_descriptor(const concurrency::streams::streambuf<uint8_t>& body)
+{
+#if defined(__linux__)
+    auto file = dynamic_cast<concurrency::streams::details::basic_file_buffer<uint8_t>*>(body.get_base().get());
+    if (file != nullptr && file->can_read())
+    {
+        return file->_native_fd();
+    }
+#else
+    (void)body;
+#endif
+    return -1;
+}
+
+#if defined(__linux__)
+// sendfile(2) has no MSG_NOSIGNAL flag, so SIGPIPE is blocked on the calling thread while it runs, and one raised for a
+// closed peer is taken before the signal mask is restored
+class sigpipe_guard
+{
+public:
+    sigpipe_guard() : m_raised(false)
+    {
+        sigemptyset(&m_sigpipe);
+        sigaddset(&m_sigpipe, SIGPIPE);
+        sigset_t pending;
+        sigpending(&pending);
+        m_was_pending = sigismember(&pending, SIGPIPE) == 1;
+        pthread_sigmask(SIG_BLOCK, &m_sigpipe, &m_old_mask);
+    }
+
+    ~sigpipe_guard()
+    {
+        if (m_raised && !m_was_pending)
+        {
+            const timespec no_wait = {0, 0};
+            while (sigtimedwait(&m_sigpipe, nullptr, &no_wait) == -1 && errno == EINTR)
+            {
+            }
+        }
+        pthread_sigmask(SIG_SETMASK, &m_old_mask, nullptr);
+    }
+
+    void raised() { m_raised = true; }
+
+private:
+    sigset_t m_sigpipe;
+    sigset_t m_old_mask;
+    bool m_was_pending;
+    bool m_raised;
+};
+#endif
+
+// Moves `count` bytes of a file, from `offset`, to a plain TCP or Unix domain socket with sendfile(2) whenever the
+// socket is writable, then calls the handler with the error and the number of bytes sent. A file ending early completes
+// with eof.
+template<typename Handler>
+class sendfile_op
+{
+public:
+    sendfile_op(stream_socket& socket, int fd, uint64_t offset, size_t count, const Handler& handler)
+        : m_socket(socket), m_fd(fd), m_offset(offset), m_remaining(count), m_sent(0), m_handler(handler)
+    {
+    }
+
+    // waits for the socket to become writable; the handler is never called from within the initiating call
+    void start() { m_socket.async_write_some(boost::asio::null_buffers(), *this); }
+
+    void operator()(boost::system::error_code ec, size_t)
+    {
+        if (!ec && !send(ec))
+        {
+            return start();
+        }
+        m_handler(ec, m_sent);
+    }
+
+private:
+    stream_socket& m_socket;
+    int m_fd;
+    uint64_t m_offset;
+    size_t m_remaining;
+    size_t m_sent;
+    Handler m_handler;
+
+    // sends until the count is reached or an error occurs, returning false if the socket's send buffer is full first
+    bool send(boost::system::error_code& ec)
+    {
+#if defined(__linux__)
+        sigpipe_guard guard;
+        while (m_remaining != 0)
+        {
+            off_t offset = static_cast<off_t>(m_offset);
+            const ssize_t sent = ::sendfile(m_socket.native_handle(), m_fd, &offset, m_remaining);
+            if (sent > 0)
+            {
+                m_offset += static_cast<uint64_t>(sent);
+                m_remaining -= static_cast<size_t>(sent);
+                m_sent += static_cast<size_t>(sent);
+            }
+            else if (sent == 0)
+            {
+                ec = boost::asio::error::eof;
+                return true;
+            }
+            else if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                return false;
+            }
+            else if (errno != EINTR)
+            {
+                if (errno == EPIPE)
+                {
+                    guard.raised();
+                }
+                ec = boost::system::error_code(errno, boost::asio::error::get_system_category());
+                return true;
+            }
+        }
+#else
+        ec = boost::asio::error::operation_not_supported;
+#endif
+        return true;
+    }
+};
+
+template<typename Handler>
+void async_sendfile(stream_socket& socket, int fd, uint64_t offset, size_t count, const Handler& handler)
+{
+    // sendfile only returns early on a full send buffer if the descriptor itself is non-blocking; should this fail,
+    // sendfile blocks until the count is sent, which still completes the operation
+    boost::system::error_code error_ignored;
+    socket.native_non_blocking(true, error_ignored);
+    sendfile_op<Handler>(socket, fd, offset, count, handler).start();
+}
+
+} // namespace details
+} // namespace http
+} // namespace web
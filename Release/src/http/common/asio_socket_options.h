@@ -0,0 +1,160 @@
+#pragma once
+
+#include "cpprest/http_msg.h"
+#include <boost/asio/basic_socket_acceptor.hpp>
+#include <boost/asio/generic/stream_protocol.hpp>
+#include <boost/asio/ip/tcp.hpp>
+
+namespace web
+{
+namespace http
+{
+namespace details
+{
+template<int Level, int Name>
+using integer_socket_option = boost::asio::detail::socket_option::integer<Level, Name>;
+
+#if defined(SO_REUSEPORT)
+// lets several sockets listen on the same address and port, the kernel spreading new connections among them
+typedef boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT> reuse_port;
+#endif
+
+// connections are carried by sockets of the generic protocol, so that TCP and Unix domain sockets share the code
+typedef boost::asio::generic::stream_protocol::socket stream_socket;
+typedef boost::asio::basic_socket_acceptor<boost::asio::generic::stream_protocol> stream_acceptor;
+
+// only TCP sockets take the TCP level options; Unix domain sockets have no use for them
+template<typename Protocol>
+bool is_tcp_protocol(const Protocol& protocol)
+{
+    return protocol.family() == boost::asio::ip::tcp::v4().family() ||
+           protocol.family() == boost::asio::ip::tcp::v6().family();
+}
+
+// applies the options taking effect before a socket connects or listens; `Socket` is a socket or an acceptor
+template<typename Socket>
+void apply_buffer_socket_options(Socket& socket, const socket_options& options)
+{
+    boost::system::error_code error_ignored;
+    if (options.send_buffer_size() != 0)
+    {
+        socket.set_option(boost::asio::socket_base::send_buffer_size(options.send_buffer_size()), error_ignored);
+    }
+    if (options.receive_buffer_size() != 0)
+    {
+        socket.set_option(boost::asio::socket_base::receive_buffer_size(options.receive_buffer_size()),
+                          error_ignored);
+    }
+}
+
+// applies the options of an individual connection, to a socket of the given protocol
+template<typename Protocol>
+void apply_connection_socket_options(stream_socket& socket, const Protocol& protocol, const socket_options& options)
+{
+    if (!is_tcp_protocol(protocol))
+    {
+        return;
+    }
+
+    boost::system::error_code error_ignored;
+    socket.set_option(boost::asio::ip::tcp::no_delay(options.no_delay()), error_ignored);
+
+    if (options.keep_alive())
+    {
+        socket.set_option(boost::asio::socket_base::keep_alive(true), error_ignored);
+#if defined(TCP_KEEPIDLE)
+        if (options.keep_alive_idle().count() != 0)
+        {
+            socket.set_option(integer_socket_option<IPPROTO_TCP, TCP_KEEPIDLE>(
+                                  static_cast<int>(options.keep_alive_idle().count())),
+                              error_ignored);
+        }
+#elif defined(TCP_KEEPALIVE)
+        if (options.keep_alive_idle().count() != 0)
+        {
+            socket.set_option(integer_socket_option<IPPROTO_TCP, TCP_KEEPALIVE>(
+                                  static_cast<int>(options.keep_alive_idle().count())),
+                              error_ignored);
+        }
+#endif
+#if defined(TCP_KEEPINTVL)
+        if (options.keep_alive_interval().count() != 0)
+        {
+            socket.set_option(integer_socket_option<IPPROTO_TCP, TCP_KEEPINTVL>(
+                                  static_cast<int>(options.keep_alive_interval().count())),
+                              error_ignored);
+        }
+#endif
+#if defined(TCP_KEEPCNT)
+        if (options.keep_alive_count() != 0)
+        {
+            socket.set_option(integer_socket_option<IPPROTO_TCP, TCP_KEEPCNT>(options.keep_alive_count()),
+                              error_ignored);
+        }
+#endif
+    }
+
+    if (options.type_of_service() != 0)
+    {
+        if (protocol.family() == boost::asio::ip::tcp::v4().family())
+        {
+            socket.set_option(integer_socket_option<IPPROTO_IP, IP_TOS>(options.type_of_service()), error_ignored);
+        }
+#if defined(IPV6_TCLASS)
+        else
+        {
+            socket.set_option(integer_socket_option<IPPROTO_IPV6, IPV6_TCLASS>(options.type_of_service()),
+                              error_ignored);
+        }
+#endif
+    }
+
+#if defined(SO_BUSY_POLL)
+    if (options.busy_poll().count() != 0)
+    {
+        socket.set_option(
+            integer_socket_option<SOL_SOCKET, SO_BUSY_POLL>(static_cast<int>(options.busy_poll().count())),
+            error_ignored);
+    }
+#endif
+}
+
+// applies all the options to a client socket which has been opened but not yet connected
+template<typename Protocol>
+void apply_client_socket_options(stream_socket& socket, const Protocol& protocol, const socket_options& options)
+{
+    apply_buffer_socket_options(socket, options);
+    apply_connection_socket_options(socket, protocol, options);
+#if defined(TCP_FASTOPEN_CONNECT)
+    if (options.fast_open() && is_tcp_protocol(protocol))
+    {
+        boost::system::error_code error_ignored;
+        socket.set_option(integer_socket_option<IPPROTO_TCP, TCP_FASTOPEN_CONNECT>(1), error_ignored);
+    }
+#endif
+}
+
+// applies the options to a listening socket which has been bound but is not yet listening; accepted sockets inherit
+// the buffer sizes
+template<typename Protocol>
+void apply_acceptor_socket_options(stream_acceptor& acceptor,
+                                   const Protocol& protocol,
+                                   const socket_options& options,
+                                   int backlog)
+{
+    apply_buffer_socket_options(acceptor, options);
+#if defined(TCP_FASTOPEN)
+    if (options.fast_open() && is_tcp_protocol(protocol))
+    {
+        boost::system::error_code error_ignored;
+        acceptor.set_option(integer_socket_option<IPPROTO_TCP, TCP_FASTOPEN>(backlog), error_ignored);
+    }
+#else
+    (void)protocol;
+    (void)backlog;
+#endif
+}
+
+} // namespace details
+} // namespace http
+} // namespace web
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "pplx/threadpool.h"
+#include "timer_wheel.h"
+#include <boost/asio/steady_timer.hpp>
+#include <chrono>
+#include <mutex>
+
+namespace web
+{
+namespace http
+{
+namespace details
+{
+// Drives a timer_wheel from a single steady_timer on the shared thread pool, ticking only while entries are filed.
+// Timeouts are rounded up to whole ticks, so they fire up to one tick late.
+class asio_timer_wheel : public std::enable_shared_from_this<asio_timer_wheel>
+{
+public:
+    typedef timer_wheel::entry entry;
+
+    asio_timer_wheel(boost::asio::io_service& service, std::chrono::milliseconds tick)
+        : m_tick(tick), m_start(std::chrono::steady_clock::now()), m_ticking(false), m_timer(service)
+    {
+    }
+
+    // the wheel shared by the HTTP client and listener, ticking every 10 milliseconds
+    static const std::shared_ptr<asio_timer_wheel>& shared_instance()
+    {
+        static const auto instance = std::make_shared<asio_timer_wheel>(
+            crossplat::threadpool::shared_instance().service(), std::chrono::milliseconds(10));
+        return instance;
+    }
+
+    // calls `callback` on the thread pool once `timeout` has passed, unless the entry is canceled first
+    template<typename Duration>
+    std::shared_ptr<entry> arm(const Duration& timeout, std::function<void()> callback)
+    {
+        auto e = std::make_shared<entry>(std::move(callback));
+        schedule(e, timeout);
+        return e;
+    }
+
+    // files `e` again, to fire once `timeout` has passed
+    template<typename Duration>
+    void schedule(const std::shared_ptr<entry>& e, const Duration& timeout)
+    {
+        const auto deadline = deadline_after(timeout);
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (m_wheel.size() == 0)
+        {
+            // catch up with the clock while nothing can expire
+            std::vector<std::shared_ptr<entry>> none;
+            m_wheel.advance(current_tick(), none);
+        }
+        m_wheel.schedule(e, deadline);
+        if (!m_ticking)
+        {
+            m_ticking = true;
+            start_tick();
+        }
+    }
+
+    // moves the deadline of an armed entry without taking the lock
+    template<typename Duration>
+    void extend(entry& e, const Duration& timeout)
+    {
+        e.extend(deadline_after(timeout));
+    }
+
+    void cancel(entry& e)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_wheel.cancel(e);
+    }
+
+private:
+    uint64_t current_tick() const
+    {
+        return static_cast<uint64_t>((std::chrono::steady_clock::now() - m_start) / m_tick);
+    }
+
+    template<typename Duration>
+    uint64_t deadline_after(const Duration& timeout) const
+    {
+        const auto elapsed = std::chrono::steady_clock::now() - m_start + timeout;
+        return static_cast<uint64_t>((elapsed + m_tick - std::chrono::steady_clock::duration(1)) / m_tick);
+    }
+
+    // Note: must be called under m_lock
+    void start_tick()
+    {
+        std::weak_ptr<asio_timer_wheel> weak_wheel = shared_from_this();
+#if (defined(ANDROID) || defined(__ANDROID__)) && !defined(_LIBCPP_VERSION)
+        m_timer.expires_from_now(
+            boost::chrono::microseconds(std::chrono::duration_cast<std::chrono::microseconds>(m_tick).count()));
+#else
+        m_timer.expires_from_now(m_tick);
+#endif
+        m_timer.async_wait([weak_wheel](const boost::system::error_code& ec) {
+            auto wheel = weak_wheel.lock();
+            if (!ec && wheel)
+            {
+                wheel->on_tick();
+            }
+        });
+    }
+
+    void on_tick()
+    {
+        std::vector<std::shared_ptr<entry>> expired;
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_wheel.advance(current_tick(), expired);
+            m_ticking = m_wheel.size() != 0;
+            if (m_ticking)
+            {
+                start_tick();
+            }
+        }
+
+        for (auto& e : expired)
+        {
+            e->fire();
+        }
+    }
+
+    const std::chrono::steady_clock::duration m_tick;
+    const std::chrono::steady_clock::time_point m_start;
+
+    std::mutex m_lock;
+    timer_wheel m_wheel;
+    bool m_ticking;
+    boost::asio::steady_timer m_timer;
+};
+
+} // namespace details
+} // namespace http
+} // namespace web
@@ -42,6 +42,9 @@ public:
     // releases `released` back to the connection pool
     void release(std::shared_ptr<ConnectionIsh>&& released) { m_connections.push_back(std::move(released)); }
 
+    // the number of connections waiting in the pool
+    size_t size() const CPPREST_NOEXCEPT { return m_connections.size(); }
+
     bool free_stale_connections() CPPREST_NOEXCEPT
     {
         assert(m_staleBefore <= m_connections.size());
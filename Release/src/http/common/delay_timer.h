@@ -0,0 +1,70 @@
+#pragma once
+
+#include "pplx/pplxtasks.h"
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+#if !defined(CPPREST_EXCLUDE_WEBSOCKETS) || !defined(_WIN32)
+#include "pplx/threadpool.h"
+#include <boost/asio/steady_timer.hpp>
+#define CPPREST_DELAY_ASIO_TIMER
+#else
+#include <thread>
+#endif
+
+namespace web
+{
+namespace http
+{
+namespace client
+{
+namespace details
+{
+#if defined(CPPREST_DELAY_ASIO_TIMER)
+// One-shot delay on the shared thread pool; wait() completes with false if the timer was cancelled
+class delay_timer : public std::enable_shared_from_this<delay_timer>
+{
+public:
+    delay_timer() : m_timer(crossplat::threadpool::shared_instance().service()) {}
+
+    pplx::task<bool> wait(const std::chrono::milliseconds& delay)
+    {
+        pplx::task_completion_event<bool> tce;
+        auto self = shared_from_this();
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_timer.expires_from_now(delay);
+        m_timer.async_wait([self, tce](const boost::system::error_code& ec) { tce.set(!ec); });
+        return pplx::create_task(tce);
+    }
+
+    void cancel()
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_timer.cancel();
+    }
+
+private:
+    std::mutex m_lock;
+    boost::asio::steady_timer m_timer;
+};
+#else
+// Without the asio thread pool there is no timer service, so the delay occupies a task
+class delay_timer
+{
+public:
+    pplx::task<bool> wait(const std::chrono::milliseconds& delay)
+    {
+        return pplx::create_task([delay]() {
+            std::this_thread::sleep_for(delay);
+            return true;
+        });
+    }
+
+    void cancel() {}
+};
+#endif
+} // namespace details
+} // namespace client
+} // namespace http
+} // namespace web
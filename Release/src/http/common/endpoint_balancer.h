@@ -0,0 +1,173 @@
+#pragma once
+
+#include "cpprest/http_client.h"
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <vector>
+
+namespace web
+{
+namespace http
+{
+namespace client
+{
+namespace details
+{
+// Picks the endpoint for each request of a load balanced client and ejects endpoints which keep refusing connections.
+// Every pick is followed by exactly one of succeeded, connect_failed or released, which ends the request in flight.
+class endpoint_balancer
+{
+public:
+    typedef std::chrono::steady_clock clock;
+    static const size_t npos = static_cast<size_t>(-1);
+
+    endpoint_balancer(size_t count, const load_balancing_policy& policy)
+        : m_strategy(policy.strategy())
+        , m_ejection_threshold(policy.ejection_threshold())
+        , m_ejection_duration(policy.ejection_duration())
+        , m_endpoints(count)
+        , m_next(0)
+        , m_random(std::random_device()())
+    {
+    }
+
+    size_t size() const { return m_endpoints.size(); }
+
+    // picks the endpoint for a request among those not ejected, or among all of them if every one is ejected
+    size_t pick(clock::time_point now = clock::now())
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        std::vector<size_t> eligible;
+        eligible.reserve(m_endpoints.size());
+        for (size_t i = 0; i < m_endpoints.size(); ++i)
+        {
+            if (m_endpoints[i].m_ejected_until <= now)
+            {
+                eligible.push_back(i);
+            }
+        }
+        if (eligible.empty())
+        {
+            for (size_t i = 0; i < m_endpoints.size(); ++i)
+            {
+                eligible.push_back(i);
+            }
+        }
+
+        const size_t start = m_next++ % eligible.size();
+        size_t chosen = eligible[start];
+        if (m_strategy == load_balancing_policy::selection::least_outstanding)
+        {
+            // scanning from the round-robin position spreads requests among equally loaded endpoints
+            for (size_t k = 1; k < eligible.size(); ++k)
+            {
+                const size_t i = eligible[(start + k) % eligible.size()];
+                if (m_endpoints[i].m_outstanding < m_endpoints[chosen].m_outstanding)
+                {
+                    chosen = i;
+                }
+            }
+        }
+        else if (m_strategy == load_balancing_policy::selection::power_of_two_choices && eligible.size() > 1)
+        {
+            std::uniform_int_distribution<size_t> first(0, eligible.size() - 1);
+            std::uniform_int_distribution<size_t> second(0, eligible.size() - 2);
+            const size_t a = first(m_random);
+            size_t b = second(m_random);
+            if (b >= a)
+            {
+                ++b;
+            }
+            chosen = cost(eligible[a]) <= cost(eligible[b]) ? eligible[a] : eligible[b];
+        }
+
+        ++m_endpoints[chosen].m_outstanding;
+        return chosen;
+    }
+
+    // the request received a response from the endpoint `latency` after it was picked
+    void succeeded(size_t index, const std::chrono::microseconds& latency)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        auto& endpoint = m_endpoints[index];
+        --endpoint.m_outstanding;
+        endpoint.m_failures = 0;
+        endpoint.m_ejected_until = clock::time_point();
+
+        // each new response time carries this weight in the moving average
+        const double weight = 0.3;
+        const auto sample = static_cast<double>(latency.count());
+        endpoint.m_latency =
+            endpoint.m_has_latency ? endpoint.m_latency + weight * (sample - endpoint.m_latency) : sample;
+        endpoint.m_has_latency = true;
+    }
+
+    // no connection could be made to the endpoint; returns true if this ejected it
+    bool connect_failed(size_t index, clock::time_point now = clock::now())
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        auto& endpoint = m_endpoints[index];
+        --endpoint.m_outstanding;
+        ++endpoint.m_failures;
+        if (m_ejection_threshold == 0 || endpoint.m_failures < m_ejection_threshold || endpoint.m_ejected_until > now)
+        {
+            return false;
+        }
+
+        endpoint.m_ejected_until = now + m_ejection_duration;
+        return true;
+    }
+
+    // the request ended without showing whether the endpoint is healthy
+    void released(size_t index)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        --m_endpoints[index].m_outstanding;
+    }
+
+    size_t outstanding(size_t index) const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_endpoints[index].m_outstanding;
+    }
+
+    bool is_ejected(size_t index, clock::time_point now = clock::now()) const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_endpoints[index].m_ejected_until > now;
+    }
+
+private:
+    struct endpoint_state
+    {
+        endpoint_state() : m_outstanding(0), m_failures(0), m_latency(0), m_has_latency(false), m_ejected_until() {}
+
+        size_t m_outstanding;
+        size_t m_failures;
+        double m_latency;
+        bool m_has_latency;
+        clock::time_point m_ejected_until;
+    };
+
+    // endpoints without a response time yet cost nothing, so that each of them is tried early
+    double cost(size_t index) const
+    {
+        const auto& endpoint = m_endpoints[index];
+        return endpoint.m_latency * static_cast<double>(endpoint.m_outstanding + 1);
+    }
+
+    const load_balancing_policy::selection m_strategy;
+    const size_t m_ejection_threshold;
+    const std::chrono::milliseconds m_ejection_duration;
+
+    mutable std::mutex m_lock;
+    std::vector<endpoint_state> m_endpoints;
+    size_t m_next;
+    std::minstd_rand m_random;
+};
+
+} // namespace details
+} // namespace client
+} // namespace http
+} // namespace web
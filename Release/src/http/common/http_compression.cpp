@@ -15,6 +15,7 @@
 
 // CPPREST_EXCLUDE_COMPRESSION is set if we're on a platform that supports compression but we want to explicitly disable
 // it. CPPREST_EXCLUDE_BROTLI is set if we want to explicitly disable Brotli compression support.
+// CPPREST_EXCLUDE_ZSTD is set if we want to explicitly disable Zstandard compression support.
 // CPPREST_EXCLUDE_WEBSOCKETS is a flag that now essentially means "no external dependencies". TODO: Rename
 
 #if !defined(CPPREST_EXCLUDE_WEBSOCKETS) && !defined(CPPREST_EXCLUDE_COMPRESSION)
@@ -34,6 +35,12 @@
 #include <brotli/decode.h>
 #include <brotli/encode.h>
 #endif // CPPREST_BROTLI_COMPRESSION
+#if !defined(CPPREST_EXCLUDE_ZSTD)
+#define CPPREST_ZSTD_COMPRESSION
+#endif // CPPREST_EXCLUDE_ZSTD
+#if defined(CPPREST_ZSTD_COMPRESSION)
+#include <zstd.h>
+#endif // CPPREST_ZSTD_COMPRESSION
 #endif
 
 namespace web
@@ -426,6 +433,7 @@ public:
 
         m_stream = BrotliEncoderCreateInstance(nullptr, nullptr, nullptr);
         m_state = m_stream ? BROTLI_TRUE : BROTLI_FALSE;
+        m_done = false;
 
         if (m_state == BROTLI_TRUE && m_window != BROTLI_DEFAULT_WINDOW)
         {
@@ -589,6 +597,259 @@ private:
     const utility::string_t& m_algorithm;
 };
 #endif // CPPREST_BROTLI_COMPRESSION
+
+#if defined(CPPREST_ZSTD_COMPRESSION)
+// Digested dictionaries are immutable once created, so one copy is shared by every provider that uses it
+typedef std::shared_ptr<const ZSTD_CDict> zstd_cdict_ptr;
+typedef std::shared_ptr<const ZSTD_DDict> zstd_ddict_ptr;
+
+static zstd_cdict_ptr make_zstd_cdict(const std::vector<uint8_t>& dictionary, int compressionLevel)
+{
+    if (dictionary.empty())
+    {
+        return zstd_cdict_ptr();
+    }
+
+    ZSTD_CDict* cdict = ZSTD_createCDict(dictionary.data(), dictionary.size(), compressionLevel);
+    if (!cdict)
+    {
+        throw std::runtime_error("Failed to load Zstandard compression dictionary");
+    }
+    return zstd_cdict_ptr(cdict, [](const ZSTD_CDict* p) { ZSTD_freeCDict(const_cast<ZSTD_CDict*>(p)); });
+}
+
+static zstd_ddict_ptr make_zstd_ddict(const std::vector<uint8_t>& dictionary)
+{
+    if (dictionary.empty())
+    {
+        return zstd_ddict_ptr();
+    }
+
+    ZSTD_DDict* ddict = ZSTD_createDDict(dictionary.data(), dictionary.size());
+    if (!ddict)
+    {
+        throw std::runtime_error("Failed to load Zstandard decompression dictionary");
+    }
+    return zstd_ddict_ptr(ddict, [](const ZSTD_DDict* p) { ZSTD_freeDDict(const_cast<ZSTD_DDict*>(p)); });
+}
+
+class zstd_compressor : public compress_provider
+{
+public:
+    static const utility::string_t ZSTD;
+
+    zstd_compressor(int compressionLevel = ZSTD_CLEVEL_DEFAULT, zstd_cdict_ptr dictionary = zstd_cdict_ptr())
+        : m_stream(ZSTD_createCCtx()), m_dictionary(std::move(dictionary)), m_algorithm(ZSTD)
+    {
+        if (m_stream && m_dictionary)
+        {
+            // The compression level is then the one the dictionary was digested with
+            m_state = ZSTD_CCtx_refCDict(m_stream, m_dictionary.get());
+        }
+        else if (m_stream)
+        {
+            m_state = ZSTD_CCtx_setParameter(m_stream, ZSTD_c_compressionLevel, compressionLevel);
+        }
+    }
+
+    const utility::string_t& algorithm() const { return m_algorithm; }
+
+    size_t compress(const uint8_t* input,
+                    size_t input_size,
+                    uint8_t* output,
+                    size_t output_size,
+                    operation_hint hint,
+                    size_t& input_bytes_processed,
+                    bool& done)
+    {
+        if (m_done || (hint != operation_hint::is_last && !input_size))
+        {
+            input_bytes_processed = 0;
+            done = m_done;
+            return 0;
+        }
+
+        if (!m_stream)
+        {
+            throw std::runtime_error("Failed to create Zstandard compression stream");
+        }
+        if (ZSTD_isError(m_state))
+        {
+            throw std::runtime_error(std::string("Prior unrecoverable compression stream error ") +
+                                     ZSTD_getErrorName(m_state));
+        }
+
+        ZSTD_inBuffer in = {input, input_size, 0};
+        ZSTD_outBuffer out = {output, output_size, 0};
+
+        // Like the zlib providers, flush on every call so that each chunk can be sent as soon as it is produced
+        m_state = ZSTD_compressStream2(
+            m_stream, &out, &in, (hint == operation_hint::is_last) ? ZSTD_e_end : ZSTD_e_flush);
+        if (ZSTD_isError(m_state))
+        {
+            throw std::runtime_error(std::string("Unrecoverable compression stream error ") +
+                                     ZSTD_getErrorName(m_state));
+        }
+
+        input_bytes_processed = in.pos;
+        m_done = (hint == operation_hint::is_last && in.pos == input_size && m_state == 0);
+        done = m_done;
+        return out.pos;
+    }
+
+    pplx::task<operation_result> compress(
+        const uint8_t* input, size_t input_size, uint8_t* output, size_t output_size, operation_hint hint)
+    {
+        operation_result r;
+
+        try
+        {
+            r.output_bytes_produced =
+                compress(input, input_size, output, output_size, hint, r.input_bytes_processed, r.done);
+        }
+        catch (...)
+        {
+            pplx::task_completion_event<operation_result> ev;
+            ev.set_exception(std::current_exception());
+            return pplx::create_task(ev);
+        }
+
+        return pplx::task_from_result<operation_result>(r);
+    }
+
+    void reset()
+    {
+        // Only the frame is discarded; the compression level and dictionary are kept
+        if (!m_stream)
+        {
+            throw std::runtime_error("Failed to reset Zstandard compressor");
+        }
+
+        m_state = ZSTD_CCtx_reset(m_stream, ZSTD_reset_session_only);
+        m_done = false;
+
+        if (ZSTD_isError(m_state))
+        {
+            throw std::runtime_error("Failed to reset Zstandard compressor");
+        }
+    }
+
+    ~zstd_compressor() { (void)ZSTD_freeCCtx(m_stream); }
+
+private:
+    size_t m_state {0};
+    ZSTD_CCtx* m_stream;
+    bool m_done {false};
+    zstd_cdict_ptr m_dictionary;
+    const utility::string_t& m_algorithm;
+};
+
+const utility::string_t zstd_compressor::ZSTD(algorithm::ZSTD);
+
+class zstd_decompressor : public decompress_provider
+{
+public:
+    zstd_decompressor(zstd_ddict_ptr dictionary = zstd_ddict_ptr())
+        : m_stream(ZSTD_createDCtx()), m_dictionary(std::move(dictionary)), m_algorithm(zstd_compressor::ZSTD)
+    {
+        if (m_stream && m_dictionary)
+        {
+            m_state = ZSTD_DCtx_refDDict(m_stream, m_dictionary.get());
+        }
+    }
+
+    const utility::string_t& algorithm() const { return m_algorithm; }
+
+    size_t decompress(const uint8_t* input,
+                      size_t input_size,
+                      uint8_t* output,
+                      size_t output_size,
+                      operation_hint hint,
+                      size_t& input_bytes_processed,
+                      bool& done)
+    {
+        (void)hint;
+
+        // Unlike zlib, an empty input is passed through, since the decoder may still hold output that did not fit
+        if (m_done)
+        {
+            input_bytes_processed = 0;
+            done = true;
+            return 0;
+        }
+
+        if (!m_stream)
+        {
+            throw std::runtime_error("Failed to create Zstandard decompression stream");
+        }
+        if (ZSTD_isError(m_state))
+        {
+            throw std::runtime_error(std::string("Prior unrecoverable decompression stream error ") +
+                                     ZSTD_getErrorName(m_state));
+        }
+
+        ZSTD_inBuffer in = {input, input_size, 0};
+        ZSTD_outBuffer out = {output, output_size, 0};
+
+        m_state = ZSTD_decompressStream(m_stream, &out, &in);
+        if (ZSTD_isError(m_state))
+        {
+            throw std::runtime_error(std::string("Unrecoverable decompression stream error ") +
+                                     ZSTD_getErrorName(m_state));
+        }
+
+        input_bytes_processed = in.pos;
+        m_done = (m_state == 0);
+        done = m_done;
+        return out.pos;
+    }
+
+    pplx::task<operation_result> decompress(
+        const uint8_t* input, size_t input_size, uint8_t* output, size_t output_size, operation_hint hint)
+    {
+        operation_result r;
+
+        try
+        {
+            r.output_bytes_produced =
+                decompress(input, input_size, output, output_size, hint, r.input_bytes_processed, r.done);
+        }
+        catch (...)
+        {
+            pplx::task_completion_event<operation_result> ev;
+            ev.set_exception(std::current_exception());
+            return pplx::create_task(ev);
+        }
+
+        return pplx::task_from_result<operation_result>(r);
+    }
+
+    void reset()
+    {
+        if (!m_stream)
+        {
+            throw std::runtime_error("Failed to reset Zstandard decompressor");
+        }
+
+        m_state = ZSTD_DCtx_reset(m_stream, ZSTD_reset_session_only);
+        m_done = false;
+
+        if (ZSTD_isError(m_state))
+        {
+            throw std::runtime_error("Failed to reset Zstandard decompressor");
+        }
+    }
+
+    ~zstd_decompressor() { (void)ZSTD_freeDCtx(m_stream); }
+
+private:
+    size_t m_state {0};
+    ZSTD_DCtx* m_stream;
+    bool m_done {false};
+    zstd_ddict_ptr m_dictionary;
+    const utility::string_t& m_algorithm;
+};
+#endif // CPPREST_ZSTD_COMPRESSION
 #endif // CPPREST_HTTP_COMPRESSION
 
 // Generic internal implementation of the compress_factory API
@@ -635,20 +896,246 @@ private:
     std::function<std::unique_ptr<decompress_provider>()> _make_decompressor;
 };
 
+// Free list of idle providers shared by a pooled factory and the providers it has handed out; it is held weakly by
+// the latter, so providers outliving their factory are simply destroyed
+template<typename Provider>
+class provider_pool
+{
+public:
+    explicit provider_pool(size_t max_pooled) : m_max_pooled(max_pooled) {}
+
+    std::unique_ptr<Provider> try_acquire()
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (m_providers.empty())
+        {
+            return std::unique_ptr<Provider>();
+        }
+
+        auto provider = std::move(m_providers.back());
+        m_providers.pop_back();
+        return provider;
+    }
+
+    void release(std::unique_ptr<Provider>& provider)
+    {
+        try
+        {
+            // A provider that cannot be reset is not fit for reuse
+            provider->reset();
+        }
+        catch (...)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (m_providers.size() < m_max_pooled)
+        {
+            m_providers.push_back(std::move(provider));
+        }
+    }
+
+private:
+    std::mutex m_lock;
+    const size_t m_max_pooled;
+    std::vector<std::unique_ptr<Provider>> m_providers;
+};
+
+// Compressor handed out by a pooled factory; forwards to the wrapped provider and returns it to the pool when done
+class pooled_compressor : public compress_provider
+{
+public:
+    pooled_compressor(std::unique_ptr<compress_provider> provider,
+                      const std::shared_ptr<provider_pool<compress_provider>>& pool)
+        : m_provider(std::move(provider)), m_pool(pool)
+    {
+    }
+
+    ~pooled_compressor()
+    {
+        auto pool = m_pool.lock();
+        if (pool)
+        {
+            pool->release(m_provider);
+        }
+    }
+
+    const utility::string_t& algorithm() const { return m_provider->algorithm(); }
+
+    size_t compress(const uint8_t* input,
+                    size_t input_size,
+                    uint8_t* output,
+                    size_t output_size,
+                    operation_hint hint,
+                    size_t& input_bytes_processed,
+                    bool& done)
+    {
+        return m_provider->compress(input, input_size, output, output_size, hint, input_bytes_processed, done);
+    }
+
+    pplx::task<operation_result> compress(
+        const uint8_t* input, size_t input_size, uint8_t* output, size_t output_size, operation_hint hint)
+    {
+        return m_provider->compress(input, input_size, output, output_size, hint);
+    }
+
+    void reset() { m_provider->reset(); }
+
+private:
+    std::unique_ptr<compress_provider> m_provider;
+    std::weak_ptr<provider_pool<compress_provider>> m_pool;
+};
+
+// Decompressor handed out by a pooled factory; forwards to the wrapped provider and returns it to the pool when done
+class pooled_decompressor : public decompress_provider
+{
+public:
+    pooled_decompressor(std::unique_ptr<decompress_provider> provider,
+                        const std::shared_ptr<provider_pool<decompress_provider>>& pool)
+        : m_provider(std::move(provider)), m_pool(pool)
+    {
+    }
+
+    ~pooled_decompressor()
+    {
+        auto pool = m_pool.lock();
+        if (pool)
+        {
+            pool->release(m_provider);
+        }
+    }
+
+    const utility::string_t& algorithm() const { return m_provider->algorithm(); }
+
+    size_t decompress(const uint8_t* input,
+                      size_t input_size,
+                      uint8_t* output,
+                      size_t output_size,
+                      operation_hint hint,
+                      size_t& input_bytes_processed,
+                      bool& done)
+    {
+        return m_provider->decompress(input, input_size, output, output_size, hint, input_bytes_processed, done);
+    }
+
+    pplx::task<operation_result> decompress(
+        const uint8_t* input, size_t input_size, uint8_t* output, size_t output_size, operation_hint hint)
+    {
+        return m_provider->decompress(input, input_size, output, output_size, hint);
+    }
+
+    void reset() { m_provider->reset(); }
+
+private:
+    std::unique_ptr<decompress_provider> m_provider;
+    std::weak_ptr<provider_pool<decompress_provider>> m_pool;
+};
+
+// Internal implementation of the compress_factory API that recycles the providers made by another factory
+class pooled_compress_factory : public compress_factory
+{
+public:
+    ~pooled_compress_factory() CPPREST_NOEXCEPT {}
+    pooled_compress_factory(std::shared_ptr<compress_factory> factory, size_t max_pooled)
+        : m_factory(std::move(factory)), m_pool(std::make_shared<provider_pool<compress_provider>>(max_pooled))
+    {
+    }
+
+    const utility::string_t& algorithm() const { return m_factory->algorithm(); }
+
+    std::unique_ptr<compress_provider> make_compressor() const
+    {
+        auto provider = m_pool->try_acquire();
+        if (!provider)
+        {
+            provider = m_factory->make_compressor();
+            if (!provider)
+            {
+                return provider;
+            }
+        }
+        return utility::details::make_unique<pooled_compressor>(std::move(provider), m_pool);
+    }
+
+private:
+    std::shared_ptr<compress_factory> m_factory;
+    std::shared_ptr<provider_pool<compress_provider>> m_pool;
+};
+
+// Internal implementation of the decompress_factory API that recycles the providers made by another factory
+class pooled_decompress_factory : public decompress_factory
+{
+public:
+    ~pooled_decompress_factory() CPPREST_NOEXCEPT {}
+    pooled_decompress_factory(std::shared_ptr<decompress_factory> factory, size_t max_pooled)
+        : m_factory(std::move(factory)), m_pool(std::make_shared<provider_pool<decompress_provider>>(max_pooled))
+    {
+    }
+
+    const utility::string_t& algorithm() const { return m_factory->algorithm(); }
+
+    uint16_t weight() const { return m_factory->weight(); }
+
+    std::unique_ptr<decompress_provider> make_decompressor() const
+    {
+        auto provider = m_pool->try_acquire();
+        if (!provider)
+        {
+            provider = m_factory->make_decompressor();
+            if (!provider)
+            {
+                return provider;
+            }
+        }
+        return utility::details::make_unique<pooled_decompressor>(std::move(provider), m_pool);
+    }
+
+private:
+    std::shared_ptr<decompress_factory> m_factory;
+    std::shared_ptr<provider_pool<decompress_provider>> m_pool;
+};
+
+#if defined(CPPREST_HTTP_COMPRESSION)
+// Upper bound on the idle providers kept per built-in algorithm
+static const size_t g_builtin_pool_size = 16;
+
+static std::shared_ptr<compress_factory> make_builtin_compress_factory(
+    const utility::string_t& algorithm, std::function<std::unique_ptr<compress_provider>()> make_compressor)
+{
+    return std::make_shared<pooled_compress_factory>(
+        std::make_shared<generic_compress_factory>(algorithm, make_compressor), g_builtin_pool_size);
+}
+
+static std::shared_ptr<decompress_factory> make_builtin_decompress_factory(
+    const utility::string_t& algorithm,
+    uint16_t weight,
+    std::function<std::unique_ptr<decompress_provider>()> make_decompressor)
+{
+    return std::make_shared<pooled_decompress_factory>(
+        std::make_shared<generic_decompress_factory>(algorithm, weight, make_decompressor), g_builtin_pool_size);
+}
+#endif // CPPREST_HTTP_COMPRESSION
+
 // "Private" algorithm-to-factory tables for namespace static helpers
 static const std::vector<std::shared_ptr<compress_factory>> g_compress_factories
 #if defined(CPPREST_HTTP_COMPRESSION)
-    = {std::make_shared<generic_compress_factory>(
+    = {make_builtin_compress_factory(
            algorithm::GZIP,
            []() -> std::unique_ptr<compress_provider> { return utility::details::make_unique<gzip_compressor>(); }),
-       std::make_shared<generic_compress_factory>(
+       make_builtin_compress_factory(
            algorithm::DEFLATE,
            []() -> std::unique_ptr<compress_provider> { return utility::details::make_unique<deflate_compressor>(); }),
 #if defined(CPPREST_BROTLI_COMPRESSION)
-       std::make_shared<generic_compress_factory>(
+       make_builtin_compress_factory(
            algorithm::BROTLI,
-           []() -> std::unique_ptr<compress_provider> { return utility::details::make_unique<brotli_compressor>(); })
+           []() -> std::unique_ptr<compress_provider> { return utility::details::make_unique<brotli_compressor>(); }),
 #endif // CPPREST_BROTLI_COMPRESSION
+#if defined(CPPREST_ZSTD_COMPRESSION)
+       make_builtin_compress_factory(
+           algorithm::ZSTD,
+           []() -> std::unique_ptr<compress_provider> { return utility::details::make_unique<zstd_compressor>(); }),
+#endif // CPPREST_ZSTD_COMPRESSION
 };
 #else  // CPPREST_HTTP_COMPRESSION
     ;
@@ -656,22 +1143,28 @@ static const std::vector<std::shared_ptr<compress_factory>> g_compress_factories
 
 static const std::vector<std::shared_ptr<decompress_factory>> g_decompress_factories
 #if defined(CPPREST_HTTP_COMPRESSION)
-    = {std::make_shared<generic_decompress_factory>(
+    = {make_builtin_decompress_factory(
            algorithm::GZIP,
            500,
            []() -> std::unique_ptr<decompress_provider> { return utility::details::make_unique<gzip_decompressor>(); }),
-       std::make_shared<generic_decompress_factory>(algorithm::DEFLATE,
-                                                    500,
-                                                    []() -> std::unique_ptr<decompress_provider> {
-                                                        return utility::details::make_unique<deflate_decompressor>();
-                                                    }),
+       make_builtin_decompress_factory(algorithm::DEFLATE,
+                                       500,
+                                       []() -> std::unique_ptr<decompress_provider> {
+                                           return utility::details::make_unique<deflate_decompressor>();
+                                       }),
 #if defined(CPPREST_BROTLI_COMPRESSION)
-       std::make_shared<generic_decompress_factory>(algorithm::BROTLI,
-                                                    500,
-                                                    []() -> std::unique_ptr<decompress_provider> {
-                                                        return utility::details::make_unique<brotli_decompressor>();
-                                                    })
+       make_builtin_decompress_factory(algorithm::BROTLI,
+                                       500,
+                                       []() -> std::unique_ptr<decompress_provider> {
+                                           return utility::details::make_unique<brotli_decompressor>();
+                                       }),
 #endif // CPPREST_BROTLI_COMPRESSION
+#if defined(CPPREST_ZSTD_COMPRESSION)
+       make_builtin_decompress_factory(
+           algorithm::ZSTD,
+           500,
+           []() -> std::unique_ptr<decompress_provider> { return utility::details::make_unique<zstd_decompressor>(); }),
+#endif // CPPREST_ZSTD_COMPRESSION
 };
 #else  // CPPREST_HTTP_COMPRESSION
     ;
@@ -797,6 +1290,61 @@ std::unique_ptr<compress_provider> make_brotli_compressor(
     return std::unique_ptr<compress_provider>();
 #endif // CPPREST_BROTLI_COMPRESSION
 }
+
+std::unique_ptr<compress_provider> make_zstd_compressor(int compressionLevel, const std::vector<uint8_t>& dictionary)
+{
+#if defined(CPPREST_HTTP_COMPRESSION) && defined(CPPREST_ZSTD_COMPRESSION)
+    return utility::details::make_unique<zstd_compressor>(compressionLevel,
+                                                          make_zstd_cdict(dictionary, compressionLevel));
+#else  // CPPREST_ZSTD_COMPRESSION
+    (void)compressionLevel;
+    (void)dictionary;
+    return std::unique_ptr<compress_provider>();
+#endif // CPPREST_ZSTD_COMPRESSION
+}
+
+std::unique_ptr<decompress_provider> make_zstd_decompressor(const std::vector<uint8_t>& dictionary)
+{
+#if defined(CPPREST_HTTP_COMPRESSION) && defined(CPPREST_ZSTD_COMPRESSION)
+    return utility::details::make_unique<zstd_decompressor>(make_zstd_ddict(dictionary));
+#else  // CPPREST_ZSTD_COMPRESSION
+    (void)dictionary;
+    return std::unique_ptr<decompress_provider>();
+#endif // CPPREST_ZSTD_COMPRESSION
+}
+
+std::shared_ptr<compress_factory> make_zstd_compress_factory(int compressionLevel,
+                                                             const std::vector<uint8_t>& dictionary)
+{
+#if defined(CPPREST_HTTP_COMPRESSION) && defined(CPPREST_ZSTD_COMPRESSION)
+    // The dictionary is digested once, here, rather than by each provider
+    auto cdict = make_zstd_cdict(dictionary, compressionLevel);
+    return make_builtin_compress_factory(algorithm::ZSTD,
+                                         [compressionLevel, cdict]() -> std::unique_ptr<compress_provider> {
+                                             return utility::details::make_unique<zstd_compressor>(compressionLevel,
+                                                                                                   cdict);
+                                         });
+#else  // CPPREST_ZSTD_COMPRESSION
+    (void)compressionLevel;
+    (void)dictionary;
+    return std::shared_ptr<compress_factory>();
+#endif // CPPREST_ZSTD_COMPRESSION
+}
+
+std::shared_ptr<decompress_factory> make_zstd_decompress_factory(uint16_t weight,
+                                                                 const std::vector<uint8_t>& dictionary)
+{
+#if defined(CPPREST_HTTP_COMPRESSION) && defined(CPPREST_ZSTD_COMPRESSION)
+    auto ddict = make_zstd_ddict(dictionary);
+    return make_builtin_decompress_factory(algorithm::ZSTD, weight, [ddict]() -> std::unique_ptr<decompress_provider> {
+        return utility::details::make_unique<zstd_decompressor>(ddict);
+    });
+#else  // CPPREST_ZSTD_COMPRESSION
+    (void)weight;
+    (void)dictionary;
+    return std::shared_ptr<decompress_factory>();
+#endif // CPPREST_ZSTD_COMPRESSION
+}
 } // namespace builtin
 
 std::shared_ptr<compress_factory> make_compress_factory(
@@ -813,6 +1361,18 @@ std::shared_ptr<decompress_factory> make_decompress_factory(
     return std::make_shared<builtin::generic_decompress_factory>(algorithm, weight, make_decompressor);
 }
 
+std::shared_ptr<compress_factory> make_pooled_compress_factory(std::shared_ptr<compress_factory> factory,
+                                                               size_t max_pooled)
+{
+    return std::make_shared<builtin::pooled_compress_factory>(std::move(factory), max_pooled);
+}
+
+std::shared_ptr<decompress_factory> make_pooled_decompress_factory(std::shared_ptr<decompress_factory> factory,
+                                                                   size_t max_pooled)
+{
+    return std::make_shared<builtin::pooled_decompress_factory>(std::move(factory), max_pooled);
+}
+
 namespace details
 {
 namespace builtin
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
+namespace web
+{
+namespace http
+{
+namespace details
+{
+// A hierarchical timer wheel counting in ticks. Each of the four levels has 64 slots, a slot of one level spanning a
+// whole revolution of the level below, so scheduling and canceling are O(1) and entries due far in the future are only
+// touched when their slot cascades to a lower level. Deadlines are extended without touching the wheel: an entry whose
+// deadline has moved on when its slot comes round is filed again.
+//
+// Not thread safe, other than entry::extend.
+class timer_wheel
+{
+    // links an entry into the circular list of its slot
+    struct node
+    {
+        node() : m_prev(this), m_next(this) {}
+
+        node* m_prev;
+        node* m_next;
+    };
+
+public:
+    class entry : private node
+    {
+    public:
+        explicit entry(std::function<void()> callback) : m_callback(std::move(callback)), m_deadline(0) {}
+
+        entry(const entry&) = delete;
+        entry& operator=(const entry&) = delete;
+
+        // moves the deadline; it may be called concurrently with the wheel advancing
+        void extend(uint64_t deadline) { m_deadline.store(deadline, std::memory_order_relaxed); }
+
+        uint64_t deadline() const { return m_deadline.load(std::memory_order_relaxed); }
+
+        void fire() { m_callback(); }
+
+    private:
+        friend class timer_wheel;
+
+        std::function<void()> m_callback;
+        std::atomic<uint64_t> m_deadline;
+
+        // the entry keeps itself alive while it is filed
+        std::shared_ptr<entry> m_self;
+    };
+
+    explicit timer_wheel(uint64_t now = 0) : m_now(now), m_size(0) {}
+
+    timer_wheel(const timer_wheel&) = delete;
+    timer_wheel& operator=(const timer_wheel&) = delete;
+
+    ~timer_wheel()
+    {
+        for (auto& head : m_slots)
+        {
+            while (head.m_next != &head)
+            {
+                unfile(*static_cast<entry*>(head.m_next));
+            }
+        }
+    }
+
+    uint64_t now() const { return m_now; }
+
+    size_t size() const { return m_size; }
+
+    // files `e` to expire at tick `deadline`, or at the next tick if that has passed; a filed entry is moved
+    void schedule(const std::shared_ptr<entry>& e, uint64_t deadline)
+    {
+        cancel(*e);
+        e->extend((std::max)(deadline, m_now + 1));
+        e->m_self = e;
+        file(*e);
+        ++m_size;
+    }
+
+    // returns true if `e` was filed
+    bool cancel(entry& e)
+    {
+        if (!e.m_self)
+        {
+            return false;
+        }
+
+        unfile(e);
+        return true;
+    }
+
+    // advances to tick `now`, appending the entries which expired on the way to `expired`
+    void advance(uint64_t now, std::vector<std::shared_ptr<entry>>& expired)
+    {
+        while (m_now < now && m_size != 0)
+        {
+            ++m_now;
+            for (size_t level = 1; level < levels && ((m_now >> (level - 1) * bits) & mask) == 0; ++level)
+            {
+                cascade(slot(level, m_now));
+            }
+
+            auto& due = slot(0, m_now);
+            while (due.m_next != &due)
+            {
+                auto& e = *static_cast<entry*>(due.m_next);
+                unlink(e);
+                if (e.deadline() > m_now)
+                {
+                    // the deadline was extended since the entry was filed
+                    file(e);
+                }
+                else
+                {
+                    expired.push_back(std::move(e.m_self));
+                    --m_size;
+                }
+            }
+        }
+
+        if (m_now < now)
+        {
+            m_now = now;
+        }
+    }
+
+private:
+    static const size_t bits = 6;
+    static const size_t slots_per_level = size_t(1) << bits;
+    static const uint64_t mask = slots_per_level - 1;
+    static const size_t levels = 4;
+
+    node& slot(size_t level, uint64_t tick)
+    {
+        return m_slots[level * slots_per_level + static_cast<size_t>((tick >> level * bits) & mask)];
+    }
+
+    void file(entry& e)
+    {
+        // only entries cascading to the current tick are filed in its slot, before it is processed
+        auto deadline = (std::max)(e.deadline(), m_now);
+
+        const uint64_t max_delta = (uint64_t(1) << levels * bits) - 1;
+        if (deadline - m_now > max_delta)
+        {
+            // filed in the furthest slot, and filed again when that comes round
+            deadline = m_now + max_delta;
+        }
+
+        size_t level = 0;
+        while (level + 1 < levels && deadline - m_now >= (uint64_t(1) << (level + 1) * bits))
+        {
+            ++level;
+        }
+
+        auto& head = slot(level, deadline);
+        e.m_prev = head.m_prev;
+        e.m_next = &head;
+        head.m_prev->m_next = &e;
+        head.m_prev = &e;
+    }
+
+    // moves the entries of a higher level slot down to the slots they now fall in
+    void cascade(node& head)
+    {
+        auto n = head.m_next;
+        head.m_prev = &head;
+        head.m_next = &head;
+        while (n != &head)
+        {
+            auto next = n->m_next;
+            file(*static_cast<entry*>(n));
+            n = next;
+        }
+    }
+
+    static void unlink(entry& e)
+    {
+        e.m_prev->m_next = e.m_next;
+        e.m_next->m_prev = e.m_prev;
+        e.m_prev = &e;
+        e.m_next = &e;
+    }
+
+    void unfile(entry& e)
+    {
+        unlink(e);
+        --m_size;
+        e.m_self.reset();
+    }
+
+    uint64_t m_now;
+    size_t m_size;
+    node m_slots[levels * slots_per_level];
+};
+
+} // namespace details
+} // namespace http
+} // namespace web
@@ -0,0 +1,282 @@
+#pragma once
+
+#include <stddef.h>
+
+namespace web
+{
+namespace http
+{
+namespace details
+{
+// The request methods the parser recognizes, so that their names need not be built from the request bytes
+enum class parsed_method
+{
+    other,
+    get,
+    head,
+    post,
+    put,
+    del,
+    options,
+    trace,
+    connect,
+    patch
+};
+
+// An incremental parser of the head of an HTTP/1.1 request, the request line and the header fields up to the empty
+// line. Each call is given all the bytes received so far and resumes where the previous call stopped; the parts are
+// handed to the handler as pointers into those bytes, so the parser itself never allocates.
+//
+// The handler provides, each returning false to fail the request:
+//   bool on_request_line(parsed_method method, const char* name, size_t name_size,
+//                        const char* target, size_t target_size, int major, int minor);
+//   bool on_header(const char* name, size_t name_size, const char* value, size_t value_size);
+class http_request_parser
+{
+public:
+    enum class result
+    {
+        incomplete,
+        complete,
+        error
+    };
+
+    http_request_parser() { reset(); }
+
+    // Prepares the parser for the next request on the connection
+    void reset()
+    {
+        m_state = state::request_line;
+        m_line_start = 0;
+        m_position = 0;
+    }
+
+    // The size of the head, once complete
+    size_t consumed() const { return m_line_start; }
+
+    template<typename Handler>
+    result parse(const char* data, size_t size, Handler& handler)
+    {
+        while (m_state != state::done && m_state != state::failed)
+        {
+            // find the end of the current line; only the bytes not scanned by the previous call are looked at
+            const char* line_end = nullptr;
+            for (; m_position < size; ++m_position)
+            {
+                if (data[m_position] == '\n')
+                {
+                    line_end = data + m_position;
+                    ++m_position;
+                    break;
+                }
+            }
+            if (line_end == nullptr)
+            {
+                return result::incomplete;
+            }
+
+            const char* line = data + m_line_start;
+            size_t line_size = static_cast<size_t>(line_end - line);
+            if (line_size != 0 && line[line_size - 1] == '\r')
+            {
+                --line_size;
+            }
+            m_line_start = m_position;
+
+            switch (m_state)
+            {
+                case state::request_line:
+                    // RFC 7230 section 3.5: empty lines before the request line are ignored
+                    if (line_size != 0)
+                    {
+                        m_state = parse_request_line(line, line_size, handler) ? state::headers : state::failed;
+                    }
+                    break;
+                case state::headers:
+                    if (line_size == 0)
+                    {
+                        m_state = state::done;
+                    }
+                    else if (!parse_header(line, line_size, handler))
+                    {
+                        m_state = state::failed;
+                    }
+                    break;
+                default: break;
+            }
+        }
+
+        return m_state == state::done ? result::complete : result::error;
+    }
+
+    // Characters allowed in a method or a header name, RFC 7230 section 3.2.6
+    static bool is_token_char(unsigned char c)
+    {
+        switch (c)
+        {
+            case '!':
+            case '#':
+            case '$':
+            case '%':
+            case '&':
+            case '\'':
+            case '*':
+            case '+':
+            case '-':
+            case '.':
+            case '^':
+            case '_':
+            case '`':
+            case '|':
+            case '~': return true;
+            default: return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+        }
+    }
+
+    // Compares the bytes to an upper case ASCII name, ignoring case
+    static bool iequals(const char* bytes, const char* upper, size_t size)
+    {
+        for (size_t i = 0; i < size; ++i)
+        {
+            const char c = bytes[i];
+            if ((c >= 'a' && c <= 'z' ? static_cast<char>(c - ('a' - 'A')) : c) != upper[i])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static parsed_method match_method(const char* name, size_t size)
+    {
+        switch (size)
+        {
+            case 3:
+                if (iequals(name, "GET", 3)) return parsed_method::get;
+                if (iequals(name, "PUT", 3)) return parsed_method::put;
+                break;
+            case 4:
+                if (iequals(name, "POST", 4)) return parsed_method::post;
+                if (iequals(name, "HEAD", 4)) return parsed_method::head;
+                break;
+            case 5:
+                if (iequals(name, "PATCH", 5)) return parsed_method::patch;
+                if (iequals(name, "TRACE", 5)) return parsed_method::trace;
+                break;
+            case 6:
+                if (iequals(name, "DELETE", 6)) return parsed_method::del;
+                break;
+            case 7:
+                if (iequals(name, "OPTIONS", 7)) return parsed_method::options;
+                if (iequals(name, "CONNECT", 7)) return parsed_method::connect;
+                break;
+            default: break;
+        }
+        return parsed_method::other;
+    }
+
+private:
+    enum class state
+    {
+        request_line,
+        headers,
+        done,
+        failed
+    };
+
+    static bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+    static bool is_whitespace(char c) { return c == ' ' || c == '\t'; }
+
+    // method SP request-target SP HTTP-version
+    template<typename Handler>
+    static bool parse_request_line(const char* line, size_t size, Handler& handler)
+    {
+        size_t i = 0;
+        while (i < size && is_token_char(static_cast<unsigned char>(line[i])))
+        {
+            ++i;
+        }
+        const size_t method_size = i;
+        if (method_size == 0 || i == size || line[i] != ' ')
+        {
+            return false;
+        }
+
+        const size_t target_start = ++i;
+        while (i < size && static_cast<unsigned char>(line[i]) > ' ' && line[i] != '\x7f')
+        {
+            ++i;
+        }
+        const size_t target_size = i - target_start;
+        if (target_size == 0 || i == size || line[i] != ' ')
+        {
+            return false;
+        }
+
+        const char* version = line + i + 1;
+        if (size - i - 1 != 8 || !iequals(version, "HTTP/", 5) || !is_digit(version[5]) || version[6] != '.' ||
+            !is_digit(version[7]))
+        {
+            return false;
+        }
+
+        return handler.on_request_line(match_method(line, method_size),
+                                       line,
+                                       method_size,
+                                       line + target_start,
+                                       target_size,
+                                       version[5] - '0',
+                                       version[7] - '0');
+    }
+
+    // field-name ":" OWS field-value OWS; whitespace before the colon is tolerated
+    template<typename Handler>
+    static bool parse_header(const char* line, size_t size, Handler& handler)
+    {
+        size_t i = 0;
+        while (i < size && is_token_char(static_cast<unsigned char>(line[i])))
+        {
+            ++i;
+        }
+        size_t name_size = i;
+        while (i < size && is_whitespace(line[i]))
+        {
+            ++i;
+        }
+        if (name_size == 0 || i == size || line[i] != ':')
+        {
+            return false;
+        }
+
+        ++i;
+        while (i < size && is_whitespace(line[i]))
+        {
+            ++i;
+        }
+        const size_t value_start = i;
+        size_t value_end = i;
+        for (; i < size; ++i)
+        {
+            const auto c = static_cast<unsigned char>(line[i]);
+            if ((c < ' ' && c != '\t') || c == 0x7f)
+            {
+                return false;
+            }
+            if (!is_whitespace(line[i]))
+            {
+                value_end = i + 1;
+            }
+        }
+
+        return handler.on_header(line, name_size, line + value_start, value_end - value_start);
+    }
+
+    state m_state;
+    // Where the line being parsed starts, and how far the search for its end got
+    size_t m_line_start;
+    size_t m_position;
+};
+} // namespace details
+} // namespace http
+} // namespace web
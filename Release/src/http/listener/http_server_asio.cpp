@@ -17,6 +17,7 @@
 #include <boost/algorithm/string/find.hpp>
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/asio/read_until.hpp>
+#include <cstring>
 #include <set>
 #include <sstream>
 
@@ -30,8 +31,16 @@
 #if defined(__clang__)
 #pragma clang diagnostic pop
 #endif
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
+#include "../common/asio_sendfile.h"
+#include "../common/asio_socket_options.h"
 #include "../common/internal_http_helpers.h"
+#include "http_request_parser.h"
+#include "route_tree.h"
 #include "cpprest/asyncrt_utils.h"
 #include "http_server_impl.h"
 #include "pplx/threadpool.h"
@@ -57,7 +66,10 @@ using web::http::http_exception;
 using web::http::http_request;
 using web::http::http_response;
 using web::http::methods;
+using web::http::socket_options;
 using web::http::status_codes;
+using web::http::details::stream_acceptor;
+using web::http::details::stream_socket;
 using web::http::experimental::listener::http_listener_config;
 using web::http::experimental::listener::details::http_listener_impl;
 
@@ -120,9 +132,18 @@ class hostport_listener
 {
 private:
     int m_backlog;
-    std::unique_ptr<boost::asio::ip::tcp::acceptor> m_acceptor;
+    socket_options m_socket_options;
+    bool m_send_continue;
+    size_t m_accept_loops;
+    // One acceptor, or one for each accept loop when they share the port with SO_REUSEPORT
+    std::vector<std::unique_ptr<stream_acceptor>> m_acceptors;
+    typedef web::http::details::route_tree<http_listener_impl*> listener_routes;
+
+    // The listeners by path, changed under the lock; each change replaces the routes built from them, so that
+    // requests are routed without taking the lock
     std::map<std::string, http_listener_impl*> m_listeners;
     pplx::extensibility::reader_writer_lock_t m_listeners_lock;
+    std::shared_ptr<const listener_routes> m_routes;
 
     std::mutex m_connections_lock;
     pplx::extensibility::event_t m_all_connections_complete;
@@ -132,6 +153,8 @@ private:
 
     std::string m_host;
     std::string m_port;
+    // Set when the listener accepts connections on a Unix domain socket instead of the host and port
+    std::string m_unix_socket_path;
 
     bool m_is_https;
     const std::function<void(boost::asio::ssl::context&)>& m_ssl_context_callback;
@@ -142,12 +165,17 @@ public:
                       bool is_https,
                       const http_listener_config& config)
         : m_backlog(config.backlog())
-        , m_acceptor()
+        , m_socket_options(config.socket_options())
+        , m_send_continue(config.send_continue())
+        , m_accept_loops((std::max)(config.acceptors(), static_cast<size_t>(1)))
+        , m_acceptors()
         , m_listeners()
         , m_listeners_lock()
+        , m_routes(std::make_shared<listener_routes>())
         , m_connections_lock()
         , m_connections()
         , m_p_server(server)
+        , m_unix_socket_path(utility::conversions::to_utf8string(config.unix_socket_path()))
         , m_is_https(is_https)
         , m_ssl_context_callback(config.get_ssl_context_callback())
     {
@@ -170,126 +198,104 @@ public:
 
     void internal_erase_connection(asio_server_connection*);
 
-    http_listener_impl* find_listener(uri const& u)
+    bool send_continue() const { return m_send_continue; }
+
+    // Finds the listener with the longest path matching the request, setting the parameters its templated segments
+    // capture; the part of the request path it matched is returned in listener_path, if it is templated
+    http_listener_impl* find_listener(uri const& u,
+                                      utility::string_t& listener_path,
+                                      std::map<utility::string_t, utility::string_t>& parameters) const
     {
-        auto path_segments = uri::split_path(uri::decode(u.path()));
-        for (auto i = static_cast<long>(path_segments.size()); i >= 0; --i)
+        const auto routes = std::atomic_load(&m_routes);
+        const auto path = utility::conversions::to_utf8string(uri::decode(u.path()));
+        size_t matched = 0;
+        std::vector<listener_routes::capture> captures;
+        auto found = routes->find(path, matched, captures);
+        if (found == nullptr)
         {
-            std::string path;
-            for (size_t j = 0; j < static_cast<size_t>(i); ++j)
-            {
-                path += "/" + utility::conversions::to_utf8string(path_segments[j]);
-            }
-            path += "/";
+            return nullptr;
+        }
 
-            pplx::extensibility::scoped_read_lock_t lock(m_listeners_lock);
-            auto it = m_listeners.find(path);
-            if (it != m_listeners.end())
+        if (!captures.empty())
+        {
+            listener_path =
+                uri::encode_uri(utility::conversions::to_string_t(path.substr(0, matched)), uri::components::path);
+            for (const auto& capture : captures)
             {
-                return it->second;
+                parameters[utility::conversions::to_string_t(*capture.m_name)] =
+                    utility::conversions::to_string_t(path.substr(capture.m_begin, capture.m_size));
             }
         }
-        return nullptr;
+        return *found;
     }
 
 private:
-    void on_accept(std::unique_ptr<boost::asio::ip::tcp::socket> socket, const boost::system::error_code& ec);
+    void update_routes(const std::map<std::string, http_listener_impl*>& listeners);
+    void accept(size_t loop);
+    void on_accept(std::unique_ptr<stream_socket> socket, const boost::system::error_code& ec, size_t loop);
 };
 
 } // namespace
 
 namespace
 {
-/// This class replaces the regex "\r\n\r\n|[\x00-\x1F]|[\x80-\xFF]"
-// It was added due to issues with regex on Android, however since
-// regex was rather overkill for such a simple parse it makes sense
-// to use it on all *nix platforms.
-//
-// This is used as part of the async_read_until call below; see the
-// following for more details:
-// http://www.boost.org/doc/libs/1_55_0/doc/html/boost_asio/reference/async_read_until/overload4.html
-struct crlfcrlf_nonascii_searcher_t
+// Stores the parts of a request head in the request as the parser hands them over; only the method of an unusual
+// request, the URI, and the header names and values are copied
+class request_head_handler
 {
-    enum class State
-    {
-        none = 0,  // ".\r\n\r\n$"
-        cr = 1,    // "\r.\n\r\n$"
-                   // "  .\r\n\r\n$"
-        crlf = 2,  // "\r\n.\r\n$"
-                   // "    .\r\n\r\n$"
-        crlfcr = 3 // "\r\n\r.\n$"
-                   // "    \r.\n\r\n$"
-                   // "      .\r\n\r\n$"
-    };
+public:
+    request_head_handler(http_request& request) : m_request(request) {}
+
+    bool on_request_line(web::http::details::parsed_method method,
+                         const char* name,
+                         size_t name_size,
+                         const char* target,
+                         size_t target_size,
+                         int major,
+                         int minor)
+    {
+        m_request.set_method(method_name(method, name, name_size));
+        m_request.set_request_uri(utility::conversions::to_string_t(std::string(target, target_size)));
+        m_request._get_impl()->_set_http_version({static_cast<uint8_t>(major), static_cast<uint8_t>(minor)});
+        return true;
+    }
 
-    // This function implements the searcher which "consumes" a certain amount of the input
-    // and returns whether or not there was a match (see above).
-
-    // From the Boost documentation:
-    // "The first member of the return value is an iterator marking one-past-the-end of the
-    //  bytes that have been consumed by the match function. This iterator is used to
-    //  calculate the begin parameter for any subsequent invocation of the match condition.
-    //  The second member of the return value is true if a match has been found, false
-    //  otherwise."
-    template<typename Iter>
-    std::pair<Iter, bool> operator()(const Iter begin, const Iter end) const
-    {
-        // In the case that we end inside a partially parsed match (like abcd\r\n\r),
-        // we need to signal the matcher to give us the partial match back again (\r\n\r).
-        // We use the excluded variable to keep track of this sequence point (abcd.\r\n\r
-        // in the previous example).
-        Iter excluded = begin;
-        Iter cur = begin;
-        State state = State::none;
-        while (cur != end)
+    bool on_header(const char* name, size_t name_size, const char* value, size_t value_size)
+    {
+        auto& headers = m_request.headers();
+        auto header_value = utility::conversions::to_string_t(std::string(value, value_size));
+        if (name_size == 14 && web::http::details::http_request_parser::iequals(name, "CONTENT-LENGTH", 14))
         {
-            const auto c = static_cast<unsigned char>(*cur);
-            if (c == '\r')
-            {
-                if (state == State::crlf)
-                {
-                    state = State::crlfcr;
-                }
-                else
-                {
-                    // In the case of State::cr or State::crlfcr, setting the state here
-                    // "skips" a none state and therefore fails to move up the excluded
-                    // counter.
-                    excluded = cur;
-                    state = State::cr;
-                }
-            }
-            else if (c == '\n')
-            {
-                if (state == State::cr)
-                {
-                    state = State::crlf;
-                }
-                else if (state == State::crlfcr)
-                {
-                    ++cur;
-                    return std::make_pair(cur, true);
-                }
-                else
-                {
-                    state = State::none;
-                }
-            }
-            else if (c <= 0x1Fu || c >= 0x80)
-            {
-                ++cur;
-                return std::make_pair(cur, true);
-            }
-            else
-            {
-                state = State::none;
-            }
-            ++cur;
-            if (state == State::none) excluded = cur;
+            headers[header_names::content_length] = std::move(header_value);
+        }
+        else
+        {
+            headers.add(utility::conversions::to_string_t(std::string(name, name_size)), header_value);
+        }
+        return true;
+    }
+
+private:
+    static web::http::method method_name(web::http::details::parsed_method method, const char* name, size_t size)
+    {
+        using web::http::details::parsed_method;
+        switch (method)
+        {
+            case parsed_method::get: return methods::GET;
+            case parsed_method::head: return methods::HEAD;
+            case parsed_method::post: return methods::POST;
+            case parsed_method::put: return methods::PUT;
+            case parsed_method::del: return methods::DEL;
+            case parsed_method::options: return methods::OPTIONS;
+            case parsed_method::trace: return methods::TRCE;
+            case parsed_method::connect: return methods::CONNECT;
+            case parsed_method::patch: return methods::PATCH;
+            default: return utility::conversions::to_string_t(std::string(name, size));
         }
-        return std::make_pair(excluded, false);
     }
-} crlfcrlf_nonascii_searcher;
+
+    http_request& m_request;
+};
 
 // These structures serve as proof witnesses
 struct will_erase_from_parent_t
@@ -307,9 +313,11 @@ class asio_server_connection
 private:
     typedef void (asio_server_connection::*ResponseFuncPtr)(const http_response& response,
                                                             const boost::system::error_code& ec);
+    typedef will_deref_and_erase_t (asio_server_connection::*HeadFuncPtr)(const boost::system::error_code& ec);
 
-    std::unique_ptr<boost::asio::ip::tcp::socket> m_socket;
+    std::unique_ptr<stream_socket> m_socket;
     boost::asio::streambuf m_request_buf;
+    web::http::details::http_request_parser m_parser;
     boost::asio::streambuf m_response_buf;
     http_linux_server* m_p_server;
     hostport_listener* m_p_parent;
@@ -332,23 +340,26 @@ private:
     size_t m_read_size, m_write_size;
     bool m_close;
     bool m_chunked;
+    bool m_continue_withheld;
     std::atomic<int> m_refs; // track how many threads are still referring to this
 
-    using ssl_stream = boost::asio::ssl::stream<boost::asio::ip::tcp::socket&>;
+    using ssl_stream = boost::asio::ssl::stream<stream_socket&>;
 
     std::unique_ptr<boost::asio::ssl::context> m_ssl_context;
     std::unique_ptr<ssl_stream> m_ssl_stream;
 
-    asio_server_connection(std::unique_ptr<boost::asio::ip::tcp::socket> socket,
+    asio_server_connection(std::unique_ptr<stream_socket> socket,
                            http_linux_server* server,
                            hostport_listener* parent)
         : m_socket(std::move(socket))
         , m_request_buf()
+        , m_parser()
         , m_response_buf()
         , m_p_server(server)
         , m_p_parent(parent)
         , m_close(false)
         , m_chunked(false)
+        , m_continue_withheld(false)
         , m_refs(1)
     {
     }
@@ -361,7 +372,7 @@ private:
 public:
     using refcount_ptr = std::unique_ptr<asio_server_connection, Dereferencer>;
 
-    static refcount_ptr create(std::unique_ptr<boost::asio::ip::tcp::socket> socket,
+    static refcount_ptr create(std::unique_ptr<stream_socket> socket,
                                http_linux_server* server,
                                hostport_listener* parent)
     {
@@ -411,8 +422,12 @@ private:
     ~asio_server_connection() = default;
 
     will_deref_and_erase_t start_request_response();
+    will_deref_and_erase_t read_request_head(HeadFuncPtr handler);
     will_deref_and_erase_t handle_http_line(const boost::system::error_code& ec);
+    will_deref_and_erase_t handle_request_head(const boost::system::error_code& ec);
     will_deref_and_erase_t handle_headers();
+    will_deref_and_erase_t write_continue();
+    will_deref_and_erase_t read_body_and_dispatch();
     will_deref_t handle_body(const boost::system::error_code& ec);
     will_deref_t handle_chunked_header(const boost::system::error_code& ec);
     will_deref_t handle_chunked_body(const boost::system::error_code& ec, int toWrite);
@@ -433,6 +448,13 @@ private:
 
             serialize_headers(response);
 
+            // a client still waiting for 100 Continue takes the reply instead of sending the body
+            if (m_continue_withheld)
+            {
+                (will_deref_and_erase_t) this->async_write(&asio_server_connection::handle_headers_written, response);
+                return pplx::task_from_result();
+            }
+
             // before sending response, the full incoming message need to be processed.
             return get_request().content_ready().then([=](pplx::task<http_request>) {
                 (will_deref_and_erase_t) this->async_write(&asio_server_connection::handle_headers_written, response);
@@ -489,17 +511,6 @@ private:
 
 } // namespace
 
-namespace boost
-{
-namespace asio
-{
-template<>
-struct is_match_condition<crlfcrlf_nonascii_searcher_t> : public boost::true_type
-{
-};
-} // namespace asio
-} // namespace boost
-
 namespace
 {
 const size_t ChunkSize = 4 * 1024;
@@ -516,28 +527,95 @@ void hostport_listener::internal_erase_connection(asio_server_connection* conn)
 
 void hostport_listener::start()
 {
-    // resolve the endpoint address
     auto& service = crossplat::threadpool::shared_instance().service();
-    tcp::resolver resolver(service);
-    // #446: boost resolver does not recognize "+" as a host wildchar
-    tcp::resolver::query query =
-        ("+" == m_host) ? tcp::resolver::query(m_port, boost::asio::ip::resolver_query_base::flags())
-                        : tcp::resolver::query(m_host, m_port, boost::asio::ip::resolver_query_base::flags());
-
-    tcp::endpoint endpoint = *resolver.resolve(query);
-
-    m_acceptor.reset(new tcp::acceptor(service));
-    m_acceptor->open(endpoint.protocol());
-    m_acceptor->set_option(socket_base::reuse_address(true));
-    m_acceptor->bind(endpoint);
-    m_acceptor->listen(0 != m_backlog ? m_backlog : socket_base::max_connections);
-
-    auto socket = new ip::tcp::socket(service);
-    std::unique_ptr<ip::tcp::socket> usocket(socket);
-    m_acceptor->async_accept(*socket, [this, socket](const boost::system::error_code& ec) {
-        std::unique_ptr<ip::tcp::socket> usocket(socket);
-        this->on_accept(std::move(usocket), ec);
-    });
+    // the acceptors are only kept once listening, so that stop() does not remove a socket path another process owns
+    std::vector<std::unique_ptr<stream_acceptor>> acceptors;
+    acceptors.emplace_back(new stream_acceptor(service));
+    const auto acceptor = acceptors.front().get();
+    if (!m_unix_socket_path.empty())
+    {
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+        local::stream_protocol::endpoint endpoint(m_unix_socket_path);
+
+        // a socket left behind by a previous process would make the bind fail
+        struct stat status;
+        if (::stat(m_unix_socket_path.c_str(), &status) == 0 && S_ISSOCK(status.st_mode))
+        {
+            ::unlink(m_unix_socket_path.c_str());
+        }
+
+        acceptor->open(endpoint.protocol());
+        acceptor->bind(endpoint);
+#else
+        throw std::invalid_argument("Unix domain sockets are not supported on this platform");
+#endif
+    }
+    else
+    {
+        // resolve the endpoint address
+        tcp::resolver resolver(service);
+        // #446: boost resolver does not recognize "+" as a host wildchar
+        tcp::resolver::query query =
+            ("+" == m_host) ? tcp::resolver::query(m_port, boost::asio::ip::resolver_query_base::flags())
+                            : tcp::resolver::query(m_host, m_port, boost::asio::ip::resolver_query_base::flags());
+
+        tcp::endpoint endpoint = *resolver.resolve(query);
+
+        acceptor->open(endpoint.protocol());
+        acceptor->set_option(socket_base::reuse_address(true));
+#if defined(SO_REUSEPORT)
+        if (m_accept_loops > 1)
+        {
+            acceptor->set_option(web::http::details::reuse_port(true));
+        }
+#endif
+        acceptor->bind(endpoint);
+    }
+    const int backlog = 0 != m_backlog ? m_backlog : socket_base::max_connections;
+    web::http::details::apply_acceptor_socket_options(
+        *acceptor, acceptor->local_endpoint().protocol(), m_socket_options, backlog);
+    acceptor->listen(backlog);
+
+#if defined(SO_REUSEPORT)
+    // Each further accept loop listens on a socket of its own, bound to the same address and port, so that the kernel
+    // spreads new connections across the loops instead of queueing them all behind one accept
+    if (m_unix_socket_path.empty())
+    {
+        const auto endpoint = acceptor->local_endpoint();
+        while (acceptors.size() < m_accept_loops)
+        {
+            std::unique_ptr<stream_acceptor> shard(new stream_acceptor(service));
+            shard->open(endpoint.protocol());
+            shard->set_option(socket_base::reuse_address(true));
+            shard->set_option(web::http::details::reuse_port(true));
+            shard->bind(endpoint);
+            web::http::details::apply_acceptor_socket_options(
+                *shard, endpoint.protocol(), m_socket_options, backlog);
+            shard->listen(backlog);
+            acceptors.push_back(std::move(shard));
+        }
+    }
+#endif
+
+    std::lock_guard<std::mutex> lock(m_connections_lock);
+    m_acceptors = std::move(acceptors);
+    for (size_t loop = 0; loop < m_accept_loops; ++loop)
+    {
+        accept(loop);
+    }
+}
+
+// Starts the next accept of an accept loop, on the loop's own acceptor if it has one; the loops without share the
+// first acceptor, each keeping an accept outstanding on it
+void hostport_listener::accept(size_t loop)
+{
+    auto socket = new stream_socket(crossplat::threadpool::shared_instance().service());
+    std::unique_ptr<stream_socket> usocket(socket);
+    m_acceptors[loop % m_acceptors.size()]->async_accept(
+        *socket, [this, socket, loop](const boost::system::error_code& ec) {
+            std::unique_ptr<stream_socket> usocket(socket);
+            this->on_accept(std::move(usocket), ec, loop);
+        });
     usocket.release();
 }
 
@@ -549,7 +627,7 @@ void asio_server_connection::close()
     {
         boost::system::error_code ec;
         sock->cancel(ec);
-        sock->shutdown(tcp::socket::shutdown_both, ec);
+        sock->shutdown(socket_base::shutdown_both, ec);
         sock->close(ec);
     }
     get_request()._reply_if_not_already(status_codes::InternalError);
@@ -560,27 +638,31 @@ will_deref_and_erase_t asio_server_connection::start_request_response()
     m_read_size = 0;
     m_read = 0;
     m_request_buf.consume(m_request_buf.size()); // clear the buffer
+    m_parser.reset();
 
+    return read_request_head(&asio_server_connection::handle_http_line);
+}
+
+// Reads whatever arrives next of the request head; the parser finds where it ends
+will_deref_and_erase_t asio_server_connection::read_request_head(HeadFuncPtr handler)
+{
+    auto on_read = [this, handler](const boost::system::error_code& ec, std::size_t) {
+        (will_deref_and_erase_t)(this->*handler)(ec);
+    };
     if (m_ssl_stream)
     {
-        boost::asio::async_read_until(
-            *m_ssl_stream, m_request_buf, CRLFCRLF, [this](const boost::system::error_code& ec, std::size_t) {
-                (will_deref_and_erase_t) this->handle_http_line(ec);
-            });
+        boost::asio::async_read(*m_ssl_stream, m_request_buf, boost::asio::transfer_at_least(1), on_read);
     }
     else
     {
-        boost::asio::async_read_until(*m_socket,
-                                      m_request_buf,
-                                      crlfcrlf_nonascii_searcher,
-                                      [this](const boost::system::error_code& ec, std::size_t) {
-                                          (will_deref_and_erase_t) this->handle_http_line(ec);
-                                      });
+        boost::asio::async_read(*m_socket, m_request_buf, boost::asio::transfer_at_least(1), on_read);
     }
     return will_deref_and_erase_t {};
 }
 
-void hostport_listener::on_accept(std::unique_ptr<ip::tcp::socket> socket, const boost::system::error_code& ec)
+void hostport_listener::on_accept(std::unique_ptr<stream_socket> socket,
+                                  const boost::system::error_code& ec,
+                                  size_t loop)
 {
     // Listener closed
     if (ec == boost::asio::error::operation_aborted)
@@ -593,9 +675,9 @@ void hostport_listener::on_accept(std::unique_ptr<ip::tcp::socket> socket, const
     // Handle successful accept
     if (!ec)
     {
-        boost::asio::ip::tcp::no_delay option(true);
         boost::system::error_code error_ignored;
-        socket->set_option(option, error_ignored);
+        const auto protocol = socket->local_endpoint(error_ignored).protocol();
+        web::http::details::apply_connection_socket_options(*socket, protocol, m_socket_options);
 
         auto conn = asio_server_connection::create(std::move(socket), m_p_server, this);
 
@@ -618,23 +700,22 @@ void hostport_listener::on_accept(std::unique_ptr<ip::tcp::socket> socket, const
         }
     }
 
-    if (m_acceptor)
+    if (!m_acceptors.empty())
     {
         // spin off another async accept
-        auto newSocket = new ip::tcp::socket(crossplat::threadpool::shared_instance().service());
-        std::unique_ptr<ip::tcp::socket> usocket(newSocket);
-        m_acceptor->async_accept(*newSocket, [this, newSocket](const boost::system::error_code& ec) {
-            std::unique_ptr<ip::tcp::socket> usocket(newSocket);
-            this->on_accept(std::move(usocket), ec);
-        });
-        usocket.release();
+        accept(loop);
     }
 }
 
 will_deref_and_erase_t asio_server_connection::handle_http_line(const boost::system::error_code& ec)
 {
-    auto thisRequest = http_request::_create_request(make_unique<linux_request_context>());
-    set_request(thisRequest);
+    set_request(http_request::_create_request(make_unique<linux_request_context>()));
+    return handle_request_head(ec);
+}
+
+will_deref_and_erase_t asio_server_connection::handle_request_head(const boost::system::error_code& ec)
+{
+    auto thisRequest = get_request();
     if (ec)
     {
         // client closed connection
@@ -656,160 +737,133 @@ will_deref_and_erase_t asio_server_connection::handle_http_line(const boost::sys
             return will_deref_and_erase_t {};
         }
     }
-    else
+
+    // parse the request line and headers, resuming after the lines parsed from the earlier reads
+    request_head_handler handler(thisRequest);
+    auto parsed = web::http::details::http_request_parser::result::error;
+    std::string error;
+    try
     {
-        // read http status line
-        std::istream request_stream(&m_request_buf);
-        request_stream.imbue(std::locale::classic());
-        std::skipws(request_stream);
+        parsed = m_parser.parse(
+            boost::asio::buffer_cast<const char*>(m_request_buf.data()), m_request_buf.size(), handler);
+    }
+    catch (const std::exception& e) // may be std::range_error indicating invalid Unicode, or web::uri_exception
+    {
+        error = e.what();
+    }
 
-        web::http::method http_verb;
-#ifndef _UTF16_STRINGS
-        request_stream >> http_verb;
-#else
+    if (parsed == web::http::details::http_request_parser::result::incomplete)
+    {
+        return read_request_head(&asio_server_connection::handle_request_head);
+    }
+    if (parsed == web::http::details::http_request_parser::result::error)
+    {
+        if (error.empty())
         {
-            std::string tmp;
-            request_stream >> tmp;
-            http_verb = utility::conversions::latin1_to_utf16(tmp);
+            thisRequest.reply(status_codes::BadRequest);
         }
-#endif
-
-        if (boost::iequals(http_verb, methods::GET))
-            http_verb = methods::GET;
-        else if (boost::iequals(http_verb, methods::POST))
-            http_verb = methods::POST;
-        else if (boost::iequals(http_verb, methods::PUT))
-            http_verb = methods::PUT;
-        else if (boost::iequals(http_verb, methods::DEL))
-            http_verb = methods::DEL;
-        else if (boost::iequals(http_verb, methods::HEAD))
-            http_verb = methods::HEAD;
-        else if (boost::iequals(http_verb, methods::TRCE))
-            http_verb = methods::TRCE;
-        else if (boost::iequals(http_verb, methods::CONNECT))
-            http_verb = methods::CONNECT;
-        else if (boost::iequals(http_verb, methods::OPTIONS))
-            http_verb = methods::OPTIONS;
-
-        // Check to see if there is not allowed character on the input
-        if (!web::http::details::validate_method(http_verb))
+        else
         {
-            thisRequest.reply(status_codes::BadRequest);
-            m_close = true;
-            (will_erase_from_parent_t) do_bad_response();
-            (will_deref_t) deref();
-            return will_deref_and_erase_t {};
+            thisRequest.reply(status_codes::BadRequest, error);
         }
+        m_close = true;
+        (will_erase_from_parent_t) do_bad_response();
+        (will_deref_t) deref();
+        return will_deref_and_erase_t {};
+    }
+    m_request_buf.consume(m_parser.consumed());
 
-        thisRequest.set_method(http_verb);
+    // if HTTP version is 1.0 then disable pipelining
+    auto requestImpl = thisRequest._get_impl().get();
+    if (requestImpl->http_version() == web::http::http_versions::HTTP_1_0)
+    {
+        m_close = true;
+    }
 
-        std::string http_path_and_version;
-        std::getline(request_stream, http_path_and_version);
-        const size_t VersionPortionSize = sizeof(" HTTP/1.1\r") - 1;
+    // Get the remote IP address; connections over a Unix domain socket have none
+    boost::system::error_code socket_ec;
+    auto endpoint = m_socket->remote_endpoint(socket_ec);
+    if (!socket_ec && web::http::details::is_tcp_protocol(endpoint.protocol()))
+    {
+        tcp::endpoint tcp_endpoint;
+        std::memcpy(tcp_endpoint.data(), endpoint.data(), endpoint.size());
+        tcp_endpoint.resize(endpoint.size());
+        requestImpl->_set_remote_address(utility::conversions::to_string_t(tcp_endpoint.address().to_string()));
+    }
 
-        // Make sure path and version is long enough to contain the HTTP version
-        if (http_path_and_version.size() < VersionPortionSize + 2)
-        {
-            thisRequest.reply(status_codes::BadRequest);
-            m_close = true;
-            (will_erase_from_parent_t) do_bad_response();
-            (will_deref_t) deref();
-            return will_deref_and_erase_t {};
-        }
+    return handle_headers();
+}
 
-        // Get the path - remove the version portion and prefix space
-        try
-        {
-            thisRequest.set_request_uri(utility::conversions::to_string_t(
-                http_path_and_version.substr(1, http_path_and_version.size() - VersionPortionSize - 1)));
-        }
-        catch (const std::exception& e) // may be std::range_error indicating invalid Unicode, or web::uri_exception
-        {
-            thisRequest.reply(status_codes::BadRequest, e.what());
-            m_close = true;
-            (will_erase_from_parent_t) do_bad_response();
-            (will_deref_t) deref();
-            return will_deref_and_erase_t {};
-        }
+will_deref_and_erase_t asio_server_connection::handle_headers()
+{
+    auto currentRequest = get_request();
 
-        // Get the version
-        std::string http_version =
-            http_path_and_version.substr(http_path_and_version.size() - VersionPortionSize + 1, VersionPortionSize - 2);
+    m_chunked = false;
+    m_continue_withheld = false;
+    utility::string_t name;
+    // check if the client has requested we close the connection
+    if (currentRequest.headers().match(header_names::connection, name))
+    {
+        m_close = boost::iequals(name, U("close"));
+    }
 
-        auto requestImpl = thisRequest._get_impl().get();
-        web::http::http_version parsed_version = web::http::http_version::from_string(http_version);
-        requestImpl->_set_http_version(parsed_version);
+    if (currentRequest.headers().match(header_names::transfer_encoding, name))
+    {
+        m_chunked = boost::ifind_first(name, U("chunked"));
+    }
 
-        // if HTTP version is 1.0 then disable pipelining
-        if (parsed_version == web::http::http_versions::HTTP_1_0)
-        {
-            m_close = true;
-        }
+    if (!currentRequest.headers().match(header_names::content_length, m_read_size))
+    {
+        m_read_size = 0;
+    }
 
-        // Get the remote IP address
-        boost::system::error_code socket_ec;
-        auto endpoint = m_socket->remote_endpoint(socket_ec);
-        if (!socket_ec)
+    // check if the client waits for the go-ahead before sending the body
+    if ((m_chunked || m_read_size != 0) && currentRequest.headers().match(header_names::expect, name) &&
+        boost::iequals(name, U("100-continue")))
+    {
+        if (m_p_parent->send_continue())
         {
-            requestImpl->_set_remote_address(utility::conversions::to_string_t(endpoint.address().to_string()));
+            return write_continue();
         }
 
-        return handle_headers();
+        // the body only follows if the client gives up waiting before the reply is sent
+        m_continue_withheld = true;
+        m_close = true;
     }
+
+    return read_body_and_dispatch();
 }
 
-will_deref_and_erase_t asio_server_connection::handle_headers()
+will_deref_and_erase_t asio_server_connection::write_continue()
 {
-    std::istream request_stream(&m_request_buf);
-    request_stream.imbue(std::locale::classic());
-    std::string header;
-
-    auto currentRequest = get_request();
-    auto& headers = currentRequest.headers();
-
-    while (std::getline(request_stream, header) && header != "\r")
-    {
-        auto colon = header.find(':');
-        if (colon != std::string::npos && colon != 0)
+    // the interim response goes out before the request is dispatched, so that it cannot interleave with the reply
+    std::ostream os(&m_response_buf);
+    os << "HTTP/1.1 100 Continue" << CRLFCRLF;
+    auto handler = [this](const boost::system::error_code& ec, std::size_t) {
+        if (ec)
         {
-            auto name = utility::conversions::to_string_t(header.substr(0, colon));
-            auto value = utility::conversions::to_string_t(
-                header.substr(colon + 1, header.length() - (colon + 1))); // also exclude '\r'
-            web::http::details::trim_whitespace(name);
-            web::http::details::trim_whitespace(value);
-
-            if (boost::iequals(name, header_names::content_length))
-            {
-                headers[header_names::content_length] = value;
-            }
-            else
-            {
-                headers.add(name, value);
-            }
+            (will_deref_and_erase_t) finish_request_response();
         }
         else
         {
-            currentRequest.reply(status_codes::BadRequest);
-            m_close = true;
-            (will_erase_from_parent_t) do_bad_response();
-            (will_deref_t) deref();
-            return will_deref_and_erase_t {};
+            (will_deref_and_erase_t) read_body_and_dispatch();
         }
-    }
+    };
 
-    m_chunked = false;
-    utility::string_t name;
-    // check if the client has requested we close the connection
-    if (currentRequest.headers().match(header_names::connection, name))
+    if (m_ssl_stream)
     {
-        m_close = boost::iequals(name, U("close"));
+        boost::asio::async_write(*m_ssl_stream, m_response_buf, handler);
     }
-
-    if (currentRequest.headers().match(header_names::transfer_encoding, name))
+    else
     {
-        m_chunked = boost::ifind_first(name, U("chunked"));
+        boost::asio::async_write(*m_socket, m_response_buf, handler);
     }
+    return will_deref_and_erase_t {};
+}
 
+will_deref_and_erase_t asio_server_connection::read_body_and_dispatch()
+{
+    auto currentRequest = get_request();
     currentRequest._get_impl()->_prepare_to_receive_data();
     if (m_chunked)
     {
@@ -818,11 +872,6 @@ will_deref_and_erase_t asio_server_connection::handle_headers()
         return dispatch_request_to_listener();
     }
 
-    if (!currentRequest.headers().match(header_names::content_length, m_read_size))
-    {
-        m_read_size = 0;
-    }
-
     if (m_read_size == 0)
     {
         currentRequest._get_impl()->_complete(0);
@@ -1007,9 +1056,11 @@ will_deref_and_erase_t asio_server_connection::dispatch_request_to_listener()
     // locate the listener:
     http_listener_impl* pListener = nullptr;
     auto currentRequest = get_request();
+    utility::string_t listener_path;
+    std::map<utility::string_t, utility::string_t> parameters;
     try
     {
-        pListener = m_p_parent->find_listener(currentRequest.relative_uri());
+        pListener = m_p_parent->find_listener(currentRequest.relative_uri(), listener_path, parameters);
     }
     catch (const std::exception&) // may be web::uri_exception, or std::range_error indicating invalid Unicode
     {
@@ -1027,7 +1078,8 @@ will_deref_and_erase_t asio_server_connection::dispatch_request_to_listener()
         return will_deref_and_erase_t {};
     }
 
-    currentRequest._set_listener_path(pListener->uri().path());
+    currentRequest._set_listener_path(listener_path.empty() ? pListener->uri().path() : listener_path);
+    currentRequest._set_path_parameters(std::move(parameters));
     (will_erase_from_parent_t) do_response();
 
     // Look up the lock for the http_listener.
@@ -1082,15 +1134,22 @@ void asio_server_connection::serialize_headers(http_response response)
     {
         m_chunked = true;
     }
-    if (!response.headers().match(header_names::content_length, m_write_size) && response.body())
+    // a response to HEAD describes the representation without carrying it
+    const bool head = get_request().method() == methods::HEAD;
+    if (!response.headers().match(header_names::content_length, m_write_size) && response.body() && !head)
     {
         m_chunked = true;
         response.headers()[header_names::transfer_encoding] = U("chunked");
     }
-    if (!response.body())
+    if (!response.body() && !(head && response.headers().has(header_names::content_length)))
     {
         response.headers().add(header_names::content_length, 0);
     }
+    if (head)
+    {
+        m_chunked = false;
+        m_write_size = 0;
+    }
 
     for (const auto& header : response.headers())
     {
@@ -1166,6 +1225,34 @@ will_deref_and_erase_t asio_server_connection::handle_write_large_response(const
     if (readbuf.is_eof())
         return cancel_sending_response_with_error(
             response, std::make_exception_ptr(http_exception("Response stream close early!")));
+
+    // On plain TCP, file bodies go straight from the file to the socket
+    const int fd = m_ssl_stream ? -1 : web::http::details::sendfile_descriptor(readbuf);
+    const std::streamoff offset = fd == -1 ? -1 : static_cast<std::streamoff>(readbuf.getpos(std::ios_base::in));
+    if (offset >= 0)
+    {
+        // Move the read position first: once the bytes are on the wire, the handler may already close the stream
+        readbuf.seekoff(static_cast<std::streamoff>(m_write_size - m_write), std::ios_base::cur, std::ios_base::in);
+        web::http::details::async_sendfile(
+            *m_socket,
+            fd,
+            static_cast<uint64_t>(offset),
+            m_write_size - m_write,
+            [=](const boost::system::error_code& ec, size_t sent) {
+                m_write += sent;
+                if (ec == boost::asio::error::eof)
+                {
+                    (will_deref_and_erase_t) cancel_sending_response_with_error(
+                        response, std::make_exception_ptr(http_exception("Response stream close early!")));
+                }
+                else
+                {
+                    (will_deref_and_erase_t) handle_write_large_response(response, ec);
+                }
+            });
+        return will_deref_and_erase_t {};
+    }
+
     size_t readBytes = (std::min)(ChunkSize, m_write_size - m_write);
     readbuf.getn(buffer_cast<uint8_t*>(m_response_buf.prepare(readBytes)), readBytes)
         .then([=](pplx::task<size_t> actualSizeTask) -> will_deref_and_erase_t {
@@ -1242,7 +1329,13 @@ void hostport_listener::stop()
     // halt existing connections
     {
         std::lock_guard<std::mutex> lock(m_connections_lock);
-        m_acceptor.reset();
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+        if (!m_acceptors.empty() && !m_unix_socket_path.empty())
+        {
+            ::unlink(m_unix_socket_path.c_str());
+        }
+#endif
+        m_acceptors.clear();
         for (auto connection : m_connections)
         {
             connection->close();
@@ -1259,8 +1352,12 @@ void hostport_listener::add_listener(const std::string& path, http_listener_impl
     if (m_is_https != (listener->uri().scheme() == U("https")))
         throw std::invalid_argument(
             "Error: http_listener can not simultaneously listen both http and https paths of one host");
-    else if (!m_listeners.insert(std::map<std::string, http_listener_impl*>::value_type(path, listener)).second)
+    auto listeners = m_listeners;
+    if (!listeners.insert(std::map<std::string, http_listener_impl*>::value_type(path, listener)).second)
         throw std::invalid_argument("Error: http_listener is already registered for this path");
+
+    update_routes(listeners);
+    m_listeners = std::move(listeners);
 }
 
 void hostport_listener::remove_listener(const std::string& path, http_listener_impl*)
@@ -1268,6 +1365,21 @@ void hostport_listener::remove_listener(const std::string& path, http_listener_i
     pplx::extensibility::scoped_rw_lock_t lock(m_listeners_lock);
 
     if (m_listeners.erase(path) != 1) throw std::invalid_argument("Error: no http_listener found for this path");
+    update_routes(m_listeners);
+}
+
+// Builds the routes to the listeners and publishes them; lookups still using the previous routes keep them alive
+void hostport_listener::update_routes(const std::map<std::string, http_listener_impl*>& listeners)
+{
+    auto routes = std::make_shared<listener_routes>();
+    for (const auto& listener : listeners)
+    {
+        if (!routes->insert(listener.first, listener.second))
+        {
+            throw std::invalid_argument("Error: http_listener is already registered for this path");
+        }
+    }
+    std::atomic_store(&m_routes, std::shared_ptr<const listener_routes>(std::move(routes)));
 }
 
 pplx::task<void> http_linux_server::start()
@@ -1310,12 +1422,21 @@ pplx::task<void> http_linux_server::stop()
     return pplx::task_from_result();
 }
 
-std::pair<std::string, std::string> canonical_parts(const uri& uri)
+// Listeners accepting connections on the same host and port, or on the same Unix domain socket, share the endpoint
+std::pair<std::string, std::string> canonical_parts(const uri& uri, const utility::string_t& unix_socket_path)
 {
     std::string endpoint;
-    endpoint += utility::conversions::to_utf8string(uri::decode(uri.host()));
-    endpoint += ":";
-    endpoint += to_string(uri.port());
+    if (!unix_socket_path.empty())
+    {
+        endpoint += "unix:";
+        endpoint += utility::conversions::to_utf8string(unix_socket_path);
+    }
+    else
+    {
+        endpoint += utility::conversions::to_utf8string(uri::decode(uri.host()));
+        endpoint += ":";
+        endpoint += to_string(uri.port());
+    }
 
     auto path = utility::conversions::to_utf8string(uri::decode(uri.path()));
 
@@ -1329,7 +1450,7 @@ std::pair<std::string, std::string> canonical_parts(const uri& uri)
 
 pplx::task<void> http_linux_server::register_listener(http_listener_impl* listener)
 {
-    auto parts = canonical_parts(listener->uri());
+    auto parts = canonical_parts(listener->uri(), listener->configuration().unix_socket_path());
     auto hostport = parts.first;
     auto path = parts.second;
     bool is_https = listener->uri().scheme() == U("https");
@@ -1379,7 +1500,7 @@ pplx::task<void> http_linux_server::register_listener(http_listener_impl* listen
 
 pplx::task<void> http_linux_server::unregister_listener(http_listener_impl* listener)
 {
-    auto parts = canonical_parts(listener->uri());
+    auto parts = canonical_parts(listener->uri(), listener->configuration().unix_socket_path());
     auto hostport = parts.first;
     auto path = parts.second;
     // First remove the listener from hostport listener
@@ -0,0 +1,256 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace web
+{
+namespace http
+{
+namespace details
+{
+// Maps listener paths to values, matching request paths by longest prefix of whole segments. A segment written as
+// "{name}" matches any one segment, which the lookup captures under that name.
+//
+// The tree is compressed: a chain of static segments without branches is one edge. Empty segments are skipped, so
+// "/a//b/" is the same path as "/a/b". Lookups only allocate to keep the segments templated segments match.
+template<typename Value>
+class route_tree
+{
+public:
+    // A segment of the request path matched by a templated segment
+    struct capture
+    {
+        const std::string* m_name;
+        size_t m_begin;
+        size_t m_size;
+    };
+
+    route_tree() : m_root(new node()) {}
+
+    // Adds the value for a path, returning false if the path already has one. Throws std::invalid_argument if a
+    // templated segment conflicts with one of another path in the same position.
+    bool insert(const std::string& path, Value value)
+    {
+        std::vector<std::string> segments;
+        size_t position = 0, begin = 0, size = 0;
+        while (next_segment(path, position, begin, size))
+        {
+            segments.push_back(path.substr(begin, size));
+        }
+
+        node* current = m_root.get();
+        size_t i = 0;
+        while (i < segments.size())
+        {
+            const auto& segment = segments[i];
+            if (is_parameter(segment))
+            {
+                auto name = segment.substr(1, segment.size() - 2);
+                if (!current->m_parameter)
+                {
+                    current->m_parameter.reset(new node());
+                    current->m_parameter->m_edge.push_back(std::move(name));
+                }
+                else if (current->m_parameter->m_edge.front() != name)
+                {
+                    throw std::invalid_argument("Error: the path segment {" + name + "} conflicts with {" +
+                                                current->m_parameter->m_edge.front() + "} of another path");
+                }
+                current = current->m_parameter.get();
+                ++i;
+                continue;
+            }
+
+            auto child = find_child(*current, segment.data(), segment.size());
+            if (child == nullptr)
+            {
+                // a new edge holds the static segments up to the next templated one
+                std::unique_ptr<node> added(new node());
+                while (i < segments.size() && !is_parameter(segments[i]))
+                {
+                    added->m_edge.push_back(segments[i++]);
+                }
+                current = add_child(*current, std::move(added));
+                continue;
+            }
+
+            // follow the edge as far as it agrees with the path, splitting it where they part
+            size_t common = 0;
+            while (common < child->m_edge.size() && i < segments.size() && child->m_edge[common] == segments[i])
+            {
+                ++common;
+                ++i;
+            }
+            if (common < child->m_edge.size())
+            {
+                split(*child, common);
+            }
+            current = child;
+        }
+
+        if (current->m_has_value)
+        {
+            return false;
+        }
+        current->m_value = std::move(value);
+        current->m_has_value = true;
+        return true;
+    }
+
+    // Finds the value of the longest path matching a prefix of the request path, preferring static segments over
+    // templated ones. On success, `matched` is set to the length of the prefix matched, and `captures` to the segments
+    // the templated segments of the path matched.
+    const Value* find(const std::string& path, size_t& matched, std::vector<capture>& captures) const
+    {
+        match best {nullptr, 0, 0};
+        std::vector<capture> current;
+        find(*m_root, path, 0, 0, current, best, captures);
+        matched = best.m_matched;
+        return best.m_value;
+    }
+
+private:
+    struct node
+    {
+        node() : m_value(), m_has_value(false) {}
+
+        // the static segments of the edge leading here, or the name of a templated segment
+        std::vector<std::string> m_edge;
+        // children by their first segment, in order
+        std::vector<std::unique_ptr<node>> m_children;
+        std::unique_ptr<node> m_parameter;
+        Value m_value;
+        bool m_has_value;
+    };
+
+    struct match
+    {
+        const Value* m_value;
+        size_t m_matched;
+        size_t m_depth;
+    };
+
+    static bool is_parameter(const std::string& segment)
+    {
+        return segment.size() > 2 && segment.front() == '{' && segment.back() == '}';
+    }
+
+    // Finds the segment starting at or after `position`, skipping slashes
+    static bool next_segment(const std::string& path, size_t& position, size_t& begin, size_t& size)
+    {
+        while (position < path.size() && path[position] == '/')
+        {
+            ++position;
+        }
+        if (position == path.size())
+        {
+            return false;
+        }
+        begin = position;
+        while (position < path.size() && path[position] != '/')
+        {
+            ++position;
+        }
+        size = position - begin;
+        return true;
+    }
+
+    static bool less_than(const std::unique_ptr<node>& child, const std::pair<const char*, size_t>& segment)
+    {
+        const auto& first = child->m_edge.front();
+        return first.compare(0, first.size(), segment.first, segment.second) < 0;
+    }
+
+    static node* find_child(const node& parent, const char* segment, size_t size)
+    {
+        const auto key = std::make_pair(segment, size);
+        auto it = std::lower_bound(parent.m_children.begin(), parent.m_children.end(), key, less_than);
+        if (it != parent.m_children.end() && (*it)->m_edge.front().compare(0, std::string::npos, segment, size) == 0)
+        {
+            return it->get();
+        }
+        return nullptr;
+    }
+
+    static node* add_child(node& parent, std::unique_ptr<node> child)
+    {
+        const auto& first = child->m_edge.front();
+        const auto key = std::make_pair(first.data(), first.size());
+        auto it = std::lower_bound(parent.m_children.begin(), parent.m_children.end(), key, less_than);
+        return parent.m_children.insert(it, std::move(child))->get();
+    }
+
+    // Splits the edge into `at` static segments leading to a node which keeps the rest and the children
+    static void split(node& edge, size_t at)
+    {
+        std::unique_ptr<node> rest(new node());
+        rest->m_edge.assign(edge.m_edge.begin() + at, edge.m_edge.end());
+        rest->m_children = std::move(edge.m_children);
+        rest->m_parameter = std::move(edge.m_parameter);
+        rest->m_value = std::move(edge.m_value);
+        rest->m_has_value = edge.m_has_value;
+
+        edge.m_edge.resize(at);
+        edge.m_children.clear();
+        edge.m_children.push_back(std::move(rest));
+        edge.m_value = Value();
+        edge.m_has_value = false;
+    }
+
+    static void find(const node& at,
+                     const std::string& path,
+                     size_t position,
+                     size_t depth,
+                     std::vector<capture>& current,
+                     match& best,
+                     std::vector<capture>& captures)
+    {
+        if (at.m_has_value && (best.m_value == nullptr || depth > best.m_depth))
+        {
+            best.m_value = &at.m_value;
+            best.m_matched = position;
+            best.m_depth = depth;
+            captures = current;
+        }
+
+        size_t begin = 0, size = 0;
+        size_t next = position;
+        if (!next_segment(path, next, begin, size))
+        {
+            return;
+        }
+
+        // the static child sharing the segment, if its whole edge matches
+        if (auto child = find_child(at, path.data() + begin, size))
+        {
+            size_t edge_end = next;
+            bool matches = true;
+            for (size_t i = 1; matches && i < child->m_edge.size(); ++i)
+            {
+                size_t edge_begin = 0, edge_size = 0;
+                matches = next_segment(path, edge_end, edge_begin, edge_size) &&
+                          child->m_edge[i].compare(0, std::string::npos, path.data() + edge_begin, edge_size) == 0;
+            }
+            if (matches)
+            {
+                find(*child, path, edge_end, depth + child->m_edge.size(), current, best, captures);
+            }
+        }
+
+        if (at.m_parameter)
+        {
+            current.push_back(capture {&at.m_parameter->m_edge.front(), begin, size});
+            find(*at.m_parameter, path, next, depth + 1, current, best, captures);
+            current.pop_back();
+        }
+    }
+
+    std::unique_ptr<node> m_root;
+};
+} // namespace details
+} // namespace http
+} // namespace web
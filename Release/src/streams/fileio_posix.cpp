@@ -605,6 +605,22 @@ utility::size64_t _get_size(_In_ concurrency::streams::details::_file_info* info
     return utility::size64_t(newpos / char_size);
 }
 
+/// <summary>
+/// Get the POSIX file descriptor of the underlying file, for transfers that bypass the stream buffer.
+/// </summary>
+/// <param name="info">The file info record of the file</param>
+/// <returns>The file descriptor, or -1 if the file is closed</returns>
+int _get_native_fd(_In_ concurrency::streams::details::_file_info* info)
+{
+    if (info == nullptr) return -1;
+
+    _file_info_impl* fInfo = static_cast<_file_info_impl*>(info);
+
+    pplx::extensibility::scoped_recursive_lock_t lock(info->m_lock);
+
+    return fInfo->m_handle;
+}
+
 /// <summary>
 /// Adjust the internal buffers and pointers when the application seeks to a new read location in the stream.
 /// </summary>
@@ -947,6 +947,12 @@ utility::size64_t __cdecl _get_size(_In_ concurrency::streams::details::_file_in
         return 0;
 }
 
+/// <summary>
+/// Get the POSIX file descriptor of the underlying file; Windows file handles are not file descriptors.
+/// </summary>
+/// <returns>-1</returns>
+int __cdecl _get_native_fd(_In_ concurrency::streams::details::_file_info*) { return -1; }
+
 /// <summary>
 /// Adjust the internal buffers and pointers when the application seeks to a new write location in the stream.
 /// </summary>
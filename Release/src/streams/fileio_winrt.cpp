@@ -667,6 +667,12 @@ utility::size64_t __cdecl _get_size(_In_ concurrency::streams::details::_file_in
     return utility::size64_t(fInfo->m_stream->Size / char_size);
 }
 
+/// <summary>
+/// Get the POSIX file descriptor of the underlying file; WinRT streams have no file descriptor.
+/// </summary>
+/// <returns>-1</returns>
+int __cdecl _get_native_fd(_In_ Concurrency::streams::details::_file_info*) { return -1; }
+
 /// <summary>
 /// Adjust the internal buffers and pointers when the application seeks to a new write location in the stream.
 /// </summary>
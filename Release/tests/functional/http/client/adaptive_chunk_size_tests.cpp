@@ -0,0 +1,77 @@
+#include "stdafx.h"
+
+#include "../../../src/http/common/adaptive_chunk_size.h"
+
+using namespace web::http;
+using namespace web::http::client;
+using namespace web::http::client::details;
+using namespace tests::functional::http::utilities;
+
+namespace tests
+{
+namespace functional
+{
+namespace http
+{
+namespace client
+{
+SUITE(adaptive_chunk_size_tests)
+{
+    TEST(initial_size_clamped)
+    {
+        VERIFY_ARE_EQUAL(4096u, adaptive_chunk_size(1024, 4096, 65536).size());
+        VERIFY_ARE_EQUAL(65536u, adaptive_chunk_size(1 << 20, 4096, 65536).size());
+        VERIFY_ARE_EQUAL(16384u, adaptive_chunk_size(16384, 4096, 65536).size());
+    }
+
+    TEST(grows_when_full_chunks_are_ready)
+    {
+        adaptive_chunk_size chunk(16384, 4096, 65536);
+        chunk.record_chunk(16384, 100);
+        VERIFY_ARE_EQUAL(16384u, chunk.size());
+        chunk.record_chunk(8192, 16384);
+        VERIFY_ARE_EQUAL(16384u, chunk.size());
+        chunk.record_chunk(16384, 16384);
+        VERIFY_ARE_EQUAL(32768u, chunk.size());
+        chunk.record_chunk(32768, 65536);
+        chunk.record_chunk(65536, 65536);
+        VERIFY_ARE_EQUAL(65536u, chunk.size());
+    }
+
+    TEST(shrinks_for_small_messages)
+    {
+        adaptive_chunk_size chunk(16384, 4096, 65536);
+        chunk.record_message(8192);
+        VERIFY_ARE_EQUAL(16384u, chunk.size());
+        chunk.record_message(100);
+        VERIFY_ARE_EQUAL(8192u, chunk.size());
+        chunk.record_message(100);
+        chunk.record_message(100);
+        VERIFY_ARE_EQUAL(4096u, chunk.size());
+    }
+
+    TEST_FIXTURE(uri_address, adaptive_client_transfers_large_bodies)
+    {
+        test_http_server::scoped_server scoped(m_uri);
+        http_client_config config;
+        config.set_chunksize(1024);
+        config.set_adaptive_chunksize(true, 512, 16 * 1024);
+        http_client client(m_uri, config);
+
+        const std::string body(256 * 1024, 'a');
+        for (int i = 0; i < 2; ++i)
+        {
+            auto request = scoped.server()->next_request();
+            auto response = client.request(methods::PUT, U("/"), body);
+            auto p_request = request.get();
+            VERIFY_ARE_EQUAL(body.size(), p_request->m_body.size());
+            p_request->reply(status_codes::OK, U("OK"), std::map<utility::string_t, utility::string_t>(), body);
+            VERIFY_ARE_EQUAL(body, response.get().extract_utf8string(true).get());
+        }
+    }
+} // SUITE(adaptive_chunk_size_tests)
+
+} // namespace client
+} // namespace http
+} // namespace functional
+} // namespace tests
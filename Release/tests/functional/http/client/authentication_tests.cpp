@@ -686,7 +686,7 @@ SUITE(authentication_tests)
 
         http_client_config config;
         config.set_nativehandle_options([](native_handle handle) {
-            boost::asio::ip::tcp::socket* socket = static_cast<boost::asio::ip::tcp::socket*>(handle);
+            auto socket = static_cast<boost::asio::generic::stream_protocol::socket*>(handle);
             // Socket shouldn't be open yet since no requests have gone out.
             VERIFY_ARE_EQUAL(false, socket->is_open());
         });
@@ -700,8 +700,8 @@ SUITE(authentication_tests)
         handle_timeout([] {
             http_client_config config;
             config.set_nativehandle_options([](native_handle handle) {
-                boost::asio::ssl::stream<boost::asio::ip::tcp::socket&>* streamobj =
-                    static_cast<boost::asio::ssl::stream<boost::asio::ip::tcp::socket&>*>(handle);
+                typedef boost::asio::ssl::stream<boost::asio::generic::stream_protocol::socket&> ssl_stream;
+                ssl_stream* streamobj = static_cast<ssl_stream*>(handle);
                 const auto& tcpLayer = streamobj->lowest_layer();
                 VERIFY_ARE_EQUAL(false, tcpLayer.is_open());
             });
@@ -0,0 +1,167 @@
+/***
+ * Copyright (C) Microsoft. All rights reserved.
+ * Licensed under the MIT license. See LICENSE.txt file in the project root for full license information.
+ *
+ * =+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+ *
+ * cache_tests.cpp
+ *
+ * Tests cases for the response cache of http_client.
+ *
+ * =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+ ****/
+
+#include "stdafx.h"
+
+using namespace web::http;
+using namespace web::http::client;
+
+using namespace tests::functional::http::utilities;
+
+namespace tests
+{
+namespace functional
+{
+namespace http
+{
+namespace client
+{
+SUITE(cache_tests)
+{
+    typedef std::map<utility::string_t, utility::string_t> headers_map;
+
+    static http_client_config cache_config(size_t max_bytes = 1024 * 1024)
+    {
+        http_client_config config;
+        config.set_response_cache_size(max_bytes);
+        return config;
+    }
+
+    // Sends a GET which must reach the server, and answers it
+    static http_response fetch(http_client& client,
+                               test_http_server* p_server,
+                               const utility::string_t& path,
+                               const headers_map& headers,
+                               const utf8string& body)
+    {
+        auto request = p_server->next_request();
+        auto response = client.request(methods::GET, path);
+        auto p_request = request.get();
+        http_asserts::assert_test_request_equals(p_request, methods::GET, path);
+        p_request->reply(status_codes::OK, U("OK"), headers, body);
+        return response.get();
+    }
+
+    TEST_FIXTURE(uri_address, fresh_response_served_from_memory)
+    {
+        test_http_server::scoped_server scoped(m_uri);
+        http_client client(m_uri, cache_config());
+
+        headers_map headers;
+        headers[header_names::cache_control] = U("max-age=60");
+        auto first = fetch(client, scoped.server(), U("/config"), headers, "cached body");
+        VERIFY_ARE_EQUAL(U("cached body"), first.extract_string(true).get());
+
+        for (int i = 0; i < 2; ++i)
+        {
+            auto hit = client.request(methods::GET, U("/config"));
+            VERIFY_IS_TRUE(hit.is_done());
+            auto response = hit.get();
+            VERIFY_ARE_EQUAL(status_codes::OK, response.status_code());
+            VERIFY_IS_TRUE(response.headers().has(header_names::age));
+            VERIFY_ARE_EQUAL(U("cached body"), response.extract_string(true).get());
+        }
+    }
+
+    TEST_FIXTURE(uri_address, etag_revalidation)
+    {
+        test_http_server::scoped_server scoped(m_uri);
+        http_client client(m_uri, cache_config());
+
+        headers_map headers;
+        headers[header_names::cache_control] = U("no-cache");
+        headers[header_names::etag] = U("\"v1\"");
+        fetch(client, scoped.server(), U("/"), headers, "validated body");
+
+        auto request = scoped.server()->next_request();
+        auto response = client.request(methods::GET);
+        auto p_request = request.get();
+        utility::string_t etag;
+        VERIFY_IS_TRUE(p_request->match_header(header_names::if_none_match, etag));
+        VERIFY_ARE_EQUAL(U("\"v1\""), etag);
+        p_request->reply(status_codes::NotModified);
+
+        auto result = response.get();
+        VERIFY_ARE_EQUAL(status_codes::OK, result.status_code());
+        VERIFY_ARE_EQUAL(U("validated body"), result.extract_string(true).get());
+    }
+
+    TEST_FIXTURE(uri_address, vary_selects_variant)
+    {
+        test_http_server::scoped_server scoped(m_uri);
+        http_client client(m_uri, cache_config());
+
+        http_request json(methods::GET);
+        json.headers().add(header_names::accept, U("application/json"));
+        headers_map headers;
+        headers[header_names::cache_control] = U("max-age=60");
+        headers[header_names::vary] = U("Accept");
+        auto request = scoped.server()->next_request();
+        auto response = client.request(json);
+        request.get()->reply(status_codes::OK, U("OK"), headers, "json");
+        response.get().content_ready().wait();
+
+        http_request same(methods::GET);
+        same.headers().add(header_names::accept, U("application/json"));
+        VERIFY_IS_TRUE(client.request(same).is_done());
+
+        http_request xml(methods::GET);
+        xml.headers().add(header_names::accept, U("application/xml"));
+        request = scoped.server()->next_request();
+        response = client.request(xml);
+        request.get()->reply(status_codes::OK, U("OK"), headers, "xml");
+        VERIFY_ARE_EQUAL(U("xml"), response.get().extract_string(true).get());
+    }
+
+    TEST_FIXTURE(uri_address, no_store_and_invalidation)
+    {
+        test_http_server::scoped_server scoped(m_uri);
+        http_client client(m_uri, cache_config());
+
+        headers_map headers;
+        headers[header_names::cache_control] = U("no-store");
+        fetch(client, scoped.server(), U("/"), headers, "not stored");
+        headers[header_names::cache_control] = U("max-age=60");
+        fetch(client, scoped.server(), U("/"), headers, "stored");
+        VERIFY_IS_TRUE(client.request(methods::GET).is_done());
+
+        auto request = scoped.server()->next_request();
+        auto post = client.request(methods::POST);
+        request.get()->reply(status_codes::OK);
+        post.wait();
+
+        fetch(client, scoped.server(), U("/"), headers, "refetched");
+    }
+
+    TEST_FIXTURE(uri_address, lru_eviction)
+    {
+        test_http_server::scoped_server scoped(m_uri);
+        http_client client(m_uri, cache_config(1500));
+
+        headers_map headers;
+        headers[header_names::cache_control] = U("max-age=60");
+        const utf8string body(1000, 'x');
+        fetch(client, scoped.server(), U("/a"), headers, body);
+        VERIFY_IS_TRUE(client.request(methods::GET, U("/a")).is_done());
+
+        // Storing /b goes over the limit, so the least recently used /a is evicted
+        fetch(client, scoped.server(), U("/b"), headers, body);
+        VERIFY_IS_TRUE(client.request(methods::GET, U("/b")).is_done());
+        fetch(client, scoped.server(), U("/a"), headers, body);
+    }
+} // SUITE(cache_tests)
+
+} // namespace client
+} // namespace http
+} // namespace functional
+} // namespace tests
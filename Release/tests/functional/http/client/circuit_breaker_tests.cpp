@@ -0,0 +1,218 @@
+/***
+ * Copyright (C) Microsoft. All rights reserved.
+ * Licensed under the MIT license. See LICENSE.txt file in the project root for full license information.
+ *
+ * =+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+ *
+ * circuit_breaker_tests.cpp
+ *
+ * Tests cases for failing requests to unhealthy hosts with a circuit breaker.
+ *
+ * =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+ ****/
+
+#include "stdafx.h"
+
+#include "cpprest/http_listener.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+using namespace web::http;
+using namespace web::http::client;
+using namespace web::http::experimental::listener;
+
+namespace tests
+{
+namespace functional
+{
+namespace http
+{
+namespace client
+{
+SUITE(circuit_breaker_tests)
+{
+    // A listener replying with a status code the test may change, after an optional delay
+    class status_listener
+    {
+    public:
+        status_listener(status_code code, std::chrono::milliseconds delay = std::chrono::milliseconds(0))
+            : m_listener(U("http://localhost:34568/")), m_code(code), m_requests(0)
+        {
+            m_listener.support([this, delay](http_request request) {
+                ++m_requests;
+                std::this_thread::sleep_for(delay);
+                request.reply(m_code.load());
+            });
+            m_listener.open().wait();
+        }
+
+        ~status_listener() { m_listener.close().wait(); }
+
+        void set_code(status_code code) { m_code = code; }
+        int requests() const { return m_requests; }
+
+    private:
+        http_listener m_listener;
+        std::atomic<status_code> m_code;
+        std::atomic<int> m_requests;
+    };
+
+    // Records the state changes reported by a circuit breaker
+    struct state_changes
+    {
+        void record(const utility::string_t& host, circuit_state state)
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_hosts.push_back(host);
+            m_states.push_back(state);
+        }
+
+        std::vector<circuit_state> states()
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            return m_states;
+        }
+
+        std::mutex m_lock;
+        std::vector<utility::string_t> m_hosts;
+        std::vector<circuit_state> m_states;
+    };
+
+    circuit_breaker_policy small_window(const std::shared_ptr<state_changes>& changes)
+    {
+        circuit_breaker_policy policy;
+        policy.set_window_size(4);
+        policy.set_minimum_requests(4);
+        policy.set_failure_rate_threshold(0.5);
+        policy.set_state_callback(
+            [changes](const utility::string_t& host, circuit_state state) { changes->record(host, state); });
+        return policy;
+    }
+
+    http_client_config breaker_config(const std::shared_ptr<circuit_breaker>& breaker)
+    {
+        http_client_config config;
+        config.set_circuit_breaker(breaker);
+        return config;
+    }
+
+    TEST(opens_after_failures)
+    {
+        status_listener listener(status_codes::ServiceUnavailable);
+        auto changes = std::make_shared<state_changes>();
+        auto breaker = std::make_shared<circuit_breaker>(small_window(changes));
+        http_client client(U("http://localhost:34568/"), breaker_config(breaker));
+
+        // a success followed by three failures reaches the threshold once the window is full
+        listener.set_code(status_codes::OK);
+        VERIFY_ARE_EQUAL(status_codes::OK, client.request(methods::GET).get().status_code());
+        listener.set_code(status_codes::ServiceUnavailable);
+        for (int i = 0; i < 3; ++i)
+        {
+            VERIFY_IS_TRUE(circuit_state::closed == breaker->state(U("localhost:34568")));
+            VERIFY_ARE_EQUAL(status_codes::ServiceUnavailable, client.request(methods::GET).get().status_code());
+        }
+        VERIFY_IS_TRUE(circuit_state::open == breaker->state(U("localhost:34568")));
+
+        VERIFY_THROWS(client.request(methods::GET).get(), http_exception);
+        VERIFY_ARE_EQUAL(4, listener.requests());
+        VERIFY_ARE_EQUAL(1u, breaker->rejected());
+        VERIFY_ARE_EQUAL(1u, changes->states().size());
+        VERIFY_IS_TRUE(circuit_state::open == changes->states()[0]);
+        VERIFY_ARE_EQUAL(U("localhost:34568"), changes->m_hosts[0]);
+    }
+
+    TEST(successful_trial_closes)
+    {
+        status_listener listener(status_codes::InternalError);
+        auto changes = std::make_shared<state_changes>();
+        auto policy = small_window(changes);
+        policy.set_open_duration(std::chrono::milliseconds(50));
+        policy.set_half_open_requests(2);
+        auto breaker = std::make_shared<circuit_breaker>(policy);
+        http_client client(U("http://localhost:34568/"), breaker_config(breaker));
+
+        for (int i = 0; i < 4; ++i)
+        {
+            client.request(methods::GET).get();
+        }
+        VERIFY_IS_TRUE(circuit_state::open == breaker->state(U("localhost:34568")));
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        listener.set_code(status_codes::OK);
+        VERIFY_ARE_EQUAL(status_codes::OK, client.request(methods::GET).get().status_code());
+        VERIFY_IS_TRUE(circuit_state::half_open == breaker->state(U("localhost:34568")));
+        VERIFY_ARE_EQUAL(status_codes::OK, client.request(methods::GET).get().status_code());
+        VERIFY_IS_TRUE(circuit_state::closed == breaker->state(U("localhost:34568")));
+
+        const auto states = changes->states();
+        VERIFY_ARE_EQUAL(3u, states.size());
+        VERIFY_IS_TRUE(circuit_state::open == states[0]);
+        VERIFY_IS_TRUE(circuit_state::half_open == states[1]);
+        VERIFY_IS_TRUE(circuit_state::closed == states[2]);
+    }
+
+    TEST(failed_trial_reopens)
+    {
+        status_listener listener(status_codes::BadGateway);
+        auto changes = std::make_shared<state_changes>();
+        auto policy = small_window(changes);
+        policy.set_open_duration(std::chrono::milliseconds(50));
+        auto breaker = std::make_shared<circuit_breaker>(policy);
+        http_client client(U("http://localhost:34568/"), breaker_config(breaker));
+
+        for (int i = 0; i < 4; ++i)
+        {
+            client.request(methods::GET).get();
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        VERIFY_ARE_EQUAL(status_codes::BadGateway, client.request(methods::GET).get().status_code());
+        VERIFY_IS_TRUE(circuit_state::open == breaker->state(U("localhost:34568")));
+        VERIFY_THROWS(client.request(methods::GET).get(), http_exception);
+        VERIFY_ARE_EQUAL(5, listener.requests());
+
+        const auto states = changes->states();
+        VERIFY_ARE_EQUAL(3u, states.size());
+        VERIFY_IS_TRUE(circuit_state::open == states[2]);
+    }
+
+    TEST(slow_calls_fail)
+    {
+        status_listener listener(status_codes::OK, std::chrono::milliseconds(100));
+        auto changes = std::make_shared<state_changes>();
+        auto policy = small_window(changes);
+        policy.set_window_size(2);
+        policy.set_slow_call_duration(std::chrono::milliseconds(20));
+        auto breaker = std::make_shared<circuit_breaker>(policy);
+        http_client client(U("http://localhost:34568/"), breaker_config(breaker));
+
+        for (int i = 0; i < 2; ++i)
+        {
+            VERIFY_ARE_EQUAL(status_codes::OK, client.request(methods::GET).get().status_code());
+        }
+        VERIFY_IS_TRUE(circuit_state::open == breaker->state(U("localhost:34568")));
+        VERIFY_THROWS(client.request(methods::GET).get(), http_exception);
+    }
+
+    TEST(connection_errors_fail)
+    {
+        circuit_breaker_policy policy;
+        policy.set_window_size(2);
+        auto breaker = std::make_shared<circuit_breaker>(policy);
+        http_client client(U("http://localhost:34569/"), breaker_config(breaker));
+
+        for (int i = 0; i < 3; ++i)
+        {
+            VERIFY_THROWS(client.request(methods::GET).get(), http_exception);
+        }
+        VERIFY_IS_TRUE(circuit_state::open == breaker->state(U("localhost:34569")));
+        VERIFY_ARE_EQUAL(1u, breaker->rejected());
+    }
+} // SUITE(circuit_breaker_tests)
+
+} // namespace client
+} // namespace http
+} // namespace functional
+} // namespace tests
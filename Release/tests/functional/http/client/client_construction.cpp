@@ -162,6 +162,29 @@ SUITE(client_construction)
         VERIFY_ARE_EQUAL(config2.chunksize(), 1024);
     }
 
+    TEST_FIXTURE(uri_address, client_socket_options)
+    {
+        test_http_server::scoped_server scoped(m_uri);
+
+        socket_options options;
+        options.set_no_delay(false);
+        options.set_send_buffer_size(64 * 1024);
+        options.set_receive_buffer_size(64 * 1024);
+        options.set_keep_alive(true, std::chrono::seconds(30), std::chrono::seconds(5), 3);
+        options.set_fast_open(true);
+        options.set_type_of_service(0x10);
+
+        http_client_config config;
+        config.set_socket_options(options);
+        http_client client(m_uri, config);
+        VERIFY_IS_FALSE(client.client_config().socket_options().no_delay());
+
+        auto request = scoped.server()->next_request();
+        auto response = client.request(methods::GET);
+        request.get()->reply(status_codes::OK);
+        VERIFY_ARE_EQUAL(status_codes::OK, response.get().status_code());
+    }
+
     // Verify that we can get the baseuri from http_client constructors
     TEST_FIXTURE(uri_address, BaseURI_test)
     {
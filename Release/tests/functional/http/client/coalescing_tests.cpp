@@ -0,0 +1,112 @@
+/***
+ * Copyright (C) Microsoft. All rights reserved.
+ * Licensed under the MIT license. See LICENSE.txt file in the project root for full license information.
+ *
+ * =+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+ *
+ * coalescing_tests.cpp
+ *
+ * Tests cases for coalescing identical in-flight requests in http_client.
+ *
+ * =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+ ****/
+
+#include "stdafx.h"
+
+using namespace web::http;
+using namespace web::http::client;
+
+using namespace tests::functional::http::utilities;
+
+namespace tests
+{
+namespace functional
+{
+namespace http
+{
+namespace client
+{
+SUITE(coalescing_tests)
+{
+    static http_client_config coalescing_config()
+    {
+        http_client_config config;
+        config.set_coalesce_requests(true);
+        return config;
+    }
+
+    TEST_FIXTURE(uri_address, identical_requests_share_response)
+    {
+        test_http_server::scoped_server scoped(m_uri);
+        http_client client(m_uri, coalescing_config());
+
+        auto request = scoped.server()->next_request();
+        std::vector<pplx::task<http_response>> responses;
+        for (int i = 0; i < 4; ++i)
+        {
+            responses.push_back(client.request(methods::GET, U("/shared")));
+        }
+
+        auto p_request = request.get();
+        http_asserts::assert_test_request_equals(p_request, methods::GET, U("/shared"));
+        p_request->reply(status_codes::OK, U("OK"), std::map<utility::string_t, utility::string_t>(), "shared body");
+
+        // Each waiter reads its own copy of the body
+        for (auto& response : responses)
+        {
+            auto result = response.get();
+            VERIFY_ARE_EQUAL(status_codes::OK, result.status_code());
+            VERIFY_ARE_EQUAL(U("shared body"), result.extract_string(true).get());
+        }
+
+        // Once answered, the next request is sent upstream again
+        request = scoped.server()->next_request();
+        auto next = client.request(methods::GET, U("/shared"));
+        request.get()->reply(status_codes::NoContent);
+        VERIFY_ARE_EQUAL(status_codes::NoContent, next.get().status_code());
+    }
+
+    TEST_FIXTURE(uri_address, key_headers_distinguish_requests)
+    {
+        test_http_server::scoped_server scoped(m_uri);
+        http_client client(m_uri, coalescing_config());
+
+        http_request json(methods::GET);
+        json.headers().add(header_names::accept, U("application/json"));
+        http_request xml(methods::GET);
+        xml.headers().add(header_names::accept, U("application/xml"));
+
+        auto requests = scoped.server()->next_requests(2);
+        auto first = client.request(json);
+        auto second = client.request(xml);
+
+        requests[0].get()->reply(status_codes::OK);
+        requests[1].get()->reply(status_codes::OK);
+
+        VERIFY_ARE_EQUAL(status_codes::OK, first.get().status_code());
+        VERIFY_ARE_EQUAL(status_codes::OK, second.get().status_code());
+    }
+
+    TEST_FIXTURE(uri_address, canceled_waiter_does_not_cancel_others)
+    {
+        test_http_server::scoped_server scoped(m_uri);
+        http_client client(m_uri, coalescing_config());
+
+        auto request = scoped.server()->next_request();
+        pplx::cancellation_token_source source;
+        auto canceled = client.request(methods::GET, U("/"), source.get_token());
+        auto waiting = client.request(methods::GET, U("/"));
+
+        auto p_request = request.get();
+        source.cancel();
+        VERIFY_THROWS(canceled.get(), http_exception);
+
+        p_request->reply(status_codes::OK);
+        VERIFY_ARE_EQUAL(status_codes::OK, waiting.get().status_code());
+    }
+} // SUITE(coalescing_tests)
+
+} // namespace client
+} // namespace http
+} // namespace functional
+} // namespace tests
@@ -408,6 +408,122 @@ SUITE(compression_tests)
         }
     }
 
+    TEST_FIXTURE(uri_address, compress_and_decompress_zstd)
+    {
+        if (builtin::algorithm::supported(builtin::algorithm::ZSTD))
+        {
+            compress_test(builtin::get_compress_factory(builtin::algorithm::ZSTD),
+                          builtin::get_decompress_factory(builtin::algorithm::ZSTD));
+        }
+    }
+
+    TEST_FIXTURE(uri_address, compress_and_decompress_zstd_dictionary)
+    {
+        if (builtin::algorithm::supported(builtin::algorithm::ZSTD))
+        {
+            std::vector<uint8_t> dictionary(4096);
+            for (size_t i = 0; i < dictionary.size(); ++i)
+            {
+                dictionary[i] = static_cast<uint8_t>('a' + i % 26);
+            }
+
+            auto cfactory = builtin::make_zstd_compress_factory(19, dictionary);
+            auto dfactory = builtin::make_zstd_decompress_factory(1000, dictionary);
+            VERIFY_ARE_EQUAL(cfactory->algorithm(), builtin::algorithm::ZSTD);
+            VERIFY_ARE_EQUAL(dfactory->weight(), 1000);
+            compress_test(cfactory, dfactory);
+
+            // A stream compressed with a dictionary cannot be decoded without it
+            std::vector<uint8_t> input(dictionary.begin(), dictionary.begin() + 1000);
+            std::vector<uint8_t> cmp(2000), dcmp(2000);
+            size_t used;
+            bool done;
+            auto c = cfactory->make_compressor();
+            size_t csize =
+                c->compress(input.data(), input.size(), cmp.data(), cmp.size(), operation_hint::is_last, used, done);
+            VERIFY_IS_TRUE(done);
+            auto d = builtin::make_zstd_decompressor();
+            VERIFY_THROWS(d->decompress(cmp.data(), csize, dcmp.data(), dcmp.size(), operation_hint::is_last, used, done),
+                          std::runtime_error);
+        }
+        else
+        {
+            VERIFY_IS_FALSE((bool)builtin::make_zstd_compressor(3));
+            VERIFY_IS_FALSE((bool)builtin::make_zstd_decompress_factory(500));
+        }
+    }
+
+    TEST(compress_throughput_zstd_vs_gzip)
+    {
+        // Not a pass/fail benchmark; reports the relative speed and ratio of the two algorithms on a text-like body
+        const std::vector<utility::string_t> algorithms = {builtin::algorithm::GZIP, builtin::algorithm::ZSTD};
+        const size_t buffer_size = 4 * 1024 * 1024;
+        const size_t chunk_size = 64 * 1024;
+
+        std::vector<uint8_t> input(buffer_size);
+        for (size_t i = 0; i < buffer_size; ++i)
+        {
+            input[i] = static_cast<uint8_t>(i % 61 < 8 ? std::rand() % 256 : 'a' + (i * 7) % 26);
+        }
+
+        for (auto& algorithm : algorithms)
+        {
+            if (!builtin::algorithm::supported(algorithm))
+            {
+                continue;
+            }
+
+            auto c = builtin::make_compressor(algorithm);
+            auto d = builtin::make_decompressor(algorithm);
+            std::vector<uint8_t> cmp;
+            std::vector<uint8_t> chunk(chunk_size * 2);
+            size_t used;
+            bool done = false;
+
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; !done; i += used)
+            {
+                size_t n = (std::min)(chunk_size, buffer_size - i);
+                size_t got = c->compress(input.data() + i,
+                                         n,
+                                         chunk.data(),
+                                         chunk.size(),
+                                         i + n == buffer_size ? operation_hint::is_last : operation_hint::has_more,
+                                         used,
+                                         done);
+                cmp.insert(cmp.end(), chunk.begin(), chunk.begin() + got);
+            }
+            auto compressed = std::chrono::steady_clock::now();
+
+            std::vector<uint8_t> output(buffer_size);
+            size_t dsize = 0;
+            done = false;
+            for (size_t i = 0; !done && dsize < buffer_size; i += used)
+            {
+                dsize += d->decompress(cmp.data() + i,
+                                       cmp.size() - i,
+                                       output.data() + dsize,
+                                       buffer_size - dsize,
+                                       operation_hint::has_more,
+                                       used,
+                                       done);
+            }
+            auto decompressed = std::chrono::steady_clock::now();
+            VERIFY_IS_TRUE(done);
+            VERIFY_ARE_EQUAL(dsize, buffer_size);
+            VERIFY_IS_TRUE(input == output);
+
+            auto mbps = [buffer_size](std::chrono::steady_clock::duration elapsed) {
+                auto us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+                return us ? static_cast<double>(buffer_size) / static_cast<double>(us) : 0.0;
+            };
+            std::cout << utility::conversions::to_utf8string(algorithm) << ": ratio "
+                      << static_cast<double>(buffer_size) / static_cast<double>(cmp.size()) << ", compress "
+                      << mbps(compressed - start) << " MB/s, decompress " << mbps(decompressed - compressed)
+                      << " MB/s" << std::endl;
+        }
+    }
+
     TEST_FIXTURE(uri_address, compress_headers)
     {
         const utility::string_t _NONE = _XPLATSTR("none");
@@ -915,6 +1031,14 @@ SUITE(compression_tests)
                     dfactories.push_back(dmap[builtin::algorithm::BROTLI]);
                     cfactories.push_back(builtin::get_compress_factory(builtin::algorithm::BROTLI));
                 }
+                if (builtin::algorithm::supported(builtin::algorithm::ZSTD))
+                {
+                    algorithms.push_back(builtin::algorithm::ZSTD);
+                    dmap[builtin::algorithm::ZSTD] = builtin::get_decompress_factory(builtin::algorithm::ZSTD);
+                    cmap[builtin::algorithm::ZSTD] = builtin::get_compress_factory(builtin::algorithm::ZSTD);
+                    dfactories.push_back(dmap[builtin::algorithm::ZSTD]);
+                    cfactories.push_back(cmap[builtin::algorithm::ZSTD]);
+                }
                 algorithms.push_back(fake_provider::FAKE);
                 dmap[fake_provider::FAKE] = make_decompress_factory(
                     fake_provider::FAKE, 1000, [buffer_size]() -> std::unique_ptr<decompress_provider> {
@@ -1349,6 +1473,144 @@ SUITE(compression_tests)
             }
         }
     }
+
+    TEST_FIXTURE(uri_address, decompress_into_response_stream)
+    {
+        test_http_server::scoped_server scoped(m_uri);
+        test_http_server* p_server = scoped.server();
+
+        // Larger than the default chunk size, so that the body arrives in several reads
+        const size_t buffer_size = 200000;
+        std::vector<uint8_t> v(buffer_size);
+        for (size_t x = 0; x < buffer_size; x++)
+        {
+            v[x] = static_cast<uint8_t>('a' + x % 26);
+        }
+
+        web::http::client::http_client_config config;
+        config.set_request_compressed_response(true);
+        http_client client(m_uri, config);
+
+        // Decompress both into the library-owned response buffer and into a caller-supplied container stream
+        for (int user_stream = 0; user_stream < 2; user_stream++)
+        {
+            p_server->next_request().then([&v](test_request* p_request) {
+                std::map<utility::string_t, utility::string_t> headers;
+                headers[header_names::content_encoding] = fake_provider::FAKE;
+                p_request->reply(static_cast<unsigned short>(status_codes::OK), utility::string_t(), headers, v);
+            });
+
+            http_request msg(methods::GET);
+            std::vector<std::shared_ptr<decompress_factory>> dfactories;
+            dfactories.push_back(make_decompress_factory(
+                fake_provider::FAKE, 1000, [buffer_size]() -> std::unique_ptr<decompress_provider> {
+                    return utility::details::make_unique<fake_provider>(buffer_size);
+                }));
+            msg.set_decompress_factories(dfactories);
+
+            concurrency::streams::container_buffer<std::vector<uint8_t>> buf;
+            if (user_stream)
+            {
+                msg.set_response_stream(buf.create_ostream());
+            }
+
+            http_response rsp = client.request(msg).get();
+            VERIFY_ARE_EQUAL(rsp.status_code(), status_codes::OK);
+            VERIFY_NO_THROWS(rsp.content_ready().wait());
+
+            if (user_stream)
+            {
+                VERIFY_ARE_EQUAL(v, buf.collection());
+            }
+            else
+            {
+                VERIFY_ARE_EQUAL(v, rsp.extract_vector().get());
+            }
+        }
+    }
+
+    TEST(pooled_factories_reuse_providers)
+    {
+        size_t created = 0;
+        auto dfactory = make_pooled_decompress_factory(
+            make_decompress_factory(fake_provider::FAKE,
+                                    700,
+                                    [&created]() -> std::unique_ptr<decompress_provider> {
+                                        ++created;
+                                        return utility::details::make_unique<fake_provider>(10);
+                                    }),
+            2);
+        VERIFY_ARE_EQUAL(dfactory->algorithm(), fake_provider::FAKE);
+        VERIFY_ARE_EQUAL(dfactory->weight(), 700);
+
+        {
+            auto d1 = dfactory->make_decompressor();
+            auto d2 = dfactory->make_decompressor();
+            auto d3 = dfactory->make_decompressor();
+            VERIFY_ARE_EQUAL(created, 3);
+            VERIFY_ARE_EQUAL(d1->algorithm(), fake_provider::FAKE);
+
+            // Leave a provider in the "done" state; it must come back reset
+            std::vector<uint8_t> in(10), out(10);
+            size_t used;
+            bool done;
+            d1->decompress(in.data(), in.size(), out.data(), out.size(), operation_hint::is_last, used, done);
+            VERIFY_IS_TRUE(done);
+        }
+
+        {
+            // Only two of the three providers were retained
+            auto d1 = dfactory->make_decompressor();
+            auto d2 = dfactory->make_decompressor();
+            VERIFY_ARE_EQUAL(created, 3);
+            auto d3 = dfactory->make_decompressor();
+            VERIFY_ARE_EQUAL(created, 4);
+
+            std::vector<uint8_t> in(10), out(10);
+            size_t used;
+            bool done;
+            for (auto d : {d1.get(), d2.get()})
+            {
+                VERIFY_ARE_EQUAL(d->decompress(in.data(), 5, out.data(), out.size(), operation_hint::has_more, used, done),
+                                 5);
+                VERIFY_IS_FALSE(done);
+            }
+        }
+
+        created = 0;
+        auto cfactory = make_pooled_compress_factory(
+            make_compress_factory(fake_provider::FAKE, [&created]() -> std::unique_ptr<compress_provider> {
+                ++created;
+                return utility::details::make_unique<fake_provider>();
+            }));
+        VERIFY_ARE_EQUAL(cfactory->algorithm(), fake_provider::FAKE);
+        cfactory->make_compressor();
+        cfactory->make_compressor();
+        VERIFY_ARE_EQUAL(created, 1);
+
+        if (builtin::supported())
+        {
+            // Built-in providers are pooled, so the second round trip of each runs on a reset provider
+            const std::vector<utility::string_t> algorithms {builtin::algorithm::GZIP,
+                                                             builtin::algorithm::DEFLATE,
+                                                             builtin::algorithm::BROTLI,
+                                                             builtin::algorithm::ZSTD};
+            for (auto& algorithm : algorithms)
+            {
+                if (builtin::algorithm::supported(algorithm))
+                {
+                    for (int i = 0; i < 2; i++)
+                    {
+                        compress_and_decompress(builtin::make_compressor(algorithm),
+                                                builtin::make_decompressor(algorithm),
+                                                10000,
+                                                1000,
+                                                true);
+                    }
+                }
+            }
+        }
+    }
 } // SUITE(request_helper_tests)
 } // namespace client
 } // namespace http
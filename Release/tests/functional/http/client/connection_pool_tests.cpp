@@ -33,6 +33,7 @@ SUITE(connection_pooling)
         connectionStack.release(std::make_shared<noisy>(42));
         connectionStack.release(std::make_shared<noisy>(42));
         VERIFY_ARE_EQUAL(3, noisyCount);
+        VERIFY_ARE_EQUAL(3u, connectionStack.size());
         VERIFY_IS_TRUE(connectionStack.free_stale_connections());
         auto tmp = connectionStack.try_acquire();
         VERIFY_ARE_NOT_EQUAL(tmp, std::shared_ptr<noisy> {});
@@ -43,6 +44,7 @@ SUITE(connection_pooling)
         connectionStack.release(std::move(tmp));
         VERIFY_IS_TRUE(connectionStack.free_stale_connections());
         VERIFY_ARE_EQUAL(1, noisyCount);
+        VERIFY_ARE_EQUAL(1u, connectionStack.size());
         VERIFY_IS_FALSE(connectionStack.free_stale_connections());
         VERIFY_ARE_EQUAL(0, noisyCount);
         VERIFY_IS_FALSE(connectionStack.free_stale_connections());
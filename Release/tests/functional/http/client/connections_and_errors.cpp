@@ -203,6 +203,34 @@ SUITE(connections_and_errors)
         VERIFY_THROWS(request.get(), http_exception);
     }
 
+    TEST_FIXTURE(uri_address, response_timing)
+    {
+        test_http_server::scoped_server scoped(m_uri);
+        http_client client(m_uri);
+
+        auto request = scoped.server()->next_request();
+        auto response = client.request(methods::GET);
+        request.get()->reply(status_codes::OK, U("OK"), std::map<utility::string_t, utility::string_t>(), "body");
+        auto result = response.get();
+        result.content_ready().wait();
+
+        const auto& timing = result.timing();
+        const http_timing::clock::time_point unset;
+        VERIFY_ARE_NOT_EQUAL(unset, timing.queued);
+        VERIFY_IS_TRUE(timing.queued <= timing.headers_parsed);
+        VERIFY_IS_TRUE(timing.headers_parsed <= timing.body_complete);
+#if !defined(_WIN32) || defined(CPPREST_FORCE_HTTP_CLIENT_ASIO)
+        VERIFY_IS_FALSE(timing.connection_reused);
+        VERIFY_IS_TRUE(timing.queued <= timing.connection_acquired);
+        VERIFY_IS_TRUE(timing.connection_acquired <= timing.resolved);
+        VERIFY_IS_TRUE(timing.resolved <= timing.connected);
+        VERIFY_IS_TRUE(timing.connected <= timing.request_written);
+        VERIFY_IS_TRUE(timing.request_written <= timing.first_byte);
+        VERIFY_IS_TRUE(timing.first_byte <= timing.headers_parsed);
+        VERIFY_ARE_EQUAL(unset, timing.tls_done);
+#endif
+    }
+
 #if !defined(__cplusplus_winrt)
     TEST_FIXTURE(uri_address, content_ready_timeout)
     {
@@ -0,0 +1,123 @@
+/***
+ * Copyright (C) Microsoft. All rights reserved.
+ * Licensed under the MIT license. See LICENSE.txt file in the project root for full license information.
+ *
+ * =+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+ *
+ * expect_continue_tests.cpp
+ *
+ * Tests cases for holding request bodies back until the server sends 100 Continue.
+ *
+ * =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+ ****/
+
+#include "stdafx.h"
+
+#include "cpprest/containerstream.h"
+#include "cpprest/http_listener.h"
+
+using namespace web::http;
+using namespace web::http::client;
+using namespace web::http::experimental::listener;
+
+using namespace tests::functional::http::utilities;
+
+namespace tests
+{
+namespace functional
+{
+namespace http
+{
+namespace client
+{
+SUITE(expect_continue_tests)
+{
+// Only the asio client holds bodies back.
+#if !defined(_WIN32) || defined(CPPREST_FORCE_HTTP_CLIENT_ASIO)
+    TEST_FIXTURE(uri_address, body_sent_after_continue)
+    {
+        test_http_server::scoped_server scoped(m_uri);
+        http_client_config config;
+        config.set_expect_continue(true, std::chrono::seconds(30));
+        http_client client(m_uri, config);
+
+        const auto start = std::chrono::steady_clock::now();
+        auto request = scoped.server()->next_request();
+        auto response = client.request(methods::PUT, U("/"), "expected body");
+        auto p_request = request.get();
+        VERIFY_ARE_EQUAL(U("100-continue"), p_request->m_headers[header_names::expect]);
+        VERIFY_ARE_EQUAL("expected body", std::string(p_request->m_body.begin(), p_request->m_body.end()));
+        p_request->reply(status_codes::OK);
+        VERIFY_ARE_EQUAL(status_codes::OK, response.get().status_code());
+        VERIFY_IS_TRUE(std::chrono::steady_clock::now() - start < std::chrono::seconds(10));
+    }
+
+    TEST_FIXTURE(uri_address, no_expectation_without_body)
+    {
+        test_http_server::scoped_server scoped(m_uri);
+        http_client_config config;
+        config.set_expect_continue(true);
+        http_client client(m_uri, config);
+
+        auto request = scoped.server()->next_request();
+        auto response = client.request(methods::GET);
+        auto p_request = request.get();
+        VERIFY_ARE_EQUAL(0u, p_request->m_headers.count(header_names::expect));
+        p_request->reply(status_codes::OK);
+        VERIFY_ARE_EQUAL(status_codes::OK, response.get().status_code());
+    }
+
+    TEST_FIXTURE(uri_address, rejected_request_body_not_sent)
+    {
+        http_listener_config listener_config;
+        listener_config.set_send_continue(false);
+        http_listener listener(m_uri, listener_config);
+        listener.support([](http_request request) { request.reply(status_codes::RequestEntityTooLarge); });
+        listener.open().wait();
+
+        http_client_config config;
+        config.set_expect_continue(true, std::chrono::seconds(30));
+        http_client client(m_uri, config);
+
+        const auto start = std::chrono::steady_clock::now();
+        auto body = concurrency::streams::bytestream::open_istream(std::string(1024 * 1024, 'a'));
+        auto response = client.request(methods::PUT, U("/"), body, 1024 * 1024).get();
+        VERIFY_ARE_EQUAL(status_codes::RequestEntityTooLarge, response.status_code());
+        VERIFY_IS_TRUE(std::chrono::steady_clock::now() - start < std::chrono::seconds(10));
+        VERIFY_ARE_EQUAL(0, static_cast<int>(body.tell()));
+
+        // The connection is not reused for the next request.
+        auto second = client.request(methods::PUT, U("/"), "small").get();
+        VERIFY_ARE_EQUAL(status_codes::RequestEntityTooLarge, second.status_code());
+
+        listener.close().wait();
+    }
+
+    TEST_FIXTURE(uri_address, body_sent_when_server_does_not_answer)
+    {
+        http_listener_config listener_config;
+        listener_config.set_send_continue(false);
+        http_listener listener(m_uri, listener_config);
+        listener.support([](http_request request) {
+            request.extract_utf8string(true).then(
+                [request](std::string body) { request.reply(status_codes::OK, body); });
+        });
+        listener.open().wait();
+
+        http_client_config config;
+        config.set_expect_continue(true, std::chrono::milliseconds(100));
+        http_client client(m_uri, config);
+
+        auto response = client.request(methods::PUT, U("/"), "late body").get();
+        VERIFY_ARE_EQUAL(status_codes::OK, response.status_code());
+        VERIFY_ARE_EQUAL("late body", response.extract_utf8string(true).get());
+
+        listener.close().wait();
+    }
+#endif
+} // SUITE(expect_continue_tests)
+
+} // namespace client
+} // namespace http
+} // namespace functional
+} // namespace tests
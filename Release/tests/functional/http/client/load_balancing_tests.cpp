@@ -0,0 +1,209 @@
+/***
+ * Copyright (C) Microsoft. All rights reserved.
+ * Licensed under the MIT license. See LICENSE.txt file in the project root for full license information.
+ *
+ * =+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+ *
+ * load_balancing_tests.cpp
+ *
+ * Tests cases for spreading the requests of one http_client across several endpoints.
+ *
+ * =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+ ****/
+
+#include "stdafx.h"
+
+#include "../../../src/http/common/endpoint_balancer.h"
+#include "cpprest/http_listener.h"
+#include <atomic>
+#include <set>
+
+using namespace web::http;
+using namespace web::http::client;
+using namespace web::http::client::details;
+using namespace web::http::experimental::listener;
+
+using namespace tests::functional::http::utilities;
+
+namespace tests
+{
+namespace functional
+{
+namespace http
+{
+namespace client
+{
+SUITE(load_balancing_tests)
+{
+    load_balancing_policy make_policy(load_balancing_policy::selection strategy)
+    {
+        load_balancing_policy policy;
+        policy.set_strategy(strategy);
+        return policy;
+    }
+
+    TEST(round_robin_cycles_endpoints)
+    {
+        endpoint_balancer balancer(3, make_policy(load_balancing_policy::selection::round_robin));
+        for (size_t i = 0; i < 6; ++i)
+        {
+            VERIFY_ARE_EQUAL(i % 3, balancer.pick());
+        }
+        VERIFY_ARE_EQUAL(2u, balancer.outstanding(0));
+    }
+
+    TEST(least_outstanding_prefers_idle_endpoints)
+    {
+        endpoint_balancer balancer(3, make_policy(load_balancing_policy::selection::least_outstanding));
+        VERIFY_ARE_EQUAL(0u, balancer.pick());
+        VERIFY_ARE_EQUAL(1u, balancer.pick());
+        VERIFY_ARE_EQUAL(2u, balancer.pick());
+        balancer.released(1);
+        VERIFY_ARE_EQUAL(1u, balancer.pick());
+        VERIFY_ARE_EQUAL(1u, balancer.outstanding(1));
+    }
+
+    TEST(power_of_two_choices_prefers_fast_endpoints)
+    {
+        endpoint_balancer balancer(2, make_policy(load_balancing_policy::selection::power_of_two_choices));
+        // endpoints without a response time are preferred until each of them has answered once
+        std::set<size_t> measured;
+        while (measured.size() < 2)
+        {
+            const size_t picked = balancer.pick();
+            balancer.succeeded(picked, std::chrono::microseconds(picked == 0 ? 100500 : 1000));
+            measured.insert(picked);
+        }
+        for (int i = 0; i < 100; ++i)
+        {
+            VERIFY_ARE_EQUAL(1u, balancer.pick());
+        }
+
+        // enough requests in flight outweigh the response time
+        VERIFY_ARE_EQUAL(0u, balancer.pick());
+    }
+
+    TEST(endpoint_ejected_after_connect_failures)
+    {
+        auto policy = make_policy(load_balancing_policy::selection::round_robin);
+        policy.set_ejection(2, std::chrono::seconds(10));
+        endpoint_balancer balancer(2, policy);
+        const auto now = endpoint_balancer::clock::now();
+
+        VERIFY_ARE_EQUAL(0u, balancer.pick(now));
+        VERIFY_IS_FALSE(balancer.connect_failed(0, now));
+        VERIFY_ARE_EQUAL(1u, balancer.pick(now));
+        balancer.succeeded(1, std::chrono::milliseconds(1));
+        VERIFY_ARE_EQUAL(0u, balancer.pick(now));
+        VERIFY_IS_TRUE(balancer.connect_failed(0, now));
+        VERIFY_IS_TRUE(balancer.is_ejected(0, now));
+
+        for (int i = 0; i < 4; ++i)
+        {
+            VERIFY_ARE_EQUAL(1u, balancer.pick(now));
+        }
+
+        // after the ejection the endpoint is tried again, and one more failure ejects it
+        const auto later = now + std::chrono::seconds(11);
+        VERIFY_IS_FALSE(balancer.is_ejected(0, later));
+        size_t picked = balancer.pick(later);
+        if (picked != 0)
+        {
+            picked = balancer.pick(later);
+        }
+        VERIFY_ARE_EQUAL(0u, picked);
+        VERIFY_IS_TRUE(balancer.connect_failed(0, later));
+    }
+
+    TEST(all_endpoints_ejected_are_all_eligible)
+    {
+        auto policy = make_policy(load_balancing_policy::selection::round_robin);
+        policy.set_ejection(1, std::chrono::seconds(10));
+        endpoint_balancer balancer(2, policy);
+        const auto now = endpoint_balancer::clock::now();
+
+        VERIFY_IS_TRUE(balancer.connect_failed(balancer.pick(now), now));
+        VERIFY_IS_TRUE(balancer.connect_failed(balancer.pick(now), now));
+        std::set<size_t> picked;
+        picked.insert(balancer.pick(now));
+        picked.insert(balancer.pick(now));
+        VERIFY_ARE_EQUAL(2u, picked.size());
+    }
+
+    // Counts the requests reaching a listener and the Host header they carried
+    class counting_listener
+    {
+    public:
+        counting_listener(const web::uri& uri) : m_listener(uri), m_count(0)
+        {
+            m_listener.support([this](http_request request) {
+                if (request.headers().has(header_names::host))
+                {
+                    m_host = request.headers()[header_names::host];
+                }
+                ++m_count;
+                request.reply(status_codes::OK);
+            });
+            m_listener.open().wait();
+        }
+
+        ~counting_listener() { m_listener.close().wait(); }
+
+        int count() const { return m_count; }
+        const utility::string_t& host() const { return m_host; }
+
+    private:
+        http_listener m_listener;
+        std::atomic<int> m_count;
+        utility::string_t m_host;
+    };
+
+// Only the asio client balances requests across endpoints.
+#if !defined(_WIN32) || defined(CPPREST_FORCE_HTTP_CLIENT_ASIO)
+    TEST(requests_spread_across_endpoints)
+    {
+        counting_listener first(U("http://localhost:34568/"));
+        counting_listener second(U("http://localhost:34569/"));
+
+        load_balancing_policy policy;
+        policy.set_endpoints({web::uri(U("http://localhost:34568")), web::uri(U("http://localhost:34569"))});
+        http_client_config config;
+        config.set_load_balancing(policy);
+        http_client client(U("http://localhost:34568/"), config);
+
+        for (int i = 0; i < 4; ++i)
+        {
+            VERIFY_ARE_EQUAL(status_codes::OK, client.request(methods::GET).get().status_code());
+        }
+        VERIFY_ARE_EQUAL(2, first.count());
+        VERIFY_ARE_EQUAL(2, second.count());
+
+        // the base URI still names the service
+        VERIFY_ARE_EQUAL(U("localhost:34568"), second.host());
+    }
+
+    TEST(unreachable_endpoint_ejected)
+    {
+        counting_listener live(U("http://localhost:34568/"));
+
+        load_balancing_policy policy;
+        policy.set_endpoints({web::uri(U("http://localhost:34570")), web::uri(U("http://localhost:34568"))});
+        policy.set_ejection(1, std::chrono::seconds(30));
+        http_client_config config;
+        config.set_load_balancing(policy);
+        http_client client(U("http://localhost:34568/"), config);
+
+        VERIFY_THROWS(client.request(methods::GET).get(), http_exception);
+        for (int i = 0; i < 4; ++i)
+        {
+            VERIFY_ARE_EQUAL(status_codes::OK, client.request(methods::GET).get().status_code());
+        }
+        VERIFY_ARE_EQUAL(4, live.count());
+    }
+#endif
+} // SUITE(load_balancing_tests)
+
+} // namespace client
+} // namespace http
+} // namespace functional
+} // namespace tests
@@ -0,0 +1,141 @@
+/***
+ * Copyright (C) Microsoft. All rights reserved.
+ * Licensed under the MIT license. See LICENSE.txt file in the project root for full license information.
+ *
+ * =+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+ *
+ * pool_statistics_tests.cpp
+ *
+ * Tests cases for the connection pool statistics of http_client.
+ *
+ * =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+ ****/
+
+#include "stdafx.h"
+
+// Only the asio client pools connections itself.
+#if !defined(_WIN32) || defined(CPPREST_FORCE_HTTP_CLIENT_ASIO)
+#include "cpprest/http_listener.h"
+#include <condition_variable>
+#include <mutex>
+
+using namespace web::http;
+using namespace web::http::client;
+using namespace web::http::experimental::listener;
+
+namespace tests
+{
+namespace functional
+{
+namespace http
+{
+namespace client
+{
+SUITE(pool_statistics_tests)
+{
+    // A listener answering every request, asking the client to close the connection when close is set
+    http_listener make_listener(bool close)
+    {
+        http_listener listener(U("http://localhost:34568/"));
+        listener.support([close](http_request request) {
+            http_response response(status_codes::OK);
+            if (close)
+            {
+                response.headers().add(header_names::connection, U("close"));
+            }
+            response.set_body(U("pooled"));
+            request.reply(response);
+        });
+        listener.open().wait();
+        return listener;
+    }
+
+    TEST(reused_connections_counted)
+    {
+        auto listener = make_listener(false);
+        http_client client(U("http://localhost:34568/"));
+        for (int i = 0; i < 3; ++i)
+        {
+            VERIFY_ARE_EQUAL(U("pooled"), client.request(methods::GET).get().extract_string().get());
+        }
+
+        const auto statistics = client.pool_statistics();
+        VERIFY_ARE_EQUAL(1u, statistics.size());
+        const auto& host = statistics.at(U("localhost:34568/"));
+        VERIFY_ARE_EQUAL(1u, host.idle);
+        VERIFY_ARE_EQUAL(0u, host.in_use);
+        VERIFY_ARE_EQUAL(1u, host.total);
+        VERIFY_ARE_EQUAL(3u, host.acquires);
+        VERIFY_ARE_EQUAL(2u, host.reuses);
+        VERIFY_ARE_EQUAL(1u, host.new_connections);
+        VERIFY_ARE_EQUAL(0u, host.server_closes);
+        VERIFY_IS_TRUE(host.wait_time.count() > 0);
+
+        listener.close().wait();
+    }
+
+    TEST(server_closes_counted)
+    {
+        auto listener = make_listener(true);
+        http_client client(U("http://localhost:34568/"));
+        for (int i = 0; i < 2; ++i)
+        {
+            VERIFY_ARE_EQUAL(U("pooled"), client.request(methods::GET).get().extract_string().get());
+        }
+
+        const auto host = client.pool_statistics().at(U("localhost:34568/"));
+        VERIFY_ARE_EQUAL(0u, host.idle);
+        VERIFY_ARE_EQUAL(2u, host.acquires);
+        VERIFY_ARE_EQUAL(0u, host.reuses);
+        VERIFY_ARE_EQUAL(2u, host.new_connections);
+        VERIFY_ARE_EQUAL(2u, host.server_closes);
+
+        listener.close().wait();
+    }
+
+    TEST(statistics_pushed_to_callback)
+    {
+        // the reports may still run while the client shuts down, so they only touch shared state
+        struct pushed_statistics
+        {
+            std::mutex lock;
+            std::condition_variable pushed;
+            connection_pool_statistics last;
+        };
+        auto listener = make_listener(false);
+        auto state = std::make_shared<pushed_statistics>();
+
+        http_client_config config;
+        config.set_pool_statistics_callback(
+            [state](const connection_pool_statistics& statistics) {
+                std::lock_guard<std::mutex> guard(state->lock);
+                state->last = statistics;
+                state->pushed.notify_all();
+            },
+            std::chrono::milliseconds(20));
+        {
+            http_client client(U("http://localhost:34568/"), config);
+            client.request(methods::GET).get().extract_string().wait();
+
+            std::unique_lock<std::mutex> guard(state->lock);
+            VERIFY_IS_TRUE(state->pushed.wait_for(guard, std::chrono::seconds(5), [&state] {
+                const auto host = state->last.find(U("localhost:34568/"));
+                return host != state->last.end() && host->second.acquires == 1;
+            }));
+        }
+
+        listener.close().wait();
+    }
+
+    TEST(no_statistics_before_requests)
+    {
+        http_client client(U("http://localhost:34568/"));
+        VERIFY_IS_TRUE(client.pool_statistics().empty());
+    }
+} // SUITE(pool_statistics_tests)
+
+} // namespace client
+} // namespace http
+} // namespace functional
+} // namespace tests
+#endif
@@ -0,0 +1,267 @@
+/***
+ * Copyright (C) Microsoft. All rights reserved.
+ * Licensed under the MIT license. See LICENSE.txt file in the project root for full license information.
+ *
+ * =+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+ *
+ * ranged_download_tests.cpp
+ *
+ * Tests cases for downloading byte ranges of a resource in parallel.
+ *
+ * =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+ ****/
+
+#include "stdafx.h"
+
+#include "cpprest/containerstream.h"
+#include "cpprest/filestream.h"
+#include "cpprest/http_listener.h"
+#include "cpprest/producerconsumerstream.h"
+#include <fstream>
+#include <iterator>
+#include <mutex>
+
+using namespace web::http;
+using namespace web::http::client;
+using namespace web::http::experimental::listener;
+
+using namespace tests::functional::http::utilities;
+
+namespace tests
+{
+namespace functional
+{
+namespace http
+{
+namespace client
+{
+SUITE(ranged_download_tests)
+{
+    std::vector<uint8_t> make_resource(size_t size)
+    {
+        std::vector<uint8_t> data(size);
+        for (size_t i = 0; i < size; ++i)
+        {
+            data[i] = static_cast<uint8_t>(i * 7 + i / 251);
+        }
+        return data;
+    }
+
+    // Serves a resource with byte range support, recording the Range header of each GET
+    class range_server
+    {
+    public:
+        range_server(const web::uri& uri, std::vector<uint8_t> data, bool accept_ranges = true)
+            : m_listener(uri), m_data(std::move(data)), m_accept_ranges(accept_ranges), m_truncate_first(false)
+        {
+            m_listener.support([this](http_request request) { handle(request); });
+            m_listener.open().wait();
+        }
+
+        ~range_server() { m_listener.close().wait(); }
+
+        // The first ranged response stops after half of its range, as if the connection was lost
+        void truncate_first() { m_truncate_first = true; }
+
+        std::vector<utility::string_t> ranges()
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            return m_ranges;
+        }
+
+    private:
+        void handle(http_request request)
+        {
+            http_response response(status_codes::OK);
+            if (m_accept_ranges)
+            {
+                response.headers().add(header_names::accept_ranges, U("bytes"));
+                response.headers().add(header_names::etag, U("\"v1\""));
+            }
+            if (request.method() == methods::HEAD)
+            {
+                response.headers().set_content_length(m_data.size());
+                request.reply(response);
+                return;
+            }
+
+            utility::string_t range;
+            size_t first = 0;
+            size_t last = m_data.size() - 1;
+            bool truncate = false;
+            if (m_accept_ranges && request.headers().match(header_names::range, range))
+            {
+                utility::istringstream_t in(range.substr(6));
+                utility::char_t dash;
+                in >> first >> dash >> last;
+                utility::ostringstream_t content_range;
+                content_range << U("bytes ") << first << U('-') << last << U('/') << m_data.size();
+                response.set_status_code(status_codes::PartialContent);
+                response.headers().add(header_names::content_range, content_range.str());
+
+                std::lock_guard<std::mutex> lock(m_lock);
+                truncate = m_truncate_first && m_ranges.empty();
+                m_ranges.push_back(range);
+            }
+            else
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                m_ranges.push_back(U(""));
+            }
+
+            const size_t length = last - first + 1;
+            if (!truncate)
+            {
+                response.set_body(std::vector<uint8_t>(m_data.begin() + first, m_data.begin() + last + 1));
+                request.reply(response);
+                return;
+            }
+
+            concurrency::streams::producer_consumer_buffer<uint8_t> body;
+            body.putn_nocopy(m_data.data() + first, length / 2).wait();
+            body.close(std::ios_base::out).wait();
+            response.set_body(concurrency::streams::istream(body), length);
+            request.reply(response);
+        }
+
+        http_listener m_listener;
+        std::vector<uint8_t> m_data;
+        bool m_accept_ranges;
+        bool m_truncate_first;
+        std::mutex m_lock;
+        std::vector<utility::string_t> m_ranges;
+    };
+
+    TEST_FIXTURE(uri_address, segments_written_at_offsets)
+    {
+        const auto data = make_resource(1024 * 1024 + 13);
+        range_server server(m_uri, data);
+        http_client client(m_uri);
+
+        ranged_download_options options;
+        options.set_segments(4);
+        options.set_min_segment_size(64 * 1024);
+        std::mutex progress_lock;
+        utility::size64_t last_progress = 0;
+        bool monotonic = true;
+        options.set_progress_handler([&](utility::size64_t written, utility::size64_t total) {
+            std::lock_guard<std::mutex> lock(progress_lock);
+            monotonic = monotonic && written > last_progress && total == data.size();
+            last_progress = written;
+        });
+
+        concurrency::streams::container_buffer<std::vector<uint8_t>> target;
+        VERIFY_ARE_EQUAL(data.size(), download_ranges(client, U("/"), target, options).get());
+        VERIFY_IS_TRUE(data == target.collection());
+        VERIFY_ARE_EQUAL(4u, server.ranges().size());
+        VERIFY_IS_TRUE(monotonic);
+        VERIFY_ARE_EQUAL(data.size(), last_progress);
+    }
+
+    TEST_FIXTURE(uri_address, segments_written_to_file)
+    {
+        const auto data = make_resource(512 * 1024 + 1);
+        range_server server(m_uri, data);
+        http_client client(m_uri);
+
+        ranged_download_options options;
+        options.set_min_segment_size(64 * 1024);
+        auto target = concurrency::streams::file_buffer<uint8_t>::open(U("ranged_download.bin"), std::ios::out).get();
+        VERIFY_ARE_EQUAL(data.size(), download_ranges(client, U("/"), target, options).get());
+        target.close().wait();
+
+        std::ifstream file("ranged_download.bin", std::ios::binary);
+        std::vector<uint8_t> written((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        VERIFY_IS_TRUE(data == written);
+        VERIFY_ARE_EQUAL(4u, server.ranges().size());
+    }
+
+    TEST_FIXTURE(uri_address, small_resource_single_segment)
+    {
+        const auto data = make_resource(1000);
+        range_server server(m_uri, data);
+        http_client client(m_uri);
+
+        concurrency::streams::container_buffer<std::vector<uint8_t>> target;
+        VERIFY_ARE_EQUAL(data.size(), download_ranges(client, U("/"), target).get());
+        VERIFY_IS_TRUE(data == target.collection());
+        VERIFY_ARE_EQUAL(1u, server.ranges().size());
+        VERIFY_ARE_EQUAL(U("bytes=0-999"), server.ranges()[0]);
+    }
+
+    TEST_FIXTURE(uri_address, falls_back_without_accept_ranges)
+    {
+        const auto data = make_resource(300 * 1024);
+        range_server server(m_uri, data, false);
+        http_client client(m_uri);
+
+        ranged_download_options options;
+        options.set_min_segment_size(1024);
+        concurrency::streams::container_buffer<std::vector<uint8_t>> target;
+        VERIFY_ARE_EQUAL(data.size(), download_ranges(client, U("/"), target, options).get());
+        VERIFY_IS_TRUE(data == target.collection());
+        VERIFY_ARE_EQUAL(1u, server.ranges().size());
+        VERIFY_ARE_EQUAL(U(""), server.ranges()[0]);
+    }
+
+    TEST_FIXTURE(uri_address, failed_segment_resumed)
+    {
+        const auto data = make_resource(200 * 1024);
+        range_server server(m_uri, data);
+        server.truncate_first();
+        http_client client(m_uri);
+
+        ranged_download_options options;
+        options.set_segments(1);
+        concurrency::streams::container_buffer<std::vector<uint8_t>> target;
+        VERIFY_ARE_EQUAL(data.size(), download_ranges(client, U("/"), target, options).get());
+        VERIFY_IS_TRUE(data == target.collection());
+
+        const auto ranges = server.ranges();
+        VERIFY_ARE_EQUAL(2u, ranges.size());
+        VERIFY_ARE_EQUAL(U("bytes=0-204799"), ranges[0]);
+
+        // the second request resumes after the bytes received before the connection was lost
+        utility::istringstream_t resumed(ranges[1].substr(6));
+        size_t first = 0;
+        utility::char_t dash;
+        size_t last = 0;
+        resumed >> first >> dash >> last;
+        VERIFY_IS_TRUE(first > 0 && first <= 102400);
+        VERIFY_ARE_EQUAL(204799u, last);
+    }
+
+    TEST_FIXTURE(uri_address, changed_resource_fails)
+    {
+        http_listener listener(m_uri);
+        listener.support([](http_request request) {
+            http_response response(status_codes::OK);
+            response.headers().add(header_names::accept_ranges, U("bytes"));
+            if (request.method() == methods::HEAD)
+            {
+                response.headers().set_content_length(4096);
+                request.reply(response);
+            }
+            else
+            {
+                // Ignores the range, as servers do when the If-Range validator does not match
+                response.set_body(std::vector<uint8_t>(4096));
+                request.reply(response);
+            }
+        });
+        listener.open().wait();
+        http_client client(m_uri);
+
+        ranged_download_options options;
+        options.set_min_segment_size(1024);
+        concurrency::streams::container_buffer<std::vector<uint8_t>> target;
+        VERIFY_THROWS(download_ranges(client, U("/"), target, options).get(), http_exception);
+
+        listener.close().wait();
+    }
+} // SUITE(ranged_download_tests)
+
+} // namespace client
+} // namespace http
+} // namespace functional
+} // namespace tests
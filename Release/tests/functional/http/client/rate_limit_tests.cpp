@@ -0,0 +1,237 @@
+/***
+ * Copyright (C) Microsoft. All rights reserved.
+ * Licensed under the MIT license. See LICENSE.txt file in the project root for full license information.
+ *
+ * =+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+ *
+ * rate_limit_tests.cpp
+ *
+ * Tests cases for limiting the rate and the concurrency of client requests.
+ *
+ * =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+ ****/
+
+#include "stdafx.h"
+
+#include "cpprest/http_listener.h"
+#include <condition_variable>
+#include <mutex>
+
+using namespace web::http;
+using namespace web::http::client;
+using namespace web::http::experimental::listener;
+
+namespace tests
+{
+namespace functional
+{
+namespace http
+{
+namespace client
+{
+SUITE(rate_limit_tests)
+{
+    // A listener which holds on to the requests until the test replies to them
+    class holding_listener
+    {
+    public:
+        holding_listener() : m_listener(U("http://localhost:34568/"))
+        {
+            m_listener.support([this](http_request request) {
+                std::lock_guard<std::mutex> lock(m_lock);
+                m_requests.push_back(request);
+                m_received.notify_all();
+            });
+            m_listener.open().wait();
+        }
+
+        ~holding_listener()
+        {
+            reply_all(status_codes::OK);
+            m_listener.close().wait();
+        }
+
+        // Waits until count requests are held
+        bool wait_for(size_t count)
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            return m_received.wait_for(
+                lock, std::chrono::seconds(10), [this, count] { return m_requests.size() >= count; });
+        }
+
+        size_t held()
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            return m_requests.size();
+        }
+
+        void reply_all(status_code code)
+        {
+            std::vector<http_request> requests;
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                requests.swap(m_requests);
+            }
+            for (auto& request : requests)
+            {
+                request.reply(code).wait();
+            }
+        }
+
+    private:
+        http_listener m_listener;
+        std::mutex m_lock;
+        std::condition_variable m_received;
+        std::vector<http_request> m_requests;
+    };
+
+    http_client_config limited_config(const std::shared_ptr<rate_limiter>& limiter)
+    {
+        http_client_config config;
+        config.set_rate_limiter(limiter);
+        return config;
+    }
+
+    TEST(token_bucket_spaces_requests)
+    {
+        http_listener listener(U("http://localhost:34568/"));
+        listener.support([](http_request request) { request.reply(status_codes::OK); });
+        listener.open().wait();
+
+        rate_limit_policy policy;
+        policy.set_rate(20, 2);
+        auto limiter = std::make_shared<rate_limiter>(policy);
+        http_client client(U("http://localhost:34568/"), limited_config(limiter));
+
+        // the burst passes at once, each further request waits for a token
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<pplx::task<http_response>> responses;
+        for (int i = 0; i < 5; ++i)
+        {
+            responses.push_back(client.request(methods::GET));
+        }
+        VERIFY_IS_TRUE(limiter->queue_depth() >= 2);
+        for (auto& response : responses)
+        {
+            VERIFY_ARE_EQUAL(status_codes::OK, response.get().status_code());
+        }
+        VERIFY_IS_TRUE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(140));
+        VERIFY_ARE_EQUAL(0u, limiter->queue_depth());
+        VERIFY_ARE_EQUAL(0u, limiter->rejected());
+
+        listener.close().wait();
+    }
+
+    TEST(full_queue_rejects)
+    {
+        holding_listener listener;
+
+        rate_limit_policy policy;
+        policy.set_max_in_flight(1);
+        policy.set_max_queue(0);
+        auto limiter = std::make_shared<rate_limiter>(policy);
+        http_client client(U("http://localhost:34568/"), limited_config(limiter));
+
+        auto first = client.request(methods::GET);
+        VERIFY_IS_TRUE(listener.wait_for(1));
+        VERIFY_THROWS(client.request(methods::GET).get(), http_exception);
+        VERIFY_ARE_EQUAL(1u, limiter->rejected());
+
+        listener.reply_all(status_codes::OK);
+        VERIFY_ARE_EQUAL(status_codes::OK, first.get().status_code());
+    }
+
+    TEST(concurrency_limit_queues_requests)
+    {
+        holding_listener listener;
+
+        rate_limit_policy policy;
+        policy.set_max_in_flight(2);
+        auto limiter = std::make_shared<rate_limiter>(policy);
+
+        // clients sharing a limiter share its limit
+        http_client first_client(U("http://localhost:34568/"), limited_config(limiter));
+        http_client second_client(U("http://localhost:34568/"), limited_config(limiter));
+        std::vector<pplx::task<http_response>> responses;
+        for (int i = 0; i < 2; ++i)
+        {
+            responses.push_back(first_client.request(methods::GET));
+            responses.push_back(second_client.request(methods::GET));
+        }
+
+        VERIFY_IS_TRUE(listener.wait_for(2));
+        VERIFY_ARE_EQUAL(2u, limiter->in_flight());
+        VERIFY_ARE_EQUAL(2u, limiter->queue_depth());
+        VERIFY_ARE_EQUAL(2u, listener.held());
+
+        listener.reply_all(status_codes::OK);
+        VERIFY_IS_TRUE(listener.wait_for(2));
+        listener.reply_all(status_codes::OK);
+        for (auto& response : responses)
+        {
+            VERIFY_ARE_EQUAL(status_codes::OK, response.get().status_code());
+        }
+        VERIFY_ARE_EQUAL(0u, limiter->in_flight());
+        VERIFY_ARE_EQUAL(0u, limiter->queue_depth());
+    }
+
+    TEST(adaptive_limit_follows_overload)
+    {
+        status_code reply = status_codes::ServiceUnavailable;
+        http_listener listener(U("http://localhost:34568/"));
+        listener.support([&reply](http_request request) { request.reply(reply); });
+        listener.open().wait();
+
+        rate_limit_policy policy;
+        policy.set_adaptive_concurrency(1, 8);
+        auto limiter = std::make_shared<rate_limiter>(policy);
+        http_client client(U("http://localhost:34568/"), limited_config(limiter));
+        VERIFY_ARE_EQUAL(8u, limiter->concurrency_limit());
+
+        // 8 * 0.9^3 is 5.8
+        for (int i = 0; i < 3; ++i)
+        {
+            VERIFY_ARE_EQUAL(status_codes::ServiceUnavailable, client.request(methods::GET).get().status_code());
+        }
+        VERIFY_ARE_EQUAL(5u, limiter->concurrency_limit());
+
+        // 5.8 + 1/5.8 passes 6
+        reply = status_codes::OK;
+        for (int i = 0; i < 2; ++i)
+        {
+            VERIFY_ARE_EQUAL(status_codes::OK, client.request(methods::GET).get().status_code());
+        }
+        VERIFY_ARE_EQUAL(6u, limiter->concurrency_limit());
+
+        listener.close().wait();
+    }
+
+    TEST(canceled_while_queued)
+    {
+        holding_listener listener;
+
+        rate_limit_policy policy;
+        policy.set_max_in_flight(1);
+        auto limiter = std::make_shared<rate_limiter>(policy);
+        http_client client(U("http://localhost:34568/"), limited_config(limiter));
+
+        auto first = client.request(methods::GET);
+        VERIFY_IS_TRUE(listener.wait_for(1));
+
+        pplx::cancellation_token_source source;
+        auto queued = client.request(methods::GET, source.get_token());
+        VERIFY_ARE_EQUAL(1u, limiter->queue_depth());
+        source.cancel();
+        VERIFY_THROWS(queued.get(), http_exception);
+        VERIFY_ARE_EQUAL(0u, limiter->queue_depth());
+        VERIFY_ARE_EQUAL(1u, listener.held());
+
+        listener.reply_all(status_codes::OK);
+        VERIFY_ARE_EQUAL(status_codes::OK, first.get().status_code());
+    }
+} // SUITE(rate_limit_tests)
+
+} // namespace client
+} // namespace http
+} // namespace functional
+} // namespace tests
@@ -212,6 +212,48 @@ SUITE(request_stream_tests)
         stream_request_impl(m_uri, true, 64 * 1024, U("with_content_length_1.txt"));
     }
 
+    TEST_FIXTURE(uri_address, file_body_larger_than_socket_buffers)
+    {
+        utility::string_t fname = U("file_body_larger_than_socket_buffers.txt");
+        const size_t repetitions = 100000;
+        fill_file(fname, repetitions);
+
+        http_client_config config;
+        config.set_chunksize(16 * 1024);
+        test_http_server::scoped_server scoped(m_uri);
+        http_client client(m_uri, config);
+
+        auto stream = OPEN_R<uint8_t>(fname).get().create_istream();
+        stream.seek(26, std::ios_base::cur);
+        const size_t length = 26 * (repetitions - 1);
+        http_request msg(methods::PUT);
+        msg.set_body(stream, length);
+        utility::size64_t uploaded = 0;
+        msg.set_progress_handler([&](message_direction::direction direction, utility::size64_t so_far) {
+            if (direction == message_direction::upload)
+            {
+                uploaded = so_far;
+            }
+        });
+
+        auto request = scoped.server()->next_request();
+        auto response = client.request(msg);
+        auto p_request = request.get();
+        VERIFY_ARE_EQUAL(length, p_request->m_body.size());
+        bool intact = true;
+        for (size_t i = 0; i < p_request->m_body.size(); ++i)
+        {
+            intact = intact && p_request->m_body[i] == static_cast<unsigned char>('a' + i % 26);
+        }
+        VERIFY_IS_TRUE(intact);
+        p_request->reply(status_codes::OK);
+        http_asserts::assert_response_equals(response.get(), status_codes::OK);
+
+        VERIFY_ARE_EQUAL(length, uploaded);
+        VERIFY_ARE_EQUAL(26 * repetitions, static_cast<size_t>(stream.seek(0, std::ios_base::cur)));
+        stream.close().get();
+    }
+
     TEST_FIXTURE(uri_address, producer_consumer_buffer_with_content_length)
     {
         streams::producer_consumer_buffer<uint8_t> rbuf;
@@ -236,6 +278,63 @@ SUITE(request_stream_tests)
         http_asserts::assert_response_equals(client.request(msg).get(), status_codes::OK);
     }
 
+    TEST_FIXTURE(uri_address, shared_body_sent_by_many_requests)
+    {
+        std::vector<unsigned char> data(100 * 1024);
+        for (size_t i = 0; i < data.size(); ++i)
+        {
+            data[i] = static_cast<unsigned char>('a' + i % 26);
+        }
+        const auto body = std::make_shared<const std::vector<unsigned char>>(std::move(data));
+
+        http_client_config config;
+        config.set_chunksize(16 * 1024);
+        test_http_server::scoped_server scoped(m_uri);
+        http_client client(m_uri, config);
+
+        // every request reads the shared body at its own position
+        const size_t count = 4;
+        auto requests = scoped.server()->next_requests(count);
+        std::vector<pplx::task<http_response>> responses;
+        for (size_t i = 0; i < count; ++i)
+        {
+            http_request msg(methods::PUT);
+            msg.set_body(body);
+            responses.push_back(client.request(msg));
+        }
+        for (auto& request : requests)
+        {
+            auto p_request = request.get();
+            VERIFY_ARE_EQUAL(U("application/octet-stream"), p_request->m_headers[header_names::content_type]);
+            VERIFY_IS_TRUE(*body == p_request->m_body);
+            p_request->reply(status_codes::OK);
+        }
+        for (auto& response : responses)
+        {
+            http_asserts::assert_response_equals(response.get(), status_codes::OK);
+        }
+    }
+
+    TEST(shared_body_not_copied)
+    {
+        const auto body = std::make_shared<const std::vector<unsigned char>>(26, static_cast<unsigned char>('a'));
+        {
+            http_request msg(methods::POST);
+            msg.set_body(body);
+            VERIFY_ARE_EQUAL(26u, msg.headers().content_length());
+
+            auto rbuf = msg.body().streambuf();
+            uint8_t* data = nullptr;
+            size_t count = 0;
+            VERIFY_IS_TRUE(rbuf.acquire(data, count));
+            VERIFY_IS_TRUE(body->data() == data);
+            VERIFY_ARE_EQUAL(26u, count);
+            rbuf.release(data, 0);
+            VERIFY_ARE_EQUAL(2, body.use_count());
+        }
+        VERIFY_ARE_EQUAL(1, body.use_count());
+    }
+
     TEST_FIXTURE(uri_address, stream_partial_from_start)
     {
         utility::string_t fname = U("stream_partial_from_start.txt");
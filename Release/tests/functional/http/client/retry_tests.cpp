@@ -0,0 +1,164 @@
+/***
+ * Copyright (C) Microsoft. All rights reserved.
+ * Licensed under the MIT license. See LICENSE.txt file in the project root for full license information.
+ *
+ * =+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+ *
+ * retry_tests.cpp
+ *
+ * Tests cases for the retry and hedging policy of http_client.
+ *
+ * =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+ ****/
+
+#include "stdafx.h"
+
+using namespace web::http;
+using namespace web::http::client;
+
+using namespace tests::functional::http::utilities;
+
+namespace tests
+{
+namespace functional
+{
+namespace http
+{
+namespace client
+{
+SUITE(retry_tests)
+{
+    static http_client_config retry_config(size_t max_attempts)
+    {
+        retry_policy policy;
+        policy.set_max_attempts(max_attempts);
+        policy.set_backoff(std::chrono::milliseconds(1), std::chrono::milliseconds(10));
+
+        http_client_config config;
+        config.set_retry_policy(policy);
+        return config;
+    }
+
+    // Retries arrive without waiting for the test, so every expected request must be awaited up front
+    static void reply_all(std::vector<pplx::task<test_request*>> requests,
+                          const method& mtd,
+                          const utility::string_t& path,
+                          const utility::string_t& body,
+                          std::vector<status_code> codes)
+    {
+        for (size_t i = 0; i < codes.size(); ++i)
+        {
+            auto p_request = requests[i].get();
+            if (body.empty())
+            {
+                http_asserts::assert_test_request_equals(p_request, mtd, path);
+            }
+            else
+            {
+                http_asserts::assert_test_request_equals(p_request, mtd, path, U("text/plain; charset=utf-8"), body);
+            }
+            p_request->reply(codes[i]);
+        }
+    }
+
+    TEST_FIXTURE(uri_address, retries_replay_body)
+    {
+        test_http_server::scoped_server scoped(m_uri);
+        http_client client(m_uri, retry_config(3));
+
+        const utility::string_t body = U("replayed body");
+        auto requests = scoped.server()->next_requests(3);
+        auto response = client.request(methods::PUT, U("/retry"), body);
+        reply_all(requests,
+                  methods::PUT,
+                  U("/retry"),
+                  body,
+                  {status_codes::ServiceUnavailable, status_codes::ServiceUnavailable, status_codes::OK});
+
+        VERIFY_ARE_EQUAL(status_codes::OK, response.get().status_code());
+    }
+
+    TEST_FIXTURE(uri_address, retries_exhausted)
+    {
+        test_http_server::scoped_server scoped(m_uri);
+        http_client client(m_uri, retry_config(2));
+
+        auto requests = scoped.server()->next_requests(2);
+        auto response = client.request(methods::GET);
+        reply_all(requests, methods::GET, U("/"), U(""), {status_codes::BadGateway, status_codes::BadGateway});
+
+        VERIFY_ARE_EQUAL(status_codes::BadGateway, response.get().status_code());
+    }
+
+    TEST_FIXTURE(uri_address, non_idempotent_not_retried)
+    {
+        test_http_server::scoped_server scoped(m_uri);
+        http_client client(m_uri, retry_config(3));
+
+        auto requests = scoped.server()->next_requests(1);
+        auto response = client.request(methods::POST, U("/"), U("not replayed"));
+        reply_all(requests, methods::POST, U("/"), U("not replayed"), {status_codes::ServiceUnavailable});
+
+        VERIFY_ARE_EQUAL(status_codes::ServiceUnavailable, response.get().status_code());
+    }
+
+    TEST_FIXTURE(uri_address, retry_after_beyond_max_backoff)
+    {
+        test_http_server::scoped_server scoped(m_uri);
+        http_client client(m_uri, retry_config(3));
+
+        auto request = scoped.server()->next_request();
+        auto response = client.request(methods::GET);
+        request.then([](test_request* p_request) {
+            std::map<utility::string_t, utility::string_t> headers;
+            headers[header_names::retry_after] = U("120");
+            p_request->reply(status_codes::TooManyRequests, U(""), headers);
+        });
+
+        VERIFY_ARE_EQUAL(status_codes::TooManyRequests, response.get().status_code());
+    }
+
+    TEST_FIXTURE(uri_address, retry_budget_exhausted)
+    {
+        test_http_server::scoped_server scoped(m_uri);
+        auto config = retry_config(3);
+        auto policy = config.retry_policy();
+        policy.set_retry_budget(0.0, 0);
+        config.set_retry_policy(policy);
+        http_client client(m_uri, config);
+
+        auto requests = scoped.server()->next_requests(1);
+        auto response = client.request(methods::GET);
+        reply_all(requests, methods::GET, U("/"), U(""), {status_codes::ServiceUnavailable});
+
+        VERIFY_ARE_EQUAL(status_codes::ServiceUnavailable, response.get().status_code());
+    }
+
+    TEST_FIXTURE(uri_address, hedged_request_first_response_wins)
+    {
+        test_http_server::scoped_server scoped(m_uri);
+
+        retry_policy policy;
+        policy.set_hedging(true, std::chrono::milliseconds(10));
+        http_client_config config;
+        config.set_retry_policy(policy);
+        http_client client(m_uri, config);
+
+        // Leave the first attempt unanswered, so that the hedged attempt is sent and wins
+        auto requests = scoped.server()->next_requests(2);
+        auto response = client.request(methods::GET, U("/hedged"));
+        http_asserts::assert_test_request_equals(requests[0].get(), methods::GET, U("/hedged"));
+        auto p_hedged = requests[1].get();
+        http_asserts::assert_test_request_equals(p_hedged, methods::GET, U("/hedged"));
+        p_hedged->reply(status_codes::OK, U("OK"), std::map<utility::string_t, utility::string_t>(), "hedged");
+
+        auto result = response.get();
+        VERIFY_ARE_EQUAL(status_codes::OK, result.status_code());
+        VERIFY_ARE_EQUAL(U("hedged"), result.extract_string(true).get());
+    }
+} // SUITE(retry_tests)
+
+} // namespace client
+} // namespace http
+} // namespace functional
+} // namespace tests
@@ -0,0 +1,104 @@
+#include "stdafx.h"
+
+#include "../../../src/http/common/timer_wheel.h"
+
+using namespace web::http::details;
+
+SUITE(timer_wheel_tests)
+{
+    typedef std::shared_ptr<timer_wheel::entry> entry_ptr;
+
+    static entry_ptr make_entry(std::vector<int>& fired, int id)
+    {
+        return std::make_shared<timer_wheel::entry>([&fired, id]() { fired.push_back(id); });
+    }
+
+    // advances one tick at a time, firing the expired entries, and returns the tick the last one fired at
+    static uint64_t run_until_empty(timer_wheel & wheel)
+    {
+        uint64_t last = 0;
+        while (wheel.size() != 0)
+        {
+            std::vector<entry_ptr> expired;
+            wheel.advance(wheel.now() + 1, expired);
+            for (auto& e : expired)
+            {
+                VERIFY_IS_TRUE(e->deadline() <= wheel.now());
+                e->fire();
+                last = wheel.now();
+            }
+        }
+        return last;
+    }
+
+    TEST(entries_fire_at_their_deadlines)
+    {
+        const uint64_t deadlines[] = {1, 63, 64, 65, 4095, 4096, 70000, 300000};
+        for (auto deadline : deadlines)
+        {
+            timer_wheel wheel(7);
+            std::vector<int> fired;
+            wheel.schedule(make_entry(fired, 0), 7 + deadline);
+            VERIFY_ARE_EQUAL(7 + deadline, run_until_empty(wheel));
+            VERIFY_ARE_EQUAL(1u, fired.size());
+        }
+    }
+
+    TEST(entries_fire_in_order)
+    {
+        timer_wheel wheel;
+        std::vector<int> fired;
+        std::vector<entry_ptr> entries;
+        for (int i = 0; i < 200; ++i)
+        {
+            entries.push_back(make_entry(fired, i));
+            wheel.schedule(entries.back(), static_cast<uint64_t>(1 + i * 37));
+        }
+
+        run_until_empty(wheel);
+        VERIFY_ARE_EQUAL(200u, fired.size());
+        for (int i = 0; i < 200; ++i)
+        {
+            VERIFY_ARE_EQUAL(i, fired[i]);
+        }
+    }
+
+    TEST(canceled_entries_do_not_fire)
+    {
+        timer_wheel wheel;
+        std::vector<int> fired;
+        auto canceled = make_entry(fired, 1);
+        wheel.schedule(canceled, 10);
+        wheel.schedule(make_entry(fired, 2), 5000);
+        VERIFY_ARE_EQUAL(2u, wheel.size());
+        VERIFY_IS_TRUE(wheel.cancel(*canceled));
+        VERIFY_IS_FALSE(wheel.cancel(*canceled));
+
+        run_until_empty(wheel);
+        VERIFY_ARE_EQUAL(1u, fired.size());
+        VERIFY_ARE_EQUAL(2, fired[0]);
+    }
+
+    TEST(extended_entries_fire_at_the_new_deadline)
+    {
+        timer_wheel wheel;
+        std::vector<int> fired;
+        auto e = make_entry(fired, 1);
+        wheel.schedule(e, 10);
+        e->extend(5000);
+        VERIFY_ARE_EQUAL(5000u, run_until_empty(wheel));
+        VERIFY_ARE_EQUAL(1u, fired.size());
+    }
+
+    TEST(empty_wheel_jumps_ahead)
+    {
+        timer_wheel wheel;
+        std::vector<entry_ptr> expired;
+        wheel.advance(1000000, expired);
+        VERIFY_ARE_EQUAL(1000000u, wheel.now());
+
+        std::vector<int> fired;
+        wheel.schedule(make_entry(fired, 1), 10);
+        VERIFY_ARE_EQUAL(1000001u, run_until_empty(wheel));
+    }
+}
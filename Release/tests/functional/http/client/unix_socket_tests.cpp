@@ -0,0 +1,141 @@
+/***
+ * Copyright (C) Microsoft. All rights reserved.
+ * Licensed under the MIT license. See LICENSE.txt file in the project root for full license information.
+ *
+ * =+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+ *
+ * unix_socket_tests.cpp
+ *
+ * Tests cases for sending requests to a listener over a Unix domain socket.
+ *
+ * =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+ ****/
+
+#include "stdafx.h"
+
+#include "cpprest/http_listener.h"
+
+// Only the asio client and listener support Unix domain sockets.
+#if !defined(_WIN32)
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace web::http;
+using namespace web::http::client;
+using namespace web::http::experimental::listener;
+
+namespace tests
+{
+namespace functional
+{
+namespace http
+{
+namespace client
+{
+SUITE(unix_socket_tests)
+{
+    utility::string_t socket_path()
+    {
+        return utility::conversions::to_string_t("/tmp/cpprest_test_" + std::to_string(::getpid()) + ".sock");
+    }
+
+    bool socket_exists(const utility::string_t& path)
+    {
+        struct stat status;
+        return ::stat(utility::conversions::to_utf8string(path).c_str(), &status) == 0 && S_ISSOCK(status.st_mode);
+    }
+
+    http_listener make_listener(const utility::string_t& uri)
+    {
+        http_listener_config config;
+        config.set_unix_socket_path(socket_path());
+        http_listener listener(uri, config);
+        listener.support([](http_request request) {
+            request.extract_string().then([request](utility::string_t body) mutable {
+                http_response response(status_codes::OK);
+                response.headers().add(U("X-Path"), request.relative_uri().to_string());
+                response.headers().add(U("X-Host"), request.headers()[header_names::host]);
+                response.set_body(request.method() + U(" ") + body);
+                request.reply(response);
+            });
+        });
+        return listener;
+    }
+
+    http_client_config unix_socket_config()
+    {
+        http_client_config config;
+        config.set_unix_socket_path(socket_path());
+        return config;
+    }
+
+    TEST(requests_over_unix_socket)
+    {
+        auto listener = make_listener(U("http://localhost:34568/service"));
+        listener.open().wait();
+        VERIFY_IS_TRUE(socket_exists(socket_path()));
+
+        http_client client(U("http://localhost/service"), unix_socket_config());
+        auto response = client.request(methods::POST, U("/items"), U("payload")).get();
+        VERIFY_ARE_EQUAL(status_codes::OK, response.status_code());
+        VERIFY_ARE_EQUAL(U("POST payload"), response.extract_string().get());
+        VERIFY_ARE_EQUAL(U("/items"), response.headers()[U("X-Path")]);
+        VERIFY_ARE_EQUAL(U("localhost"), response.headers()[U("X-Host")]);
+
+        listener.close().wait();
+        VERIFY_IS_FALSE(socket_exists(socket_path()));
+    }
+
+    TEST(connection_reused_over_unix_socket)
+    {
+        auto listener = make_listener(U("http://localhost:34568/"));
+        listener.open().wait();
+
+        http_client client(U("http://localhost/"), unix_socket_config());
+        auto first = client.request(methods::GET).get();
+        VERIFY_ARE_EQUAL(U("GET "), first.extract_string().get());
+        VERIFY_IS_FALSE(first.timing().connection_reused);
+
+        auto second = client.request(methods::GET).get();
+        VERIFY_ARE_EQUAL(U("GET "), second.extract_string().get());
+        VERIFY_IS_TRUE(second.timing().connection_reused);
+
+        listener.close().wait();
+    }
+
+    TEST(stale_socket_replaced)
+    {
+        // a socket bound and closed without being removed, as a crashed process leaves it
+        const auto path = utility::conversions::to_utf8string(socket_path());
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        VERIFY_ARE_EQUAL(0, ::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)));
+        ::close(fd);
+        VERIFY_IS_TRUE(socket_exists(socket_path()));
+
+        auto listener = make_listener(U("http://localhost:34568/"));
+        listener.open().wait();
+
+        http_client client(U("http://localhost/"), unix_socket_config());
+        VERIFY_ARE_EQUAL(status_codes::OK, client.request(methods::GET).get().status_code());
+
+        listener.close().wait();
+    }
+
+    TEST(missing_socket_fails)
+    {
+        http_client client(U("http://localhost/"), unix_socket_config());
+        VERIFY_THROWS(client.request(methods::GET).get(), http_exception);
+    }
+} // SUITE(unix_socket_tests)
+
+} // namespace client
+} // namespace http
+} // namespace functional
+} // namespace tests
+#endif
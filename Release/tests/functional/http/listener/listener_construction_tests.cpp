@@ -425,6 +425,74 @@ SUITE(listener_construction_tests)
         }
     }
 
+    TEST_FIXTURE(uri_address, listener_socket_options)
+    {
+        socket_options options;
+        VERIFY_IS_TRUE(options.no_delay());
+        options.set_no_delay(false);
+        options.set_send_buffer_size(64 * 1024);
+        options.set_receive_buffer_size(64 * 1024);
+        options.set_keep_alive(true, std::chrono::seconds(30), std::chrono::seconds(5), 3);
+        options.set_fast_open(true);
+        options.set_type_of_service(0x10);
+
+        http_listener_config config;
+        config.set_socket_options(options);
+        http_listener_config copy(config);
+        VERIFY_ARE_EQUAL(3, copy.socket_options().keep_alive_count());
+
+        http_listener listener(m_uri, copy);
+        listener.support([](http_request request) { request.reply(status_codes::OK); });
+        listener.open().wait();
+
+        test_http_client::scoped_client client(m_uri);
+        test_http_client* p_client = client.client();
+        VERIFY_ARE_EQUAL(0, p_client->request(methods::GET, U("/")));
+        p_client->next_response()
+            .then([](test_response* p_response) {
+                http_asserts::assert_test_response_equals(p_response, status_codes::OK);
+            })
+            .wait();
+
+        listener.close().wait();
+    }
+
+    TEST_FIXTURE(uri_address, listener_multiple_acceptors)
+    {
+        http_listener_config config;
+        VERIFY_ARE_EQUAL(1u, config.acceptors());
+        config.set_acceptors(4);
+        http_listener_config copy(config);
+        VERIFY_ARE_EQUAL(4u, copy.acceptors());
+
+        http_listener listener(m_uri, copy);
+        listener.support([](http_request request) { request.reply(status_codes::OK); });
+        listener.open().wait();
+
+        // a burst of new connections, each accepted by one of the loops
+        std::vector<std::unique_ptr<web::http::client::http_client>> clients;
+        std::vector<pplx::task<http_response>> responses;
+        for (int i = 0; i < 16; ++i)
+        {
+            clients.emplace_back(new web::http::client::http_client(m_uri));
+            responses.push_back(clients.back()->request(methods::GET));
+        }
+        for (auto& response : responses)
+        {
+            VERIFY_ARE_EQUAL(status_codes::OK, response.get().status_code());
+        }
+
+        // the port is free again once the listener is closed
+        clients.clear();
+        listener.close().wait();
+        http_listener reopened(m_uri);
+        reopened.support([](http_request request) { request.reply(status_codes::Accepted); });
+        reopened.open().wait();
+        VERIFY_ARE_EQUAL(status_codes::Accepted,
+                         web::http::client::http_client(m_uri).request(methods::GET).get().status_code());
+        reopened.close().wait();
+    }
+
 #if !defined(_WIN32) && !defined(__cplusplus_winrt) || defined(CPPREST_FORCE_HTTP_LISTENER_ASIO)
 
     TEST_FIXTURE(uri_address, create_https_listener_get, "Ignore", "github 209")
@@ -0,0 +1,306 @@
+#include "stdafx.h"
+
+#include "../../../src/http/listener/http_request_parser.h"
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#if !defined(_WIN32) || defined(CPPREST_FORCE_HTTP_LISTENER_ASIO)
+#include <boost/asio.hpp>
+#endif
+
+using namespace web::http;
+using namespace web::http::details;
+using namespace web::http::experimental::listener;
+using namespace tests::functional::http::listener;
+
+SUITE(request_parser_tests)
+{
+    // Copies what the parser hands over
+    struct recording_handler
+    {
+        bool on_request_line(
+            parsed_method m, const char* name, size_t name_size, const char* target, size_t target_size, int mj, int mn)
+        {
+            method = m;
+            method_name.assign(name, name_size);
+            this->target.assign(target, target_size);
+            major = mj;
+            minor = mn;
+            ++request_lines;
+            return true;
+        }
+
+        bool on_header(const char* name, size_t name_size, const char* value, size_t value_size)
+        {
+            headers.push_back(std::make_pair(std::string(name, name_size), std::string(value, value_size)));
+            return true;
+        }
+
+        parsed_method method {parsed_method::other};
+        std::string method_name;
+        std::string target;
+        int major {0};
+        int minor {0};
+        int request_lines {0};
+        std::vector<std::pair<std::string, std::string>> headers;
+    };
+
+    static http_request_parser::result parse_whole(const std::string& head, recording_handler& handler)
+    {
+        http_request_parser parser;
+        return parser.parse(head.data(), head.size(), handler);
+    }
+
+    TEST(parses_request_line_and_headers)
+    {
+        const std::string head =
+            "GET /path?q=1 HTTP/1.1\r\nHost: localhost\r\nX-Empty:\r\nX-Spaced: \t a b \t\r\n\r\nbody";
+        recording_handler handler;
+        http_request_parser parser;
+        VERIFY_IS_TRUE(http_request_parser::result::complete == parser.parse(head.data(), head.size(), handler));
+        VERIFY_ARE_EQUAL(head.find("body"), parser.consumed());
+
+        VERIFY_IS_TRUE(parsed_method::get == handler.method);
+        VERIFY_ARE_EQUAL("GET", handler.method_name);
+        VERIFY_ARE_EQUAL("/path?q=1", handler.target);
+        VERIFY_ARE_EQUAL(1, handler.major);
+        VERIFY_ARE_EQUAL(1, handler.minor);
+        VERIFY_ARE_EQUAL(3u, handler.headers.size());
+        VERIFY_ARE_EQUAL("Host", handler.headers[0].first);
+        VERIFY_ARE_EQUAL("localhost", handler.headers[0].second);
+        VERIFY_ARE_EQUAL("", handler.headers[1].second);
+        VERIFY_ARE_EQUAL("a b", handler.headers[2].second);
+    }
+
+    TEST(parses_byte_by_byte)
+    {
+        const std::string head = "\r\nPOST / HTTP/1.0\nContent-Length: 4\nAccept : */*\n\n";
+        recording_handler handler;
+        http_request_parser parser;
+        for (size_t size = 0; size < head.size(); ++size)
+        {
+            VERIFY_IS_TRUE(http_request_parser::result::incomplete == parser.parse(head.data(), size, handler));
+        }
+        VERIFY_IS_TRUE(http_request_parser::result::complete == parser.parse(head.data(), head.size(), handler));
+        VERIFY_ARE_EQUAL(head.size(), parser.consumed());
+
+        VERIFY_ARE_EQUAL(1, handler.request_lines);
+        VERIFY_IS_TRUE(parsed_method::post == handler.method);
+        VERIFY_ARE_EQUAL(0, handler.minor);
+        VERIFY_ARE_EQUAL(2u, handler.headers.size());
+        VERIFY_ARE_EQUAL("Accept", handler.headers[1].first);
+        VERIFY_ARE_EQUAL("*/*", handler.headers[1].second);
+    }
+
+    TEST(matches_methods)
+    {
+        const char* names[] = {"GET", "head", "Post", "PUT", "DELETE", "OPTIONS", "TRACE", "CONNECT", "PATCH", "MKCOL"};
+        const parsed_method expected[] = {parsed_method::get,
+                                          parsed_method::head,
+                                          parsed_method::post,
+                                          parsed_method::put,
+                                          parsed_method::del,
+                                          parsed_method::options,
+                                          parsed_method::trace,
+                                          parsed_method::connect,
+                                          parsed_method::patch,
+                                          parsed_method::other};
+        for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i)
+        {
+            VERIFY_IS_TRUE(expected[i] == http_request_parser::match_method(names[i], std::strlen(names[i])));
+        }
+        VERIFY_IS_TRUE(parsed_method::other == http_request_parser::match_method("GETS", 4));
+        VERIFY_IS_TRUE(parsed_method::other == http_request_parser::match_method("GE", 2));
+    }
+
+    TEST(rejects_malformed_heads)
+    {
+        const char* heads[] = {
+            "GET\r\n\r\n",
+            "GET /\r\n\r\n",
+            "GET  / HTTP/1.1\r\n\r\n",
+            "G(T / HTTP/1.1\r\n\r\n",
+            "GET / HTTP/1.1 \r\n\r\n",
+            "GET / HTTP/11\r\n\r\n",
+            "GET / FTP/1.1\r\n\r\n",
+            "GET /a\x01 HTTP/1.1\r\n\r\n",
+            "GET / HTTP/1.1\r\nNo colon\r\n\r\n",
+            "GET / HTTP/1.1\r\n: no name\r\n\r\n",
+            "GET / HTTP/1.1\r\nBad\"Name: value\r\n\r\n",
+            "GET / HTTP/1.1\r\nName: a\x7f\r\n\r\n",
+            "GET / HTTP/1.1\r\nName: value\r\n folded\r\n\r\n",
+        };
+        for (auto head : heads)
+        {
+            recording_handler handler;
+            VERIFY_IS_TRUE(http_request_parser::result::error == parse_whole(head, handler));
+        }
+
+        // the handler refuses what it can't take
+        struct refusing_handler : recording_handler
+        {
+            bool on_header(const char*, size_t, const char*, size_t) { return false; }
+        } refusing;
+        http_request_parser parser;
+        const std::string head = "GET / HTTP/1.1\r\nHost: a\r\n\r\n";
+        VERIFY_IS_TRUE(http_request_parser::result::error == parser.parse(head.data(), head.size(), refusing));
+    }
+
+    TEST(reset_parses_next_request)
+    {
+        const std::string head = "GET /first HTTP/1.1\r\n\r\nDELETE /second HTTP/1.1\r\n\r\n";
+        recording_handler handler;
+        http_request_parser parser;
+        VERIFY_IS_TRUE(http_request_parser::result::complete == parser.parse(head.data(), head.size(), handler));
+        const size_t first = parser.consumed();
+
+        parser.reset();
+        VERIFY_IS_TRUE(http_request_parser::result::complete ==
+                       parser.parse(head.data() + first, head.size() - first, handler));
+        VERIFY_IS_TRUE(parsed_method::del == handler.method);
+        VERIFY_ARE_EQUAL("/second", handler.target);
+    }
+
+    // Mutates valid heads at random, with a fixed seed so that failures reproduce, and checks that the parser
+    // reaches the same verdict and the same parts however the bytes are split between calls
+    TEST(fuzz_split_parsing_agrees)
+    {
+        const std::string seeds[] = {
+            "GET /index.html HTTP/1.1\r\nHost: example.com\r\nAccept: */*\r\n\r\n",
+            "POST /upload?x=%20 HTTP/1.0\nContent-Length: 10\nContent-Type : text/plain\n\n0123456789",
+            "\r\n\r\nOPTIONS * HTTP/1.1\r\nX:\r\nY: \xc3\xa9t\xc3\xa9\r\n\r\n",
+        };
+
+        unsigned int state = 12345;
+        auto next = [&state](unsigned int bound) {
+            state = state * 1103515245u + 12345u;
+            return (state >> 16) % bound;
+        };
+
+        for (int iteration = 0; iteration < 5000; ++iteration)
+        {
+            std::string head = seeds[next(3)];
+            const unsigned int mutations = 1 + next(4);
+            for (unsigned int m = 0; m < mutations && !head.empty(); ++m)
+            {
+                const size_t at = next(static_cast<unsigned int>(head.size()));
+                switch (next(4))
+                {
+                    case 0: head[at] = static_cast<char>(next(256)); break;
+                    case 1: head.insert(at, 1, "\r\n: \t"[next(5)]); break;
+                    case 2: head.erase(at, 1); break;
+                    default: head.resize(at); break;
+                }
+            }
+
+            recording_handler whole;
+            const auto expected = parse_whole(head, whole);
+
+            recording_handler split;
+            http_request_parser parser;
+            auto result = http_request_parser::result::incomplete;
+            size_t size = 0;
+            while (result == http_request_parser::result::incomplete && size < head.size())
+            {
+                size = (std::min)(head.size(), size + 1 + next(8));
+                result = parser.parse(head.data(), size, split);
+            }
+
+            VERIFY_IS_TRUE(expected == result);
+            VERIFY_ARE_EQUAL(whole.request_lines, split.request_lines);
+            VERIFY_ARE_EQUAL(whole.target, split.target);
+            VERIFY_ARE_EQUAL(whole.headers.size(), split.headers.size());
+        }
+    }
+
+#if !defined(_WIN32) || defined(CPPREST_FORCE_HTTP_LISTENER_ASIO)
+    // Writes a request to the listener in small pieces over a plain socket and returns the status line of the reply
+    static std::string send_raw(const web::uri& uri, const std::string& request)
+    {
+        boost::asio::io_service service;
+        boost::asio::ip::tcp::resolver resolver(service);
+        boost::asio::ip::tcp::socket socket(service);
+        boost::asio::connect(
+            socket,
+            resolver.resolve(boost::asio::ip::tcp::resolver::query(
+                utility::conversions::to_utf8string(uri.host()), std::to_string(uri.port()))));
+        for (size_t sent = 0; sent < request.size(); sent += 5)
+        {
+            const size_t size = (std::min)(request.size() - sent, static_cast<size_t>(5));
+            boost::asio::write(socket, boost::asio::buffer(request.data() + sent, size));
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        boost::asio::streambuf reply;
+        boost::asio::read_until(socket, reply, "\r\n");
+        std::istream stream(&reply);
+        std::string status_line;
+        std::getline(stream, status_line);
+        return status_line;
+    }
+
+    TEST_FIXTURE(uri_address, listener_parses_split_request)
+    {
+        http_listener listener(m_uri);
+        listener.support([](http_request request) {
+            const bool expected = request.method() == methods::PATCH &&
+                                  request.relative_uri().to_string() == U("/parsed?a=b") &&
+                                  request.headers().content_type() == U("text/plain") &&
+                                  request.headers().content_length() == 5 &&
+                                  request.extract_utf8string(true).get() == "hello";
+            request.reply(expected ? status_codes::OK : status_codes::Conflict);
+        });
+        listener.open().wait();
+
+        const std::string request = "patch /parsed?a=b HTTP/1.1\nContent-Type:text/plain \nContent-Length: 5\n"
+                                    "Connection: close\n\nhello";
+        VERIFY_ARE_EQUAL("HTTP/1.1 200 OK\r", send_raw(m_uri, request));
+        VERIFY_ARE_EQUAL("HTTP/1.1 400 Bad Request\r",
+                         send_raw(m_uri, "GET / HTTP/1.1\r\nBad Name: value\r\n\r\n"));
+
+        listener.close().wait();
+    }
+#endif
+
+    // Measures requests per second over loopback with a few keep-alive connections
+    TEST_FIXTURE(uri_address, loopback_requests_per_second, "Ignore", "Manual")
+    {
+        http_listener listener(m_uri);
+        listener.support([](http_request request) { request.reply(status_codes::OK); });
+        listener.open().wait();
+
+        const int connections = 8;
+        const int requests = 20000;
+        std::vector<std::unique_ptr<web::http::client::http_client>> clients;
+        for (int i = 0; i < connections; ++i)
+        {
+            clients.emplace_back(new web::http::client::http_client(m_uri));
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<pplx::task<void>> loops;
+        for (auto& client : clients)
+        {
+            auto c = client.get();
+            loops.push_back(pplx::create_task([c] {
+                for (int i = 0; i < requests / connections; ++i)
+                {
+                    http_request request(methods::GET);
+                    request.headers().add(U("X-Benchmark"), U("1"));
+                    request.headers().add(U("Accept"), U("*/*"));
+                    c->request(request).get();
+                }
+            }));
+        }
+        pplx::when_all(loops.begin(), loops.end()).wait();
+        const auto elapsed =
+            std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - start);
+
+        printf("%d requests over %d connections: %.0f requests per second\n",
+               requests,
+               connections,
+               requests / elapsed.count());
+        listener.close().wait();
+    }
+}
@@ -167,6 +167,47 @@ SUITE(requests_tests)
         listener.close().wait();
     }
 
+    TEST_FIXTURE(uri_address, expect_continue_answered)
+    {
+        http_listener listener(m_uri);
+        listener.open().wait();
+        listener.support([](http_request request) {
+            auto body = request.extract_utf8string().get();
+            request.reply(body == "expected body" ? status_codes::OK : status_codes::BadRequest);
+        });
+
+        client::http_client_config config;
+        config.set_expect_continue(true, std::chrono::seconds(30));
+        client::http_client client(m_uri, config);
+
+        const auto start = std::chrono::steady_clock::now();
+        VERIFY_ARE_EQUAL(status_codes::OK, client.request(methods::PUT, U(""), "expected body").get().status_code());
+        VERIFY_IS_TRUE(std::chrono::steady_clock::now() - start < std::chrono::seconds(10));
+
+        listener.close().wait();
+    }
+
+    TEST_FIXTURE(uri_address, head_response_without_body)
+    {
+        http_listener listener(m_uri);
+        listener.open().wait();
+        listener.support([](http_request request) {
+            http_response response(status_codes::OK);
+            response.headers().set_content_length(1024);
+            request.reply(response);
+        });
+
+        client::http_client client(m_uri);
+        auto response = client.request(methods::HEAD).get();
+        VERIFY_ARE_EQUAL(status_codes::OK, response.status_code());
+        VERIFY_ARE_EQUAL(1024u, response.headers().content_length());
+
+        // the connection is still usable after the bodiless response
+        VERIFY_ARE_EQUAL(status_codes::OK, client.request(methods::HEAD).get().status_code());
+
+        listener.close().wait();
+    }
+
     TEST_FIXTURE(uri_address, response_order)
     {
         http_listener listener(m_uri);
@@ -119,6 +119,42 @@ SUITE(response_stream_tests)
         stream.close().get();
     }
 
+    TEST_FIXTURE(uri_address, set_body_stream_larger_than_socket_buffers)
+    {
+        utility::string_t fname = U("set_response_stream_larger_than_socket_buffers.txt");
+        fill_file(fname, 100000);
+
+        http_listener listener(m_uri);
+        listener.open().wait();
+        test_http_client::scoped_client client(m_uri);
+        test_http_client* p_client = client.client();
+
+        // Start past the first repetition, so the body does not begin at the start of the file.
+        http_response response(status_codes::OK);
+        auto stream = streams::file_stream<uint8_t>::open_istream(fname).get();
+        response.set_body(stream);
+        auto length = stream.seek(0, std::ios_base::end);
+        stream.seek(26);
+        response.headers().set_content_length((size_t)length - 26);
+
+        listener.support([&](http_request request) { request.reply(response).wait(); });
+        VERIFY_ARE_EQUAL(0u, p_client->request(methods::GET, U("")));
+        p_client->next_response()
+            .then([&](test_response* p_response) {
+                http_asserts::assert_test_response_equals(p_response, status_codes::OK);
+                VERIFY_ARE_EQUAL((size_t)length - 26, p_response->m_data.size());
+                bool intact = true;
+                for (size_t i = 0; i < p_response->m_data.size(); ++i)
+                {
+                    intact = intact && p_response->m_data[i] == static_cast<unsigned char>('a' + i % 26);
+                }
+                VERIFY_IS_TRUE(intact);
+            })
+            .wait();
+
+        stream.close().get();
+    }
+
     TEST_FIXTURE(uri_address, set_body_stream_partial)
     {
         utility::string_t fname = U("set_response_stream_partial.txt");
@@ -0,0 +1,132 @@
+#include "stdafx.h"
+
+#include "../../../src/http/listener/route_tree.h"
+
+using namespace web::http;
+using namespace web::http::details;
+using namespace web::http::experimental::listener;
+using namespace tests::functional::http::listener;
+
+SUITE(route_tree_tests)
+{
+    typedef route_tree<int> int_routes;
+
+    // Looks up the path, returning the value found or -1, and the captures as "name=segment" strings
+    static int find(const int_routes& routes, const std::string& path, std::vector<std::string>& captures)
+    {
+        size_t matched = 0;
+        std::vector<int_routes::capture> found_captures;
+        const int* found = routes.find(path, matched, found_captures);
+        captures.clear();
+        for (const auto& capture : found_captures)
+        {
+            captures.push_back(*capture.m_name + "=" + path.substr(capture.m_begin, capture.m_size));
+        }
+        return found == nullptr ? -1 : *found;
+    }
+
+    static int find(const int_routes& routes, const std::string& path)
+    {
+        std::vector<std::string> captures;
+        return find(routes, path, captures);
+    }
+
+    TEST(longest_prefix_of_whole_segments)
+    {
+        int_routes routes;
+        VERIFY_IS_TRUE(routes.insert("/a/b/c/", 3));
+        VERIFY_IS_TRUE(routes.insert("/a/", 1));
+        VERIFY_IS_TRUE(routes.insert("/a/b/", 2));
+        VERIFY_IS_TRUE(routes.insert("/a/x/", 4));
+
+        VERIFY_ARE_EQUAL(-1, find(routes, "/"));
+        VERIFY_ARE_EQUAL(1, find(routes, "/a"));
+        VERIFY_ARE_EQUAL(1, find(routes, "/a/bc"));
+        VERIFY_ARE_EQUAL(2, find(routes, "/a/b"));
+        VERIFY_ARE_EQUAL(2, find(routes, "/a/b/cd/e"));
+        VERIFY_ARE_EQUAL(3, find(routes, "/a/b/c/d"));
+        VERIFY_ARE_EQUAL(3, find(routes, "//a//b/c"));
+        VERIFY_ARE_EQUAL(4, find(routes, "/a/x/"));
+
+        // the root matches everything else
+        VERIFY_IS_TRUE(routes.insert("/", 0));
+        VERIFY_ARE_EQUAL(0, find(routes, ""));
+        VERIFY_ARE_EQUAL(0, find(routes, "/b/a"));
+    }
+
+    TEST(duplicate_paths)
+    {
+        int_routes routes;
+        VERIFY_IS_TRUE(routes.insert("/a/b/", 1));
+        VERIFY_IS_FALSE(routes.insert("/a//b", 2));
+        VERIFY_ARE_EQUAL(1, find(routes, "/a/b"));
+    }
+
+    TEST(templated_segments)
+    {
+        int_routes routes;
+        VERIFY_IS_TRUE(routes.insert("/users/{id}/", 1));
+        VERIFY_IS_TRUE(routes.insert("/users/me/", 2));
+        VERIFY_IS_TRUE(routes.insert("/users/{id}/posts/{post}/", 3));
+
+        std::vector<std::string> captures;
+        VERIFY_ARE_EQUAL(1, find(routes, "/users/42", captures));
+        VERIFY_ARE_EQUAL(1u, captures.size());
+        VERIFY_ARE_EQUAL("id=42", captures[0]);
+
+        VERIFY_ARE_EQUAL(2, find(routes, "/users/me/photos", captures));
+        VERIFY_IS_TRUE(captures.empty());
+
+        // the longer templated path wins over the static segment
+        VERIFY_ARE_EQUAL(3, find(routes, "/users/me/posts/7/comments", captures));
+        VERIFY_ARE_EQUAL(2u, captures.size());
+        VERIFY_ARE_EQUAL("id=me", captures[0]);
+        VERIFY_ARE_EQUAL("post=7", captures[1]);
+
+        VERIFY_ARE_EQUAL(1, find(routes, "/users/42/posts", captures));
+        VERIFY_ARE_EQUAL(-1, find(routes, "/users", captures));
+
+        VERIFY_THROWS(routes.insert("/users/{name}/", 4), std::invalid_argument);
+    }
+
+    TEST(matched_length)
+    {
+        int_routes routes;
+        routes.insert("/a/{b}/", 1);
+        size_t matched = 0;
+        std::vector<int_routes::capture> captures;
+        const std::string path = "/a/x/y";
+        VERIFY_IS_TRUE(routes.find(path, matched, captures) != nullptr);
+        VERIFY_ARE_EQUAL("/a/x", path.substr(0, matched));
+    }
+
+#if !defined(_WIN32) || defined(CPPREST_FORCE_HTTP_LISTENER_ASIO)
+    TEST_FIXTURE(uri_address, listener_path_parameters)
+    {
+        http_listener user(web::uri_builder(m_uri).append_path(U("users/{id}"), true).to_uri());
+        user.support([](http_request request) {
+            const auto& parameters = request.path_parameters();
+            const bool expected = parameters.size() == 1 && parameters.at(U("id")) == U("42") &&
+                                  request.relative_uri().to_string() == U("/photos?size=2");
+            request.reply(expected ? status_codes::OK : status_codes::Conflict);
+        });
+        http_listener me(web::uri_builder(m_uri).append_path(U("users/me")).to_uri());
+        me.support([](http_request request) {
+            request.reply(request.path_parameters().empty() ? status_codes::Accepted : status_codes::Conflict);
+        });
+        user.open().wait();
+        me.open().wait();
+
+        web::http::client::http_client client(m_uri);
+        VERIFY_ARE_EQUAL(status_codes::OK,
+                         client.request(methods::GET, U("/users/42/photos?size=2")).get().status_code());
+        VERIFY_ARE_EQUAL(status_codes::Accepted, client.request(methods::GET, U("/users/me")).get().status_code());
+        VERIFY_ARE_EQUAL(status_codes::NotFound, client.request(methods::GET, U("/users")).get().status_code());
+
+        // the routes follow listeners closing
+        me.close().wait();
+        VERIFY_ARE_EQUAL(status_codes::Conflict, client.request(methods::GET, U("/users/me")).get().status_code());
+        user.close().wait();
+    }
+#endif
+}